@@ -0,0 +1,663 @@
+// 无窗口测速程序：图形画在 HeapSurface 上，不创建窗口，也不依赖 GDI
+// 用法：Bench [用例名 ...]，不带参数时依次运行全部用例
+// Windows 下用 Bench.vcxproj 编译（Release）；Linux 下在本目录执行：
+//   g++ -std=c++14 -O2 -pthread -I../Project2 *.cpp ../Project2/{PixelSurface,DrawingPrimitives,Fill,
+//       Shapes,SpanFill,EdgeTable,SceneRender,CommandBuffer,ShapeStore,WorkerPool,DamageRegion,
+//       Clip,LineClip,ShapeIndex,PolygonBoolean}.cpp -o bench
+
+#include "PixelSurface.h"
+#include "DrawingPrimitives.h"
+#include "Clip.h"
+#include "CommandBuffer.h"
+#include "LineClip.h"
+#include "ShapeStore.h"
+#include "SceneRender.h"
+#include "Shapes.h"
+#include "WorkerPool.h"
+#include "Legacy.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace GraphicsEngine;
+
+// 堆分配计数：替换全局 operator new / delete，测速用例据此统计一次调用的分配次数
+static std::atomic<size_t> g_allocations{ 0 };
+
+// 分配与释放各经过一个不内联的函数：GCC 看不到 new 与 free 配对，不再报 -Wmismatched-new-delete
+#ifdef _MSC_VER
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+BENCH_NOINLINE static void* CountedAlloc(size_t n) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+BENCH_NOINLINE static void CountedFree(void* p) noexcept { std::free(p); }
+
+void* operator new(size_t n) { return CountedAlloc(n); }
+void* operator new[](size_t n) { return CountedAlloc(n); }
+void operator delete(void* p) noexcept { CountedFree(p); }
+void operator delete(void* p, size_t) noexcept { CountedFree(p); }
+void operator delete[](void* p) noexcept { CountedFree(p); }
+void operator delete[](void* p, size_t) noexcept { CountedFree(p); }
+
+// 图形表（裁剪等按整张图形表操作的函数使用）
+namespace GraphicsEngine {
+std::vector<Shape> g_shapes;
+ShapeIndex g_shapeIndex;
+}
+
+namespace {
+
+double NowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+// 反复运行 fn，累计超过 minMs 后返回平均每次的毫秒数
+double TimeMs(const std::function<void()>& fn, double minMs = 300) {
+    fn();   // 预热
+    int runs = 0;
+    double start = NowMs(), elapsed = 0;
+    do {
+        fn();
+        ++runs;
+        elapsed = NowMs() - start;
+    } while (elapsed < minMs);
+    return elapsed / runs;
+}
+
+// ----- 直线：逐像素中点法、Bresenham 与 run-slice 的像素吞吐 -----
+struct LineSeg {
+    int x1, y1, x2, y2;
+};
+
+void BenchLines() {
+    const int size = 1024, count = 2000;
+    HeapSurface hs;
+    CreateHeapSurface(hs, size, size);
+    std::mt19937 rng(1);
+
+    struct LineSet {
+        const char* name;
+        std::vector<LineSeg> lines;
+        long long pixels;
+    };
+    LineSet sets[3] = { { "shallow", {}, 0 }, { "steep", {}, 0 }, { "diagonal", {}, 0 } };
+    for (int i = 0; i < count; ++i) {
+        int a = (int)(rng() % 900), b = (int)(rng() % 900), k = 10 + (int)(rng() % 40);
+        sets[0].lines.push_back({ 0, a, size - 1, a + k });         // 斜率 < 1/20
+        sets[1].lines.push_back({ a, 0, a + k, size - 1 });
+        sets[2].lines.push_back({ 0, b % 100, 900, b % 100 + 900 });
+    }
+    for (auto& set : sets)
+        for (auto& l : set.lines)
+            set.pixels += (std::max)(std::abs(l.x2 - l.x1), std::abs(l.y2 - l.y1)) + 1;
+
+    typedef void (*LineFn)(PixelSurface&, int, int, int, int, COLORREF);
+    struct Algo {
+        const char* name;
+        LineFn fn;
+    };
+    const Algo algos[] = { { "midpoint", DrawLineMidpoint }, { "bresenham", DrawLineBresenham },
+        { "run-slice", DrawLineRunSlice } };
+
+    printf("lines: %d lines per set on %dx%d, Mpixels/s\n", count, size, size);
+    printf("  %-10s %12s %12s %12s\n", "set", algos[0].name, algos[1].name, algos[2].name);
+    for (auto& set : sets) {
+        printf("  %-10s", set.name);
+        for (auto& algo : algos) {
+            double ms = TimeMs([&] {
+                for (auto& l : set.lines)
+                    algo.fn(hs.surface, l.x1, l.y1, l.x2, l.y2, RGB(255, 255, 255));
+            });
+            printf(" %12.1f", set.pixels / ms / 1000.0);
+        }
+        printf("\n");
+    }
+}
+
+// 每次运行前 setup（不计时）再计时 fn，取 runs 次中最快的一次
+double TimeBestMs(const std::function<void()>& setup, const std::function<void()>& fn, int runs = 3) {
+    double best = 0;
+    for (int r = 0; r < runs; ++r) {
+        setup();
+        double start = NowMs();
+        fn();
+        double ms = NowMs() - start;
+        if (r == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+// ----- 场景：随机混合图形（直线、矩形、圆、多边形、B 样条，部分带填充） -----
+std::vector<Shape> MakeMixedScene(int count, int size, unsigned seed) {
+    std::mt19937 rng(seed);
+    auto coord = [&] { return (int)(rng() % size); };
+    auto near = [&](int c, int r) { return c + (int)(rng() % (2 * r + 1)) - r; };
+    const DrawMode lines[3] = { DrawMode::DrawLineMidpoint, DrawMode::DrawLineBresenham, DrawMode::DrawLineRunSlice };
+    std::vector<Shape> shapes(count);
+    for (int i = 0; i < count; ++i) {
+        Shape& s = shapes[i];
+        s.color = RGB(rng() % 256, rng() % 256, rng() % 256);
+        s.fillColor = RGB(rng() % 256, rng() % 256, rng() % 256);
+        s.fillMode = 0;
+        int cx = coord(), cy = coord();
+        switch (rng() % 5) {
+        case 0:
+            s.type = lines[rng() % 3];
+            s.vertices.push_back({ cx, cy });
+            s.vertices.push_back({ near(cx, 120), near(cy, 120) });
+            break;
+        case 1:
+            s.type = DrawMode::DrawRectangle;
+            s.vertices.push_back({ cx, cy });
+            s.vertices.push_back({ near(cx, 40), near(cy, 40) });
+            s.fillMode = (int)(rng() % 3);
+            break;
+        case 2:
+            s.type = rng() % 2 ? DrawMode::DrawCircleMidpoint : DrawMode::DrawCircleBresenham;
+            s.vertices.push_back({ cx, cy });
+            s.vertices.push_back({ cx + (int)(rng() % 30), cy });
+            s.fillMode = (int)(rng() % 3);
+            break;
+        case 3:
+            s.type = DrawMode::DrawPolygon;
+            for (int k = 3 + (int)(rng() % 6); k > 0; --k)
+                s.vertices.push_back({ near(cx, 40), near(cy, 40) });
+            s.fillMode = (int)(rng() % 3);
+            break;
+        default:
+            s.type = DrawMode::DrawBSpline;
+            for (int k = 4 + (int)(rng() % 4); k > 0; --k)
+                s.vertices.push_back({ near(cx, 60), near(cy, 60) });
+            break;
+        }
+        TouchShape(s);
+    }
+    return shapes;
+}
+
+// ----- 分块并行绘制：RenderShapesTiled 随线程数的加速比 -----
+void BenchTiled() {
+    const int size = 2048, count = 50000;
+    std::vector<Shape> shapes = MakeMixedScene(count, size, 3);
+    HeapSurface hs;
+    CreateHeapSurface(hs, size, size);
+
+    double serial = TimeMs([&] {
+        ClearSurface(hs.surface, RGB(255, 255, 255));
+        RenderShapes(hs.surface, shapes);
+    });
+    std::vector<uint32_t> expect = hs.pixels;
+    int cores = WorkerThreadCount();
+    printf("tiled: %d mixed shapes on %dx%d, %d core(s)\n", count, size, size, cores);
+    printf("  %-10s %10.2f ms\n", "serial", serial);
+    for (int n = 1; n <= cores; n = n < cores && n * 2 > cores ? cores : n * 2) {
+        SetWorkerThreadLimit(n);
+        double ms = TimeMs([&] {
+            ClearSurface(hs.surface, RGB(255, 255, 255));
+            RenderShapesTiled(hs.surface, shapes);
+        });
+        printf("  %2d thread%s %10.2f ms  x%.2f%s\n", n, n > 1 ? "s" : " ", ms, serial / ms,
+            hs.pixels == expect ? "" : "  (pixels differ from serial!)");
+        if (n == cores) break;
+    }
+    SetWorkerThreadLimit(0);
+}
+
+// ----- 命令缓冲：重放 vs 每帧按 DrawMode 分派 -----
+void BenchReplay() {
+    const int size = 2048, count = 50000;
+    std::vector<Shape> shapes = MakeMixedScene(count, size, 5);
+    HeapSurface hs;
+    CreateHeapSurface(hs, size, size);
+
+    double dispatch = TimeMs([&] {
+        ClearSurface(hs.surface, RGB(255, 255, 255));
+        RenderShapes(hs.surface, shapes);
+    });
+    std::vector<uint32_t> expect = hs.pixels;
+
+    ShapeStore store;
+    BuildShapeStore(store, shapes);
+    CommandBuffer cb;
+    double start = NowMs();
+    UpdateCommandBuffer(cb, store);
+    double compile = NowMs() - start;
+    double update = TimeMs([&] { UpdateCommandBuffer(cb, store); });
+    double replay = TimeMs([&] {
+        ClearSurface(hs.surface, RGB(255, 255, 255));
+        ReplayCommands(hs.surface, cb);
+    });
+    bool same = hs.pixels == expect;
+
+    // 改动 1% 的图形后增量更新：一半平移（复用光栅缓存），一半改颜色
+    for (int i = 0; i < count; i += 100) {
+        Shape& s = shapes[i];
+        if (i % 200 == 0) {
+            for (auto& p : s.vertices) { p.x += 3; p.y += 2; }
+            TouchShapeTranslated(s, 3, 2);
+        }
+        else {
+            s.color ^= 0xFFFFFF;
+            TouchShape(s);
+        }
+    }
+    BuildShapeStore(store, shapes);
+    start = NowMs();
+    UpdateCommandBuffer(cb, store);
+    double incremental = NowMs() - start;
+
+    printf("replay: %d mixed shapes on %dx%d\n", count, size, size);
+    printf("  %-28s %10.2f ms\n", "dispatch (RenderShapes)", dispatch);
+    printf("  %-28s %10.2f ms%s\n", "replay (ReplayCommands)", replay, same ? "" : "  (pixels differ!)");
+    printf("  %-28s %10.2f ms\n", "first compile", compile);
+    printf("  %-28s %10.2f ms\n", "update, nothing changed", update);
+    printf("  %-28s %10.2f ms  (%d compiled, %d rasterized)\n", "update, 1% changed", incremental,
+        cb.compiledLastUpdate, cb.rasterizedLastUpdate);
+}
+
+// ----- 图形表：ShapeStore（结构数组）vs std::vector<Shape> 的内存与遍历 -----
+template <class T>
+size_t VectorBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// 各容器实际申请的字节数与堆块数（不计分配器自身的开销）
+struct HeapUsage {
+    size_t bytes = 0;
+    size_t blocks = 0;
+};
+
+template <class T>
+void AddVector(HeapUsage& u, const std::vector<T>& v) {
+    u.bytes += VectorBytes(v);
+    u.blocks += v.capacity() != 0;
+}
+
+void AddPointList(HeapUsage& u, const PointList& v) {
+    if (v.heapCapacity == 0) return;
+    u.bytes += v.heapCapacity * sizeof(Point);
+    u.blocks++;
+}
+
+HeapUsage BaselineListUsage(const std::vector<Legacy::BaselineShape>& shapes) {
+    HeapUsage u;
+    AddVector(u, shapes);
+    for (const auto& s : shapes) AddVector(u, s.vertices);
+    return u;
+}
+
+HeapUsage ShapeListUsage(const std::vector<Shape>& shapes) {
+    HeapUsage u;
+    AddVector(u, shapes);
+    for (const Shape& s : shapes) {
+        AddPointList(u, s.vertices);
+        if (!s.extra) continue;
+        u.bytes += sizeof(ShapeExtra);
+        u.blocks++;
+        AddVector(u, s.extra->contours);
+        if (ShapeTransform* t = ShapeTransformOf(s)) {
+            u.bytes += sizeof(ShapeTransform);
+            u.blocks++;
+            AddPointList(u, t->baseVertices);
+        }
+    }
+    return u;
+}
+
+HeapUsage ShapeStoreUsage(const ShapeStore& st) {
+    HeapUsage u;
+    AddVector(u, st.types);
+    AddVector(u, st.colors);
+    AddVector(u, st.fillColors);
+    AddVector(u, st.fillModes);
+    AddVector(u, st.fillRules);
+    AddVector(u, st.revisions);
+    AddVector(u, st.vertexSpans);
+    AddVector(u, st.extraSlots);
+    AddVector(u, st.extras);
+    AddVector(u, st.vertices);
+    AddVector(u, st.contours);
+    return u;
+}
+
+// 图形表 g_shapes 与发布给渲染线程的 ShapeStore 快照同时存在，两者之和才是场景占用的内存；
+// 对照改版前只有一张 std::vector<Shape> 的布局
+void BenchStore() {
+    const int size = 2048, count = 200000;
+    std::vector<Shape> shapes = MakeMixedScene(count, size, 9);
+    // 每 10 个图形平移过一次：平移保留光栅缓存键，要用到 ShapeExtra
+    for (size_t i = 0; i < shapes.size(); i += 10) {
+        for (Point& p : shapes[i].vertices) p.x += 5;
+        TouchShapeTranslated(shapes[i], 5, 0);
+    }
+    std::vector<Legacy::BaselineShape> baseline(shapes.size());
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        const Shape& s = shapes[i];
+        baseline[i] = { s.type, std::vector<Point>(s.vertices.begin(), s.vertices.end()), s.color, s.fillColor, s.fillMode };
+    }
+    ShapeStore store;
+    BuildShapeStore(store, shapes);
+    HeapUsage base = BaselineListUsage(baseline), list = ShapeListUsage(shapes), snap = ShapeStoreUsage(store);
+
+    // 防止遍历被优化掉
+    volatile unsigned long long sink = 0;
+    double copyBase = TimeMs([&] { std::vector<Legacy::BaselineShape> copy = baseline; sink = sink + copy.size(); });
+    double copyList = TimeMs([&] { std::vector<Shape> copy = shapes; sink = sink + copy.size(); });
+    double copyStore = TimeMs([&] { ShapeStore copy = store; sink = sink + ShapeCount(copy); });
+    double scanList = TimeMs([&] {
+        unsigned long long sum = 0;
+        for (const Shape& s : shapes) sum += s.revision;
+        sink = sink + sum;
+    });
+    double scanStore = TimeMs([&] {
+        unsigned long long sum = 0;
+        for (unsigned long long r : store.revisions) sum += r;
+        sink = sink + sum;
+    });
+    double vertsBase = TimeMs([&] {
+        long long sum = 0;
+        for (const auto& s : baseline)
+            for (const Point& p : s.vertices) sum += p.x + p.y;
+        sink = sink + sum;
+    });
+    double vertsList = TimeMs([&] {
+        long long sum = 0;
+        for (const Shape& s : shapes)
+            for (const Point& p : s.vertices) sum += p.x + p.y;
+        sink = sink + sum;
+    });
+    double vertsStore = TimeMs([&] {
+        long long sum = 0;
+        for (const Point& p : store.vertices) sum += p.x + p.y;
+        sink = sink + sum;
+    });
+
+    printf("store: %d mixed shapes (every 10th translated), sizeof(Shape) = %zu, baseline %zu\n", count,
+        sizeof(Shape), sizeof(Legacy::BaselineShape));
+    printf("  %-22s %14s %14s %14s\n", "", "baseline", "vector<Shape>", "ShapeStore");
+    printf("  %-22s %11.2f MB %11.2f MB %11.2f MB\n", "memory", base.bytes / 1048576.0,
+        list.bytes / 1048576.0, snap.bytes / 1048576.0);
+    printf("  %-22s %14zu %14zu %14zu\n", "heap blocks", base.blocks, list.blocks, snap.blocks);
+    printf("  %-22s %11.2f MB %11.2f MB  (g_shapes + published store)\n", "total", base.bytes / 1048576.0,
+        (list.bytes + snap.bytes) / 1048576.0);
+    printf("  %-22s %11.2f ms %11.2f ms %11.2f ms\n", "snapshot copy", copyBase, copyList, copyStore);
+    printf("  %-22s %14s %11.3f ms %11.3f ms\n", "revision scan", "-", scanList, scanStore);
+    printf("  %-22s %11.3f ms %11.3f ms %11.3f ms\n", "vertex iteration", vertsBase, vertsList, vertsStore);
+}
+
+// ----- 直线裁剪：Liang-Barsky（批量 SIMD）vs Cohen-Sutherland -----
+void BenchLineClip() {
+    const int count = 1000000, size = 4096;
+    const RECT clip = { 1024, 1024, 3072, 3072 };
+    std::mt19937 rng(11);
+    std::vector<Shape> lines(count);
+    for (Shape& s : lines) {
+        s.type = DrawMode::DrawLineBresenham;
+        s.color = RGB(0, 0, 0);
+        s.fillColor = RGB(0, 0, 0);
+        s.fillMode = 0;
+        int x = (int)(rng() % size), y = (int)(rng() % size);
+        s.vertices.push_back({ x, y });
+        s.vertices.push_back({ x + (int)(rng() % 1025) - 512, y + (int)(rng() % 1025) - 512 });
+        TouchShape(s);
+    }
+
+    // 只比较裁剪运算本身：所有线段都交给内核
+    std::vector<double> x1(count), y1(count), x2(count), y2(count);
+    std::vector<unsigned char> visible(count), csVisible(count);
+    auto load = [&] {
+        for (int i = 0; i < count; ++i) {
+            x1[i] = lines[i].vertices[0].x;
+            y1[i] = lines[i].vertices[0].y;
+            x2[i] = lines[i].vertices[1].x;
+            y2[i] = lines[i].vertices[1].y;
+        }
+    };
+    double csKernel = TimeBestMs(load, [&] {
+        for (int i = 0; i < count; ++i)
+            csVisible[i] = CohenSutherlandClip(x1[i], y1[i], x2[i], y2[i],
+                clip.left, clip.right, clip.top, clip.bottom);
+    });
+    double lbKernel = TimeBestMs(load, [&] {
+        g_lineClipKernels.clip(x1.data(), y1.data(), x2.data(), y2.data(), visible.data(), count,
+            clip.left, clip.right, clip.top, clip.bottom);
+    });
+    int differ = 0;
+    for (int i = 0; i < count; ++i)
+        if (!visible[i] != !csVisible[i]) ++differ;
+
+    // 整张图形表：含分类、并行分批与写回
+    auto reset = [&] {
+        g_shapes = lines;
+        RebuildShapeIndex(g_shapeIndex, g_shapes);
+    };
+    double csScene = TimeBestMs(reset, [&] { ClipAllLines_CohenSutherland(clip); });
+    size_t csKept = g_shapes.size();
+    double lbScene = TimeBestMs(reset, [&] { ClipAllLines_LiangBarsky(clip); });
+    size_t lbKept = g_shapes.size();
+    g_shapes.clear();
+    RebuildShapeIndex(g_shapeIndex, g_shapes);
+
+    printf("lineclip: %d lines, clip rect %ldx%ld in %dx%d, LB kernel %s\n", count,
+        (long)(clip.right - clip.left), (long)(clip.bottom - clip.top), size, size, g_lineClipKernels.name);
+    printf("  %-22s %10s %10s\n", "", "CS", "LB");
+    printf("  %-22s %7.2f ms %7.2f ms  (%d visibility differences)\n", "kernel only", csKernel, lbKernel, differ);
+    printf("  %-22s %7.2f ms %7.2f ms  (%zu / %zu lines kept)\n", "ClipAllLines_*", csScene, lbScene,
+        csKept, lbKept);
+}
+
+// ----- 中点分割直线裁剪：步号区间 vs 旧的递归分割（每一小段一个图形） -----
+// 两种结果都与原线段在框内画出的像素逐个比较
+size_t CountClipDiff(const std::vector<Shape>& lines, const std::vector<Shape>& clipped, const RECT& clip, int size) {
+    HeapSurface expect, actual;
+    CreateHeapSurface(expect, size, size);
+    CreateHeapSurface(actual, size, size);
+    ClearSurface(expect.surface, RGB(255, 255, 255));
+    ClearSurface(actual.surface, RGB(255, 255, 255));
+    SetSurfaceClip(expect.surface, { clip.left, clip.top, clip.right + 1, clip.bottom + 1 });
+    for (const Shape& s : lines) DrawShapeBorder(expect.surface, s);
+    for (const Shape& s : clipped) DrawShapeBorder(actual.surface, s);
+    size_t diff = 0;
+    for (size_t i = 0; i < expect.pixels.size(); ++i)
+        if (expect.pixels[i] != actual.pixels[i]) ++diff;
+    return diff;
+}
+
+void BenchMidpointClip() {
+    const int count = 200000, size = 4096;
+    const RECT clip = { 1024, 1024, 3072, 3072 };
+    const DrawMode modes[3] = { DrawMode::DrawLineMidpoint, DrawMode::DrawLineBresenham, DrawMode::DrawLineRunSlice };
+    std::mt19937 rng(13);
+    std::vector<Shape> lines(count);
+    for (int i = 0; i < count; ++i) {
+        Shape& s = lines[i];
+        s.type = modes[i % 3];
+        s.color = RGB(i % 251, (i / 251) % 251, 0);
+        int x = (int)(rng() % size), y = (int)(rng() % size);
+        s.vertices.push_back({ x, y });
+        s.vertices.push_back({ x + (int)(rng() % 1025) - 512, y + (int)(rng() % 1025) - 512 });
+        TouchShape(s);
+    }
+
+    std::vector<Shape> legacy;
+    double legacyMs = TimeBestMs([&] { legacy = lines; }, [&] { Legacy::ClipAllLines_Midpoint(legacy, clip); });
+    auto reset = [&] {
+        g_shapes = lines;
+        RebuildShapeIndex(g_shapeIndex, g_shapes);
+    };
+    double rangeMs = TimeBestMs(reset, [&] { ClipAllLines_Midpoint(clip); });
+    int ranged = 0;
+    for (const Shape& s : g_shapes) ranged += ShapeLineSteps(s).last >= 0;
+
+    size_t legacyDiff = CountClipDiff(lines, legacy, clip, size);
+    size_t rangeDiff = CountClipDiff(lines, g_shapes, clip, size);
+    size_t kept = g_shapes.size();
+    g_shapes.clear();
+    RebuildShapeIndex(g_shapeIndex, g_shapes);
+
+    printf("midclip: %d lines, clip rect %ldx%ld in %dx%d, %d lines cut to a step range\n", count,
+        (long)(clip.right - clip.left), (long)(clip.bottom - clip.top), size, size, ranged);
+    printf("  %-22s %10s %10s %16s\n", "", "time", "shapes", "pixels differ");
+    printf("  %-22s %7.2f ms %10zu %16zu\n", "recursive (old)", legacyMs, legacy.size(), legacyDiff);
+    printf("  %-22s %7.2f ms %10zu %16zu\n", "step range", rangeMs, kept, rangeDiff);
+}
+
+// ----- Weiler-Atherton：顶点数上万的多边形，节点池 vs 旧的逐个 new / delete -----
+// 梳子形多边形：横梁在裁剪框上方，teeth 根齿向下伸，长度随机，伸进框内的每根齿各成一块结果
+// 顶点坐标都是偶数、裁剪框边界都是奇数，顶点不会恰好落在框边界上（WA 不处理这种退化情形）
+std::vector<Point> MakeCombPolygon(int teeth, int top, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<Point> v;
+    int right = 4 * teeth + 4;
+    v.push_back({ 0, top - 100 });
+    v.push_back({ right, top - 100 });
+    v.push_back({ right, top });
+    for (int i = teeth; i >= 1; --i) {
+        int tip = top + 2 + 2 * (int)(rng() % 800);
+        v.push_back({ 4 * i + 2, top });
+        v.push_back({ 4 * i + 2, tip });
+        v.push_back({ 4 * i, tip });
+        v.push_back({ 4 * i, top });
+    }
+    v.push_back({ 0, top });
+    return v;
+}
+
+bool SamePolygons(const std::vector<std::vector<Point>>& a, const std::vector<std::vector<Point>>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].size() != b[i].size()) return false;
+        for (size_t k = 0; k < a[i].size(); ++k)
+            if (a[i][k].x != b[i][k].x || a[i][k].y != b[i][k].y) return false;
+    }
+    return true;
+}
+
+void BenchWeilerAtherton() {
+    printf("wa: comb polygons hanging into the clip rect\n");
+    printf("  %-8s %8s %12s %12s %10s %10s %6s\n", "vertices", "pieces", "old", "arena", "old alloc", "arena alloc", "same");
+    for (int teeth : { 2500, 5000, 10000 }) {
+        const int top = 1000;
+        std::vector<Point> poly = MakeCombPolygon(teeth, top, (unsigned)teeth);
+        const RECT clip = { 1, top + 399, 4 * teeth + 3, top + 3001 };
+        std::vector<std::vector<Point>> oldOut, newOut;
+
+        size_t before = g_allocations.load();
+        oldOut = Legacy::ClipPolygon_WeilerAtherton_Rect_Multi(poly, clip);
+        size_t oldAllocs = g_allocations.load() - before;
+        // 第一次调用让线程内的节点池长到足够大，之后只剩输出多边形的分配
+        newOut = ClipPolygon_WeilerAtherton_Rect_Multi(poly, clip);
+        before = g_allocations.load();
+        newOut = ClipPolygon_WeilerAtherton_Rect_Multi(poly, clip);
+        size_t newAllocs = g_allocations.load() - before;
+
+        double oldMs = TimeBestMs([] {}, [&] { oldOut = Legacy::ClipPolygon_WeilerAtherton_Rect_Multi(poly, clip); });
+        double newMs = TimeBestMs([] {}, [&] { newOut = ClipPolygon_WeilerAtherton_Rect_Multi(poly, clip); });
+        printf("  %-8zu %8zu %9.2f ms %9.2f ms %10zu %10zu %6s\n", poly.size(), newOut.size(), oldMs, newMs,
+            oldAllocs, newAllocs, SamePolygons(oldOut, newOut) ? "yes" : "no");
+    }
+}
+
+// ----- Sutherland-Hodgman：四条边流水线 vs 旧的四遍 ClipWithEdge -----
+// 流水线的结果与四遍相同，只是起点不同：比较时允许整圈旋转
+bool SameRing(const std::vector<Point>& a, const std::vector<Point>& b) {
+    if (a.size() != b.size()) return false;
+    if (a.empty()) return true;
+    size_t n = a.size();
+    for (size_t shift = 0; shift < n; ++shift) {
+        if (b[shift].x != a[0].x || b[shift].y != a[0].y) continue;
+        size_t k = 1;
+        while (k < n && a[k].x == b[(k + shift) % n].x && a[k].y == b[(k + shift) % n].y) ++k;
+        if (k == n) return true;
+    }
+    return false;
+}
+
+void BenchSutherlandHodgman() {
+    printf("sh: comb polygons hanging into the clip rect, per call\n");
+    printf("  %-8s %-22s %10s %8s %8s\n", "vertices", "", "time", "allocs", "pieces");
+    for (int teeth : { 2500, 25000 }) {
+        const int top = 1000;
+        std::vector<Point> poly = MakeCombPolygon(teeth, top, (unsigned)teeth);
+        const RECT clip = { 1, top + 399, 4 * teeth + 3, top + 3001 };
+        std::vector<Point> oldRing, newRing;
+        std::vector<std::vector<Point>> oldPieces, newPieces;
+
+        // 各跑一次预热线程内的临时空间，再数一次调用的分配次数
+        struct Row {
+            const char* name;
+            std::function<size_t()> run;    // 返回结果块数
+        };
+        const Row rows[] = {
+            { "four passes (old)", [&] { oldRing = Legacy::ClipPolygon_SutherlandHodgman(poly, clip); return (size_t)1; } },
+            { "pipeline", [&] { newRing = ClipPolygon_SutherlandHodgman(poly, clip); return (size_t)1; } },
+            { "Multi, no split (old)", [&] { oldPieces = Legacy::ClipPolygon_SutherlandHodgman_Multi(poly, clip); return oldPieces.size(); } },
+            { "Multi, split bridges", [&] { newPieces = ClipPolygon_SutherlandHodgman_Multi(poly, clip); return newPieces.size(); } },
+        };
+        for (const Row& row : rows) {
+            row.run();
+            size_t before = g_allocations.load();
+            size_t pieces = row.run();
+            size_t allocs = g_allocations.load() - before;
+            double ms = TimeMs([&] { row.run(); }, 200);
+            printf("  %-8zu %-22s %7.3f ms %8zu %8zu\n", poly.size(), row.name, ms, allocs, pieces);
+        }
+        printf("  %-8s pipeline ring equals the four-pass ring up to rotation: %s\n", "",
+            SameRing(oldRing, newRing) ? "yes" : "no");
+    }
+}
+
+struct BenchCase {
+    const char* name;
+    void (*run)();
+};
+
+const BenchCase CASES[] = {
+    { "lines", BenchLines },
+    { "tiled", BenchTiled },
+    { "replay", BenchReplay },
+    { "store", BenchStore },
+    { "lineclip", BenchLineClip },
+    { "midclip", BenchMidpointClip },
+    { "wa", BenchWeilerAtherton },
+    { "sh", BenchSutherlandHodgman },
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool ran = false;
+    for (const BenchCase& c : CASES) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            if (std::strcmp(argv[i], c.name) == 0) selected = true;
+        if (!selected) continue;
+        c.run();
+        ran = true;
+    }
+    // 线程池的工作线程须在退出前回收
+    ShutdownWorkerPool();
+    if (!ran) {
+        printf("usage: Bench [case ...]\ncases:");
+        for (const BenchCase& c : CASES) printf(" %s", c.name);
+        printf("\n");
+        return 1;
+    }
+    return 0;
+}
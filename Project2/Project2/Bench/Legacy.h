@@ -0,0 +1,38 @@
+#pragma once
+
+// 已被替换的旧实现，原样保留作测速对照，不参与正式程序
+
+#include "ShapeTypes.h"
+#include <utility>
+#include <vector>
+
+namespace GraphicsEngine {
+namespace Legacy {
+
+// 改版前的图形：顶点各自放在一个 std::vector 中，此外只有类型与三项样式（内存对照用）
+struct BaselineShape {
+    DrawMode type;
+    std::vector<Point> vertices;
+    COLORREF color;
+    COLORREF fillColor;
+    int fillMode;
+};
+
+// 递归中点分割：深度不超过 20，框内的每一小段各输出一条线段
+void MidClipLineRec(double x1, double y1, double x2, double y2,
+    double xmin, double xmax, double ymin, double ymax,
+    int depth,
+    std::vector<std::pair<Point, Point>>& outSegs);
+// 旧的 ClipAllLines_Midpoint：每一小段换成一个新图形
+void ClipAllLines_Midpoint(std::vector<Shape>& shapes, const RECT& clip);
+
+// 四遍 Sutherland-Hodgman：依次用四条边各调用一次 ClipWithEdge，每遍生成一个新数组
+std::vector<Point> ClipPolygon_SutherlandHodgman(const std::vector<Point>& poly, const RECT& r);
+// 旧的多结果接口：不去桥边，整圈作为一个多边形返回
+std::vector<std::vector<Point>> ClipPolygon_SutherlandHodgman_Multi(const std::vector<Point>& poly, const RECT& r);
+
+// 指针链表版 Weiler-Atherton：每个顶点与交点各 new 一个节点，用完逐个 delete
+std::vector<std::vector<Point>> ClipPolygon_WeilerAtherton_Rect_Multi(const std::vector<Point>& poly, const RECT& r);
+
+} // namespace Legacy
+} // namespace GraphicsEngine
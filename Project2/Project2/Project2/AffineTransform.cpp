@@ -0,0 +1,94 @@
+#include "AffineTransform.h"
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define AFFINE_X86 1
+#include <emmintrin.h>
+#endif
+
+namespace GraphicsEngine {
+
+Affine2D AffineTranslate(double dx, double dy) {
+    Affine2D m;
+    m.tx = dx;
+    m.ty = dy;
+    return m;
+}
+
+Affine2D AffineScale(const Point& center, double sx, double sy) {
+    Affine2D m;
+    m.a = sx;
+    m.d = sy;
+    m.tx = center.x - center.x * sx;
+    m.ty = center.y - center.y * sy;
+    return m;
+}
+
+Affine2D AffineRotate(const Point& center, double angleRad) {
+    double c = std::cos(angleRad);
+    double s = std::sin(angleRad);
+    Affine2D m;
+    m.a = c;  m.b = -s;
+    m.c = s;  m.d = c;
+    m.tx = center.x - center.x * c + center.y * s;
+    m.ty = center.y - center.x * s - center.y * c;
+    return m;
+}
+
+Affine2D AffineCompose(const Affine2D& then, const Affine2D& first) {
+    Affine2D m;
+    m.a = then.a * first.a + then.b * first.c;
+    m.b = then.a * first.b + then.b * first.d;
+    m.c = then.c * first.a + then.d * first.c;
+    m.d = then.c * first.b + then.d * first.d;
+    m.tx = then.a * first.tx + then.b * first.ty + then.tx;
+    m.ty = then.c * first.tx + then.d * first.ty + then.ty;
+    return m;
+}
+
+static inline void TransformPoint(const Affine2D& m, const Point& p, Point& out) {
+    double x = p.x, y = p.y;
+    double nx = m.a * x + m.b * y + m.tx;
+    double ny = m.c * x + m.d * y + m.ty;
+    out.x = (int)std::round(nx);
+    out.y = (int)std::round(ny);
+}
+
+#ifdef AFFINE_X86
+// 两路 double 按 std::round 取整：先截断，余数达到 ±0.5 时再远离 0 进一
+static inline __m128i RoundHalfAway(__m128d v) {
+    __m128i t = _mm_cvttpd_epi32(v);
+    __m128d frac = _mm_sub_pd(v, _mm_cvtepi32_pd(t));
+    __m128i up = _mm_castpd_si128(_mm_cmpge_pd(frac, _mm_set1_pd(0.5)));
+    __m128i down = _mm_castpd_si128(_mm_cmple_pd(frac, _mm_set1_pd(-0.5)));
+    // 64 位比较掩码取低 32 位，排到低两个通道
+    up = _mm_shuffle_epi32(up, _MM_SHUFFLE(3, 3, 2, 0));
+    down = _mm_shuffle_epi32(down, _MM_SHUFFLE(3, 3, 2, 0));
+    return _mm_add_epi32(_mm_sub_epi32(t, up), down);
+}
+#endif
+
+void AffineTransformPoints(const Affine2D& m, const Point* src, Point* dst, size_t n) {
+    size_t i = 0;
+#ifdef AFFINE_X86
+    const __m128d a = _mm_set1_pd(m.a), b = _mm_set1_pd(m.b), tx = _mm_set1_pd(m.tx);
+    const __m128d c = _mm_set1_pd(m.c), d = _mm_set1_pd(m.d), ty = _mm_set1_pd(m.ty);
+    for (; i + 2 <= n; i += 2) {
+        // [x0, y0, x1, y1] -> [x0, x1, y0, y1]
+        __m128i p = _mm_loadu_si128((const __m128i*)(src + i));
+        p = _mm_shuffle_epi32(p, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128d x = _mm_cvtepi32_pd(p);
+        __m128d y = _mm_cvtepi32_pd(_mm_srli_si128(p, 8));
+        // 与标量实现相同的运算顺序：(a x + b y) + tx
+        __m128d nx = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, x), _mm_mul_pd(b, y)), tx);
+        __m128d ny = _mm_add_pd(_mm_add_pd(_mm_mul_pd(c, x), _mm_mul_pd(d, y)), ty);
+        __m128i rx = RoundHalfAway(nx);
+        __m128i ry = RoundHalfAway(ny);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi32(rx, ry));
+    }
+#endif
+    for (; i < n; ++i)
+        TransformPoint(m, src[i], dst[i]);
+}
+
+} // namespace GraphicsEngine
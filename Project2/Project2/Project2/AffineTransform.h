@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include "ShapeTypes.h"
+
+namespace GraphicsEngine {
+
+Affine2D AffineTranslate(double dx, double dy);
+// 以 center 为中心缩放 / 旋转
+Affine2D AffineScale(const Point& center, double sx, double sy);
+Affine2D AffineRotate(const Point& center, double angleRad);
+// 先做 first 再做 then
+Affine2D AffineCompose(const Affine2D& then, const Affine2D& first);
+
+// 批量变换顶点：dst[i] = round(m · src[i])，取整方式同 std::round（0.5 远离 0）
+// x86 上每次处理两个顶点（SSE2），结果与标量实现逐位一致；src 与 dst 可以相同
+void AffineTransformPoints(const Affine2D& m, const Point* src, Point* dst, size_t n);
+
+} // namespace GraphicsEngine
@@ -1,12 +1,97 @@
 #include "Clip.h"
+#include "Shapes.h"
+#include "LineClip.h"
+#include "PolygonBoolean.h"
+#include "WorkerPool.h"
 #include <cmath>
+#include <cstdlib>
 #include <algorithm>
+#include <array>
 #include <list>
 #include <set>
 #include <map>
 
 namespace GraphicsEngine {
 
+// ----- 裁剪前按包围盒分类 -----
+// 用空间索引中缓存的包围盒，只有跨越裁剪框边界的图形才需要真正裁剪
+enum ClipClass : char {
+    CLIP_OUTSIDE,   // 完全在框外：裁剪后消失
+    CLIP_INSIDE,    // 完全在框内：裁剪后不变
+    CLIP_STRADDLE   // 跨越边界或没有包围盒：照常裁剪
+};
+
+static void ClassifyForClip(const RECT& clip, std::vector<char>& cls) {
+    if (g_shapeIndex.bounds.size() != g_shapes.size())
+        RebuildShapeIndex(g_shapeIndex, g_shapes);
+    cls.assign(g_shapes.size(), CLIP_OUTSIDE);
+    for (size_t i = 0; i < g_shapes.size(); ++i)
+        if (!g_shapeIndex.indexed[i]) cls[i] = CLIP_STRADDLE;
+    // 裁剪框的右、下边界是闭的
+    RECT query = { clip.left, clip.top, clip.right + 1, clip.bottom + 1 };
+    std::vector<int> candidates;
+    QueryShapeIndex(g_shapeIndex, query, candidates);
+    for (int i : candidates) {
+        const RECT& b = g_shapeIndex.bounds[i];
+        bool inside = b.left >= clip.left && b.top >= clip.top && b.right <= clip.right && b.bottom <= clip.bottom;
+        cls[i] = inside ? CLIP_INSIDE : CLIP_STRADDLE;
+    }
+}
+
+static bool IsLineShape(const Shape& s) {
+    return s.type == DrawMode::DrawLineMidpoint || s.type == DrawMode::DrawLineBresenham ||
+        s.type == DrawMode::DrawLineRunSlice;
+}
+
+// ----- 并行裁剪整个图形表 -----
+// 每个并行任务处理的图形数
+static const int CLIP_BATCH = 1024;
+
+// 图形表按批分给工作线程独立裁剪，再按原顺序把保留的图形移动拼接成新表
+// clipBatch(begin, end, keep) 处理 [begin, end) 内的图形：保留的就地改写或替换，并置 keep[i]
+// 各批只改自己范围内的图形，版本号由原子计数器分配；没有图形被删去时不重排
+// 在 UI 线程上调用，线程池被渲染线程占用时就地串行执行
+template <class ClipBatch>
+static void ClipShapesParallel(ClipBatch clipBatch) {
+    int n = (int)g_shapes.size();
+    int batches = (n + CLIP_BATCH - 1) / CLIP_BATCH;
+    std::vector<char> keep(n);
+    std::vector<int> offset(batches + 1, 0);
+    ParallelForIfIdle(batches, [&](int b) {
+        int begin = b * CLIP_BATCH;
+        int end = (std::min)(n, begin + CLIP_BATCH);
+        clipBatch(begin, end, keep.data());
+        int kept = 0;
+        for (int i = begin; i < end; ++i) kept += keep[i];
+        offset[b + 1] = kept;
+    });
+    for (int b = 0; b < batches; ++b) offset[b + 1] += offset[b];
+
+    if (offset[batches] != n && WorkerThreadCount() > 1) {
+        // 各批在新表中的区间由前缀和确定、互不重叠，可以并行移动
+        std::vector<Shape> newShapes(offset[batches]);
+        ParallelForIfIdle(batches, [&](int b) {
+            int begin = b * CLIP_BATCH;
+            int end = (std::min)(n, begin + CLIP_BATCH);
+            int out = offset[b];
+            for (int i = begin; i < end; ++i)
+                if (keep[i]) newShapes[out++] = std::move(g_shapes[i]);
+        });
+        g_shapes.swap(newShapes);
+    }
+    else if (offset[batches] != n) {
+        // 单线程时就地前移，省去新表的构造
+        int out = 0;
+        for (int i = 0; i < n; ++i) {
+            if (!keep[i]) continue;
+            if (out != i) g_shapes[out] = std::move(g_shapes[i]);
+            ++out;
+        }
+        g_shapes.resize(out);
+    }
+    RebuildShapeIndex(g_shapeIndex, g_shapes);
+}
+
 // ----- Cohen-Sutherland 裁剪 -----
 static const int CS_INSIDE = 0;
 static const int CS_LEFT   = 1;
@@ -70,26 +155,78 @@ void ClipAllLines_CohenSutherland(const RECT& clip) {
     double ymin = clip.top;
     double ymax = clip.bottom;
 
-    std::vector<Shape> newShapes;
-    for (auto s : g_shapes) {
-        if (s.type == DrawMode::DrawLineMidpoint || s.type == DrawMode::DrawLineBresenham) {
-            double x1 = s.vertices[0].x;
-            double y1 = s.vertices[0].y;
-            double x2 = s.vertices[1].x;
-            double y2 = s.vertices[1].y;
+    std::vector<char> cls;
+    ClassifyForClip(clip, cls);
+    ClipShapesParallel([&](int begin, int end, char* keep) {
+        for (int i = begin; i < end; ++i) {
+            Shape& s = g_shapes[i];
+            keep[i] = !IsLineShape(s) || cls[i] == CLIP_INSIDE;
+            if (keep[i] || cls[i] == CLIP_OUTSIDE) continue;
+            // 中点分割法留下的步号区间先落实到端点，按可见部分裁剪
+            Point a, b;
+            LineVisibleEnds(s, a, b);
+            double x1 = a.x;
+            double y1 = a.y;
+            double x2 = b.x;
+            double y2 = b.y;
             if (CohenSutherlandClip(x1, y1, x2, y2, xmin, xmax, ymin, ymax)) {
                 s.vertices[0].x = (int)std::round(x1);
                 s.vertices[0].y = (int)std::round(y1);
                 s.vertices[1].x = (int)std::round(x2);
                 s.vertices[1].y = (int)std::round(y2);
-                newShapes.push_back(s);
+                SetShapeLineSteps(s, LineSteps{});
+                TouchShape(s);
+                keep[i] = 1;
             }
         }
-        else {
-            newShapes.push_back(s);
+    });
+}
+
+// ----- Liang-Barsky 批量裁剪 -----
+// 每批中跨越边界的线段端点收集成结构数组，一次交给 SIMD 内核，结果写回原图形
+struct LBScratch {
+    std::vector<int> lines;
+    std::vector<double> x1, y1, x2, y2;
+    std::vector<unsigned char> visible;
+};
+
+void ClipAllLines_LiangBarsky(const RECT& clip) {
+    std::vector<char> cls;
+    ClassifyForClip(clip, cls);
+    ClipShapesParallel([&](int begin, int end, char* keep) {
+        thread_local LBScratch sc;
+        sc.lines.clear();
+        for (int i = begin; i < end; ++i) {
+            const Shape& s = g_shapes[i];
+            keep[i] = !IsLineShape(s) || cls[i] == CLIP_INSIDE;
+            if (!keep[i] && cls[i] == CLIP_STRADDLE) sc.lines.push_back(i);
         }
-    }
-    g_shapes.swap(newShapes);
+        size_t n = sc.lines.size();
+        sc.x1.resize(n);
+        sc.y1.resize(n);
+        sc.x2.resize(n);
+        sc.y2.resize(n);
+        sc.visible.resize(n);
+        for (size_t k = 0; k < n; ++k) {
+            Point a, b;
+            LineVisibleEnds(g_shapes[sc.lines[k]], a, b);
+            sc.x1[k] = a.x;
+            sc.y1[k] = a.y;
+            sc.x2[k] = b.x;
+            sc.y2[k] = b.y;
+        }
+        g_lineClipKernels.clip(sc.x1.data(), sc.y1.data(), sc.x2.data(), sc.y2.data(), sc.visible.data(), n,
+            clip.left, clip.right, clip.top, clip.bottom);
+        for (size_t k = 0; k < n; ++k) {
+            if (!sc.visible[k]) continue;
+            Shape& s = g_shapes[sc.lines[k]];
+            s.vertices[0] = { (int)std::round(sc.x1[k]), (int)std::round(sc.y1[k]) };
+            s.vertices[1] = { (int)std::round(sc.x2[k]), (int)std::round(sc.y2[k]) };
+            SetShapeLineSteps(s, LineSteps{});
+            TouchShape(s);
+            keep[sc.lines[k]] = 1;
+        }
+    });
 }
 
 // ----- 中点分割法 -----
@@ -97,77 +234,378 @@ void ClipAllLines_CohenSutherland(const RECT& clip) {
 bool InsideRect(double x, double y, double xmin, double xmax, double ymin, double ymax) {
     return x >= xmin && x <= xmax && y >= ymin && y <= ymax;
 }
-// 递归裁剪函数
-void MidClipLineRec(double x1, double y1, double x2, double y2,
-    double xmin, double xmax, double ymin, double ymax,
-    int depth,
-    std::vector<std::pair<Point, Point>>& outSegs) {
-    bool in1 = InsideRect(x1, y1, xmin, xmax, ymin, ymax);
-    bool in2 = InsideRect(x2, y2, xmin, xmax, ymin, ymax);
-    // 全部在矩形内，结束递归
-    if (in1 && in2) {
-        Point a{ (int)std::round(x1), (int)std::round(y1) };
-        Point b{ (int)std::round(x2), (int)std::round(y2) };
-        outSegs.push_back({ a, b });
-        return;
+// 中点分割：在原线段的步号区间 [first, last] 内二分查找最先与最后落在裁剪框内的步
+// 第 t 步即原线段逐像素经过的点（见 LineStepPoint），端点不动，画出的像素与裁剪前逐个相同
+// 沿前进方向看，“尚未越过进入边”与“已越过离开边”都是单调的，各二分一次即可
+bool MidpointClipLine(const Point& p1, const Point& p2, const RECT& r, int& first, int& last) {
+    int dx = p2.x - p1.x;
+    int dy = p2.y - p1.y;
+    long long steps = LineStepCount(p1.x, p1.y, p2.x, p2.y);
+    long long lo0 = first, hi0 = last < 0 ? steps : last;
+    auto at = [&](long long t) { return LineStepPoint(p1.x, p1.y, p2.x, p2.y, t); };
+    Point a = at(lo0), b = at(hi0);
+    if (CS_GetOutCode(a.x, a.y, r.left, r.right, r.top, r.bottom) &
+        CS_GetOutCode(b.x, b.y, r.left, r.right, r.top, r.bottom))
+        return false;
+
+    auto before = [&](long long t) {
+        Point p = at(t);
+        return (dx > 0 && p.x < r.left) || (dx < 0 && p.x > r.right) ||
+            (dy > 0 && p.y < r.top) || (dy < 0 && p.y > r.bottom);
+    };
+    auto after = [&](long long t) {
+        Point p = at(t);
+        return (dx > 0 && p.x > r.right) || (dx < 0 && p.x < r.left) ||
+            (dy > 0 && p.y > r.bottom) || (dy < 0 && p.y < r.top);
+    };
+
+    // 第一个不在进入边之前的步
+    long long enter = lo0;
+    if (before(lo0)) {
+        if (before(hi0)) return false;
+        long long lo = lo0, hi = hi0;
+        while (hi - lo > 1) {
+            long long mid = lo + (hi - lo) / 2;
+            if (before(mid)) lo = mid;
+            else hi = mid;
+        }
+        enter = hi;
     }
-    // 深度大于阈值，也结束递归
-    if (depth > 20) {
-        if (in1 || in2) {
-            Point a{ (int)std::round(x1), (int)std::round(y1) };
-            Point b{ (int)std::round(x2), (int)std::round(y2) };
-            outSegs.push_back({ a, b });
+    // 最后一个不在离开边之后的步
+    long long leave = hi0;
+    if (after(hi0)) {
+        if (after(lo0)) return false;
+        long long lo = lo0, hi = hi0;
+        while (hi - lo > 1) {
+            long long mid = lo + (hi - lo) / 2;
+            if (after(mid)) hi = mid;
+            else lo = mid;
         }
-        return;
+        leave = lo;
     }
+    // 线段从框角外擦过
+    if (enter > leave) return false;
+
+    // 整条线段可见时仍记作 last < 0
+    first = (int)enter;
+    last = enter == 0 && leave == steps ? -1 : (int)leave;
+    return true;
+}
 
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    if (std::fabs(dx) < 0.5 && std::fabs(dy) < 0.5) {
-        if (in1 && in2) {
-            Point a{ (int)std::round(x1), (int)std::round(y1) };
-            Point b{ (int)std::round(x2), (int)std::round(y2) };
-            //两端都在内，加入结果内
-            outSegs.push_back({ a, b });
+// 真正的裁剪：可见线段只改步号区间，端点不动
+void ClipAllLines_Midpoint(const RECT& clip) {
+    std::vector<char> cls;
+    ClassifyForClip(clip, cls);
+    ClipShapesParallel([&](int begin, int end, char* keep) {
+        for (int i = begin; i < end; ++i) {
+            Shape& s = g_shapes[i];
+            keep[i] = !IsLineShape(s) || cls[i] == CLIP_INSIDE;
+            if (keep[i] || cls[i] == CLIP_OUTSIDE) continue;
+            LineSteps steps = ShapeLineSteps(s);
+            int first = steps.first, last = steps.last;
+            if (!MidpointClipLine(s.vertices[0], s.vertices[1], clip, first, last)) continue;
+            keep[i] = 1;
+            if (first == steps.first && last == steps.last) continue;
+            SetShapeLineSteps(s, { first, last });
+            TouchShape(s);
         }
-        return;
+    });
+}
+
+// ----- 圆、圆弧与 B 样条曲线裁剪 -----
+// 曲线按描边裁剪，结果仍是曲线：圆与圆弧按与框边界交点的角度留下框内的弧段；
+// B 样条逐段细分找出与框边界的交点，整段在框内的沿用原控制点，被截断的段换成等价的 4 个控制点
+// 框边界外扩半像素，像素中心落在框内即可见
+
+static const double CLIP_PI = 3.14159265358979323846;
+static const double CLIP_TWO_PI = 2 * CLIP_PI;
+// 新算出的弧端方向点到圆心的距离，方向误差约 0.5 / ARC_DIR_SCALE 弧度
+static const double ARC_DIR_SCALE = 16384.0;
+
+static bool IsCurveShape(const Shape& s) {
+    return s.type == DrawMode::DrawCircleMidpoint || s.type == DrawMode::DrawCircleBresenham ||
+        s.type == DrawMode::DrawArc || s.type == DrawMode::DrawBSpline;
+}
+
+struct CurveBox {
+    double xmin, xmax, ymin, ymax;
+};
+
+static CurveBox CurveClipBox(const RECT& clip) {
+    return { clip.left - 0.5, clip.right + 0.5, clip.top - 0.5, clip.bottom + 0.5 };
+}
+
+static bool InsideCurveBox(double x, double y, const CurveBox& w) {
+    return x >= w.xmin && x <= w.xmax && y >= w.ymin && y <= w.ymax;
+}
+
+// 角度区间 [a0, a1]：a0 ∈ [0, 2π)，a0 < a1 <= a0 + 2π；沿角度增大方向（屏幕坐标下顺时针）
+struct AngleSpan {
+    double a0, a1;
+};
+
+static double NormalizeAngle(double a) {
+    a = std::fmod(a, CLIP_TWO_PI);
+    return a < 0 ? a + CLIP_TWO_PI : a;
+}
+
+// 半径 r 的圆在框内的角度区间；整个圆都在框内时返回 false
+static bool CircleSpansInBox(double xc, double yc, double r, const CurveBox& w, std::vector<AngleSpan>& out) {
+    out.clear();
+    // 四条边各至多两个交点；空位填无穷大，整个数组一起排序后前 n 个即为交点
+    std::array<double, 8> cuts;
+    cuts.fill(HUGE_VAL);
+    int n = 0;
+    for (double x : { w.xmin, w.xmax }) {
+        double c = (x - xc) / r;
+        if (c <= -1 || c >= 1) continue;
+        double a = std::acos(c);
+        cuts[n++] = a;
+        cuts[n++] = CLIP_TWO_PI - a;
     }
+    for (double y : { w.ymin, w.ymax }) {
+        double s = (y - yc) / r;
+        if (s <= -1 || s >= 1) continue;
+        double a = std::asin(s);
+        cuts[n++] = NormalizeAngle(a);
+        cuts[n++] = CLIP_PI - a;
+    }
+    auto inside = [&](double a) { return InsideCurveBox(xc + r * std::cos(a), yc + r * std::sin(a), w); };
+    if (n == 0) return !inside(0);
+    std::sort(cuts.begin(), cuts.end());
+    // 相邻交点之间的弧要么整段在框内，要么整段在框外，取中点判断
+    for (int i = 0; i < n; ++i) {
+        double a0 = cuts[i], a1 = i + 1 < n ? cuts[i + 1] : cuts[0] + CLIP_TWO_PI;
+        if (a1 - a0 < 1e-12 || !inside((a0 + a1) / 2)) continue;
+        if (!out.empty() && out.back().a1 == a0) out.back().a1 = a1;
+        else out.push_back({ a0, a1 });
+    }
+    if (out.size() > 1 && out.back().a1 == out.front().a0 + CLIP_TWO_PI) {
+        out.front() = { out.back().a0, out.front().a1 + CLIP_TWO_PI };
+        out.pop_back();
+    }
+    return !(out.size() == 1 && out[0].a1 - out[0].a0 >= CLIP_TWO_PI - 1e-12);
+}
 
-    double mx = (x1 + x2) * 0.5;
-    double my = (y1 + y2) * 0.5;
+struct CurveScratch {
+    std::vector<AngleSpan> box;
+    std::vector<Point> ends;
+    std::vector<std::pair<double, double>> ranges;
+    std::vector<std::vector<Point>> pieces;
+};
 
-    MidClipLineRec(x1, y1, mx, my, xmin, xmax, ymin, ymax, depth + 1, outSegs);
-    MidClipLineRec(mx, my, x2, y2, xmin, xmax, ymin, ymax, depth + 1, outSegs);
+static double DirectionAngle(const Point& c, const Point& p) {
+    return NormalizeAngle(std::atan2(double(p.y - c.y), double(p.x - c.x)));
 }
-// 真正的裁剪
-void ClipAllLines_Midpoint(const RECT& clip) {
-    double xmin = clip.left;
-    double xmax = clip.right;
-    double ymin = clip.top;
-    double ymax = clip.bottom;
 
-    std::vector<Shape> newShapes;
-    for (auto s : g_shapes) {
-        if (s.type == DrawMode::DrawLineMidpoint || s.type == DrawMode::DrawLineBresenham) {
-            std::vector<std::pair<Point, Point>> segs;
-            MidClipLineRec(
-                (double)s.vertices[0].x, (double)s.vertices[0].y,
-                (double)s.vertices[1].x, (double)s.vertices[1].y,
-                xmin, xmax, ymin, ymax, 0, segs
-            );
-            for (auto& seg : segs) {
-                Shape ns = s;
-                ns.vertices.clear();
-                ns.vertices.push_back(seg.first);
-                ns.vertices.push_back(seg.second);
-                newShapes.push_back(ns);
+static Point ArcDirectionPoint(const Point& c, double a) {
+    return { c.x + (int)std::lround(ARC_DIR_SCALE * std::cos(a)), c.y + (int)std::lround(ARC_DIR_SCALE * std::sin(a)) };
+}
+
+// 未填充的圆或圆弧与框求交，结果就地改写成圆弧；框内什么也不剩时返回 false
+// 原有的弧端保留原来的方向点，只有新的交点按角度算出方向点，反复裁剪不会漂移
+static bool ClipArcShape(Shape& s, const RECT& clip, CurveScratch& sc) {
+    const auto& v = s.vertices;
+    Point c = v[0];
+    int r = CircleRadius(v);
+    if (r <= 0) return false;
+    if (!CircleSpansInBox(c.x, c.y, r, CurveClipBox(clip), sc.box)) return true;
+    if (sc.box.empty()) return false;
+
+    bool arc = s.type == DrawMode::DrawArc;
+    size_t arcCount = arc ? (v.size() - 2) / 2 : 1;
+    bool changed = !arc;
+    sc.ends.clear();
+    for (size_t k = 0; k < arcCount; ++k) {
+        AngleSpan a = { 0, CLIP_TWO_PI };
+        if (arc) {
+            a.a0 = DirectionAngle(c, v[2 + 2 * k]);
+            a.a1 = DirectionAngle(c, v[3 + 2 * k]);
+            if (a.a1 <= a.a0) a.a1 += CLIP_TWO_PI;
+        }
+        for (const AngleSpan& b : sc.box) {
+            for (int turn = -1; turn <= 1; ++turn) {
+                double lo = (std::max)(a.a0, b.a0 + turn * CLIP_TWO_PI);
+                double hi = (std::min)(a.a1, b.a1 + turn * CLIP_TWO_PI);
+                if (hi - lo < 1e-9) continue;
+                // 框边界的角度与方向点反算出的角度可能差一点舍入误差，只看重新算出的方向点
+                // 与原来的是否相同；相同就沿用原方向点，反复裁剪时不算改动
+                Point p0 = arc && lo == a.a0 ? v[2 + 2 * k] : ArcDirectionPoint(c, lo);
+                Point p1 = arc && hi == a.a1 ? v[3 + 2 * k] : ArcDirectionPoint(c, hi);
+                if (!arc || p0.x != v[2 + 2 * k].x || p0.y != v[2 + 2 * k].y ||
+                    p1.x != v[3 + 2 * k].x || p1.y != v[3 + 2 * k].y)
+                    changed = true;
+                sc.ends.push_back(p0);
+                sc.ends.push_back(p1);
             }
         }
-        else {
-            newShapes.push_back(s);
+    }
+    if (sc.ends.empty()) return false;
+    if (!changed && sc.ends.size() == v.size() - 2) return true;
+
+    Point center = v[0], onCircle = v[1];
+    s.type = DrawMode::DrawArc;
+    ClearShapeContours(s);
+    s.vertices.clear();
+    s.vertices.push_back(center);
+    s.vertices.push_back(onCircle);
+    s.vertices.append(sc.ends.data(), sc.ends.size());
+    TouchShape(s);
+    return true;
+}
+
+// 三次 Bezier 曲线（B 样条段换成 Bezier 形式后按控制多边形细分）
+struct CurveBezier {
+    double x[4], y[4];
+};
+
+static void BSplineToBezier(const Point* p, CurveBezier& b) {
+    b.x[0] = (p[0].x + 4.0 * p[1].x + p[2].x) / 6;
+    b.y[0] = (p[0].y + 4.0 * p[1].y + p[2].y) / 6;
+    b.x[1] = (2.0 * p[1].x + p[2].x) / 3;
+    b.y[1] = (2.0 * p[1].y + p[2].y) / 3;
+    b.x[2] = (p[1].x + 2.0 * p[2].x) / 3;
+    b.y[2] = (p[1].y + 2.0 * p[2].y) / 3;
+    b.x[3] = (p[1].x + 4.0 * p[2].x + p[3].x) / 6;
+    b.y[3] = (p[1].y + 4.0 * p[2].y + p[3].y) / 6;
+}
+
+// 上式的逆：同一条曲线的 4 个均匀 B 样条控制点
+static void BezierToBSpline(const CurveBezier& b, Point* p) {
+    const double cx[4] = { 6 * b.x[0] - 7 * b.x[1] + 2 * b.x[2], 2 * b.x[1] - b.x[2],
+        2 * b.x[2] - b.x[1], 2 * b.x[1] - 7 * b.x[2] + 6 * b.x[3] };
+    const double cy[4] = { 6 * b.y[0] - 7 * b.y[1] + 2 * b.y[2], 2 * b.y[1] - b.y[2],
+        2 * b.y[2] - b.y[1], 2 * b.y[1] - 7 * b.y[2] + 6 * b.y[3] };
+    for (int k = 0; k < 4; ++k)
+        p[k] = { (int)std::lround(cx[k]), (int)std::lround(cy[k]) };
+}
+
+// de Casteljau：在 t 处分成前后两段
+static void SplitBezier(const CurveBezier& b, double t, CurveBezier& l, CurveBezier& r) {
+    double x01 = b.x[0] + (b.x[1] - b.x[0]) * t, y01 = b.y[0] + (b.y[1] - b.y[0]) * t;
+    double x12 = b.x[1] + (b.x[2] - b.x[1]) * t, y12 = b.y[1] + (b.y[2] - b.y[1]) * t;
+    double x23 = b.x[2] + (b.x[3] - b.x[2]) * t, y23 = b.y[2] + (b.y[3] - b.y[2]) * t;
+    double xa = x01 + (x12 - x01) * t, ya = y01 + (y12 - y01) * t;
+    double xb = x12 + (x23 - x12) * t, yb = y12 + (y23 - y12) * t;
+    double xm = xa + (xb - xa) * t, ym = ya + (yb - ya) * t;
+    l = { { b.x[0], x01, xa, xm }, { b.y[0], y01, ya, ym } };
+    r = { { xm, xb, x23, b.x[3] }, { ym, yb, y23, b.y[3] } };
+}
+
+// 细分到子段的控制多边形完全在框内或框外为止；小于 BEZIER_CLIP_FLAT 像素的子段按中点判断
+static const double BEZIER_CLIP_FLAT = 0.25;
+static const int BEZIER_CLIP_MAX_DEPTH = 24;
+
+// 曲线在框内的参数区间按 t 升序追加到 out，相接的区间合并
+static void BezierRangesInBox(const CurveBezier& b, double t0, double t1, const CurveBox& w, int depth,
+    std::vector<std::pair<double, double>>& out) {
+    double xmin = b.x[0], xmax = b.x[0], ymin = b.y[0], ymax = b.y[0];
+    for (int k = 1; k < 4; ++k) {
+        xmin = (std::min)(xmin, b.x[k]); xmax = (std::max)(xmax, b.x[k]);
+        ymin = (std::min)(ymin, b.y[k]); ymax = (std::max)(ymax, b.y[k]);
+    }
+    if (xmax < w.xmin || xmin > w.xmax || ymax < w.ymin || ymin > w.ymax) return;
+    bool inside = xmin >= w.xmin && xmax <= w.xmax && ymin >= w.ymin && ymax <= w.ymax;
+    if (!inside) {
+        bool flat = xmax - xmin < BEZIER_CLIP_FLAT && ymax - ymin < BEZIER_CLIP_FLAT;
+        if (!flat && depth < BEZIER_CLIP_MAX_DEPTH) {
+            CurveBezier l, r;
+            SplitBezier(b, 0.5, l, r);
+            double tm = (t0 + t1) / 2;
+            BezierRangesInBox(l, t0, tm, w, depth + 1, out);
+            BezierRangesInBox(r, tm, t1, w, depth + 1, out);
+            return;
         }
+        double xm = (b.x[0] + 3 * b.x[1] + 3 * b.x[2] + b.x[3]) / 8;
+        double ym = (b.y[0] + 3 * b.y[1] + 3 * b.y[2] + b.y[3]) / 8;
+        if (!InsideCurveBox(xm, ym, w)) return;
     }
-    g_shapes.swap(newShapes);
+    // 二分得到的端点是精确的二进制小数，相接的区间端点逐位相等
+    if (!out.empty() && out.back().second == t0) out.back().second = t1;
+    else out.push_back({ t0, t1 });
+}
+
+static bool BezierWhollyInBox(const CurveBezier& b, const CurveBox& w, std::vector<std::pair<double, double>>& ranges) {
+    ranges.clear();
+    BezierRangesInBox(b, 0, 1, w, 0, ranges);
+    return ranges.size() == 1 && ranges[0].first == 0 && ranges[0].second == 1;
+}
+
+// 截断后的控制点取整，曲线端点可能越出框边界不到半像素；曲线在外扩半像素的框内时
+// 整段保留，同一个框再裁剪一次不会再截
+static const double BSPLINE_CLIP_SLACK = 0.5;
+
+// 裁剪一条 B 样条曲线，框内的各条曲线追加到 pieces；有改动时置 changed
+static void ClipBSplinePiece(const Point* ctrl, size_t n, const CurveBox& w, CurveScratch& sc, bool& changed) {
+    const CurveBox slack = { w.xmin - BSPLINE_CLIP_SLACK, w.xmax + BSPLINE_CLIP_SLACK,
+        w.ymin - BSPLINE_CLIP_SLACK, w.ymax + BSPLINE_CLIP_SLACK };
+    if (n < 4) {
+        changed = true;
+        return;
+    }
+    int run = -1;       // 连续整段在框内的段的起点
+    for (size_t i = 0; i + 3 < n; ++i) {
+        CurveBezier b;
+        BSplineToBezier(ctrl + i, b);
+        if (BezierWhollyInBox(b, slack, sc.ranges)) {
+            if (run < 0) run = (int)i;
+            continue;
+        }
+        changed = true;
+        if (run >= 0) {
+            sc.pieces.emplace_back(ctrl + run, ctrl + i + 3);
+            run = -1;
+        }
+        sc.ranges.clear();
+        BezierRangesInBox(b, 0, 1, w, 0, sc.ranges);
+        for (auto& range : sc.ranges) {
+            if (range.second - range.first < 1e-6) continue;
+            // 先截掉 t1 之后的部分，再在剩下的一段中按比例截掉 t0 之前的部分
+            CurveBezier head = b, tail, sub = b;
+            if (range.second < 1) SplitBezier(b, range.second, head, tail);
+            if (range.first > 0) SplitBezier(head, range.first / range.second, tail, sub);
+            else sub = head;
+            Point p[4];
+            BezierToBSpline(sub, p);
+            sc.pieces.emplace_back(p, p + 4);
+        }
+    }
+    if (run >= 0) sc.pieces.emplace_back(ctrl + run, ctrl + n);
+}
+
+// B 样条与框求交，框内的曲线就地改写（多条时用 contours 分开）；什么也不剩时返回 false
+static bool ClipBSplineShape(Shape& s, const RECT& clip, CurveScratch& sc) {
+    CurveBox w = CurveClipBox(clip);
+    bool changed = false;
+    sc.pieces.clear();
+    ForEachBSplinePiece(s, [&](const Point* ctrl, size_t n) {
+        ClipBSplinePiece(ctrl, n, w, sc, changed);
+    });
+    if (!changed) return true;
+    if (sc.pieces.empty()) return false;
+
+    s.vertices.clear();
+    ClearShapeContours(s);
+    for (auto& p : sc.pieces) {
+        s.vertices.append(p.data(), p.size());
+        if (sc.pieces.size() > 1) EditShapeExtra(s).contours.push_back((int)p.size());
+    }
+    TouchShape(s);
+    return true;
+}
+
+void ClipAllCurves(const RECT& clip) {
+    std::vector<char> cls;
+    ClassifyForClip(clip, cls);
+    ClipShapesParallel([&](int begin, int end, char* keep) {
+        thread_local CurveScratch sc;
+        for (int i = begin; i < end; ++i) {
+            Shape& s = g_shapes[i];
+            keep[i] = !IsCurveShape(s) || IsClosedShape(s) || cls[i] == CLIP_INSIDE;
+            if (keep[i] || cls[i] == CLIP_OUTSIDE || s.vertices.size() < 2) continue;
+            keep[i] = s.type == DrawMode::DrawBSpline ? ClipBSplineShape(s, clip, sc) : ClipArcShape(s, clip, sc);
+        }
+    });
 }
 
 // ----- Sutherland-Hodgman 多边形裁剪 -----
@@ -219,38 +657,242 @@ std::vector<Point> ClipWithEdge(const std::vector<Point>& poly, char edge, const
     return out;
 }
 
+// 流水线式裁剪：顶点逐个流过左、右、上、下四级，每级只记住首点与上一点，
+// 不再为每条边生成中间数组。各级的取舍与 ClipWithEdge 相同，只是结果的起点不同
+// 级数作为模板参数，每级的边在编译期确定
+struct SHStage {
+    bool started;
+    Point first, prev;
+};
+
+static const char SH_EDGES[4] = { 'L', 'R', 'T', 'B' };
+
+template <int K> struct SHPipe;
+
+template <> struct SHPipe<4> {
+    static void Push(SHStage*, const Point& p, const RECT&, std::vector<Point>& out) { out.push_back(p); }
+    static void Close(SHStage*, const RECT&, std::vector<Point>&) {}
+};
+
+template <int K> struct SHPipe {
+    // 第 K 级处理边 S->E，保留下来的点送往下一级
+    static void Edge(SHStage* st, const Point& S, const Point& E, const RECT& r, std::vector<Point>& out) {
+        bool Sin = InsideEdge(S, SH_EDGES[K], r);
+        bool Ein = InsideEdge(E, SH_EDGES[K], r);
+        if (Sin != Ein) SHPipe<K + 1>::Push(st, IntersectEdge(S, E, SH_EDGES[K], r), r, out);
+        if (Ein) SHPipe<K + 1>::Push(st, E, r, out);
+    }
+    static void Push(SHStage* st, const Point& p, const RECT& r, std::vector<Point>& out) {
+        SHStage& s = st[K];
+        if (s.started) Edge(st, s.prev, p, r, out);
+        else { s.started = true; s.first = p; }
+        s.prev = p;
+    }
+    // 依次闭合各级：本级闭合时送出的点还要流过后面各级
+    static void Close(SHStage* st, const RECT& r, std::vector<Point>& out) {
+        if (st[K].started) Edge(st, st[K].prev, st[K].first, r, out);
+        SHPipe<K + 1>::Close(st, r, out);
+    }
+};
+
+static void SH_ClipInto(const std::vector<Point>& poly, const RECT& r, std::vector<Point>& out) {
+    out.clear();
+    SHStage st[4] = {};
+    for (const Point& p : poly)
+        SHPipe<0>::Push(st, p, r, out);
+    SHPipe<0>::Close(st, r, out);
+}
+
 std::vector<Point> ClipPolygon_SutherlandHodgman(const std::vector<Point>& poly, const RECT& r) {
-    std::vector<Point> out = poly;
-    out = ClipWithEdge(out, 'L', r);
-    out = ClipWithEdge(out, 'R', r);
-    out = ClipWithEdge(out, 'T', r);
-    out = ClipWithEdge(out, 'B', r);
+    std::vector<Point> out;
+    out.reserve(poly.size() + 8);
+    SH_ClipInto(poly, r, out);
     return out;
 }
 
-// Sutherland-Hodgman 裁剪并返回多个多边形
+// 结果不连通时，SH 的输出由沿裁剪框边界来回重合的“桥”边连成一圈。
+// 边界上的边按方向带符号累计覆盖次数，来回抵消的部分就是桥；
+// 去掉后各点的出入边数仍然相等，把剩下的边重新连成各自闭合的多边形
+// 不在边界上的原边按输出顺序成段连接，只有段的首尾需要查找，查找量只与边界上的顶点数有关
+struct SHPath {
+    Point a, b;         // 起点、终点
+    int first;          // 原输出中连续一段边的起始下标；边界上的边为 -1
+    int count;          // 这一段的边数
+};
+
+struct SHScratch {
+    std::vector<Point> ring;                        // 流水线裁剪的输出
+    std::vector<std::pair<int, int>> marks[4];      // 左、右、上、下边界上的（位置, 覆盖次数变化）
+    std::vector<SHPath> paths;                      // 去掉桥后的各段有向路径
+    std::vector<std::pair<long long, int>> starts;  // （起点, 路径）按起点排序
+    std::vector<char> used;
+    std::vector<Point> piece;                       // 正在拼接的一块，拼完按实际大小拷出
+};
+
+// 有向边落在哪条框边上：0 左、1 右、2 上、3 下，不在边界上为 -1
+static int SH_BorderSide(const Point& a, const Point& b, const RECT& r) {
+    if (a.x == b.x && a.x == r.left) return 0;
+    if (a.x == b.x && a.x == r.right) return 1;
+    if (a.y == b.y && a.y == r.top) return 2;
+    if (a.y == b.y && a.y == r.bottom) return 3;
+    return -1;
+}
+
+static Point SH_BorderPoint(int side, int t, const RECT& r) {
+    switch (side) {
+    case 0: return { (int)r.left, t };
+    case 1: return { (int)r.right, t };
+    case 2: return { t, (int)r.top };
+    default: return { t, (int)r.bottom };
+    }
+}
+
+static long long SH_PointKey(const Point& p) {
+    return ((long long)p.x << 32) | (unsigned int)p.y;
+}
+
+static void SH_SplitBridges(SHScratch& sc, const RECT& r, std::vector<std::vector<Point>>& pieces) {
+    const std::vector<Point>& ring = sc.ring;
+    int n = (int)ring.size();
+    for (auto& m : sc.marks) m.clear();
+    long long borderLen = 0;
+    int lastBorder = -1;
+    for (int i = 0; i < n; ++i) {
+        const Point& a = ring[i];
+        const Point& b = ring[i + 1 < n ? i + 1 : 0];
+        if (a.x == b.x && a.y == b.y) continue;
+        int side = SH_BorderSide(a, b, r);
+        if (side < 0) continue;
+        lastBorder = i;
+        int ta = side < 2 ? a.y : a.x;
+        int tb = side < 2 ? b.y : b.x;
+        int d = ta < tb ? 1 : -1;
+        sc.marks[side].push_back({ (std::min)(ta, tb), d });
+        sc.marks[side].push_back({ (std::max)(ta, tb), -d });
+        borderLen += std::abs(tb - ta);
+    }
+
+    // 每条框边上覆盖次数不为 0 的区间才是真正的边界，方向由正负决定
+    sc.paths.clear();
+    long long netLen = 0;
+    for (int side = 0; side < 4; ++side) {
+        auto& m = sc.marks[side];
+        std::sort(m.begin(), m.end());
+        int cover = 0, runStart = 0;
+        for (size_t i = 0; i < m.size(); ) {
+            int t = m[i].first;
+            int next = cover;
+            for (; i < m.size() && m[i].first == t; ++i) next += m[i].second;
+            if (next == cover) continue;
+            if (cover != 0) {
+                Point lo = SH_BorderPoint(side, runStart, r);
+                Point hi = SH_BorderPoint(side, t, r);
+                for (int c = 0; c < std::abs(cover); ++c)
+                    sc.paths.push_back(cover > 0 ? SHPath{ lo, hi, -1, 1 } : SHPath{ hi, lo, -1, 1 });
+                netLen += (long long)std::abs(cover) * (t - runStart);
+            }
+            cover = next;
+            runStart = t;
+        }
+    }
+
+    // 没有来回抵消的边界：结果本就是一个多边形
+    if (netLen == borderLen) {
+        pieces.push_back(ring);
+        return;
+    }
+
+    // 从一条边界边之后开始，把连续的非边界边（含长度为 0 的边）归成一段
+    size_t borderPaths = sc.paths.size();
+    int runFirst = -1;
+    for (int k = 1; k <= n; ++k) {
+        int i = (lastBorder + k) % n;
+        const Point& a = ring[i];
+        const Point& b = ring[i + 1 < n ? i + 1 : 0];
+        bool keep = (a.x == b.x && a.y == b.y) || SH_BorderSide(a, b, r) < 0;
+        if (keep && runFirst < 0) runFirst = i;
+        if (!keep && runFirst >= 0) {
+            int count = (i - runFirst + n) % n;
+            sc.paths.push_back({ ring[runFirst], a, runFirst, count });
+            runFirst = -1;
+        }
+    }
+    // 原有的边在前，从它们开始走，各块的顶点顺序与原输出一致
+    std::rotate(sc.paths.begin(), sc.paths.begin() + borderPaths, sc.paths.end());
+
+    size_t count = sc.paths.size();
+    sc.starts.clear();
+    for (size_t i = 0; i < count; ++i)
+        sc.starts.push_back({ SH_PointKey(sc.paths[i].a), (int)i });
+    std::sort(sc.starts.begin(), sc.starts.end());
+    sc.used.assign(count, 0);
+    for (size_t p0 = 0; p0 < count; ++p0) {
+        if (sc.used[p0]) continue;
+        std::vector<Point>& piece = sc.piece;
+        piece.clear();
+        Point start = sc.paths[p0].a;
+        int p = (int)p0;
+        for (;;) {
+            sc.used[p] = 1;
+            const SHPath& path = sc.paths[p];
+            if (path.first < 0) {
+                piece.push_back(path.a);
+            }
+            else {
+                // 原输出中的 [first, first + count) 这些点，可能绕过数组末尾
+                int end = path.first + path.count;
+                piece.insert(piece.end(), ring.begin() + path.first, ring.begin() + (std::min)(end, n));
+                if (end > n) piece.insert(piece.end(), ring.begin(), ring.begin() + (end - n));
+            }
+            Point cur = path.b;
+            if (cur.x == start.x && cur.y == start.y) break;
+            long long key = SH_PointKey(cur);
+            auto it = std::lower_bound(sc.starts.begin(), sc.starts.end(), std::make_pair(key, -1));
+            p = -1;
+            for (; it != sc.starts.end() && it->first == key; ++it)
+                if (!sc.used[it->second]) { p = it->second; break; }
+            if (p < 0) break;
+        }
+        if (piece.size() >= 3)
+            pieces.emplace_back(piece.begin(), piece.end());
+    }
+}
+
+// Sutherland-Hodgman 裁剪并返回多个多边形：桥边拆开后每块单独成为一个多边形
 std::vector<std::vector<Point>> ClipPolygon_SutherlandHodgman_Multi(const std::vector<Point>& poly, const RECT& r) {
-    std::vector<Point> clipped = ClipPolygon_SutherlandHodgman(poly, r);
-    if (clipped.size() < 3) return {};
-    // 直接返回结果，不处理桥接边问题
-    return { clipped };
+    thread_local SHScratch scratch;
+    std::vector<std::vector<Point>> pieces;
+    SH_ClipInto(poly, r, scratch.ring);
+    if (scratch.ring.size() < 3) return pieces;
+    SH_SplitBridges(scratch, r, pieces);
+    return pieces;
 }
 
 // ============== Weiler-Atherton 完整实现 ==============
 
-// 顶点节点结构
-struct WAVertex {
+// 顶点节点：所有节点连续存放在一块数组里，链接用下标而不是指针
+struct WANode {
     double x, y;
+    int next;               // 在当前多边形链表中的下一个
+    int other;              // 另一个多边形链表中对应的交点节点，非交点为 -1
     bool isIntersection;    // 是否为交点
     bool isEntering;        // true=进入裁剪区, false=离开裁剪区
     bool visited;           // 遍历时是否已访问
-    WAVertex* next;         // 在当前多边形链表中的下一个
-    WAVertex* other;        // 指向另一个多边形链表中对应的交点节点
-    double t;               // 交点的参数位置（用于排序）
-    
-    WAVertex(double _x, double _y)
-        : x(_x), y(_y), isIntersection(false), isEntering(false),
-          visited(false), next(nullptr), other(nullptr), t(0) {}
+};
+
+// 一个交点在所在边上的位置（用于排序）
+struct WAHit {
+    int edge;
+    double t;
+    int node;
+};
+
+// 每次调用的临时空间；线程内复用，clear 后容量保留，稳定后裁剪不再分配
+struct WAScratch {
+    std::vector<WANode> nodes;
+    std::vector<WAHit> subjHits;    // 按 (主多边形边, t) 排序
+    std::vector<WAHit> clipHits;    // 按 (裁剪边, t) 排序
+    std::vector<Point> ring;        // 正在生成的结果多边形
 };
 
 // 判断点是否在矩形内部
@@ -277,15 +919,28 @@ static bool WA_LineIntersect(double x1, double y1, double x2, double y2,
     return false;
 }
 
-// 释放顶点链表
-static void WA_FreeList(WAVertex* head) {
-    if (!head) return;
-    WAVertex* curr = head;
-    do {
-        WAVertex* next = curr->next;
-        delete curr;
-        curr = next;
-    } while (curr && curr != head);
+static bool WA_HitLess(const WAHit& a, const WAHit& b) {
+    if (a.edge != b.edge) return a.edge < b.edge;
+    if (a.t != b.t) return a.t < b.t;
+    return a.node < b.node;
+}
+
+static void WA_AddNode(std::vector<WANode>& nodes, double x, double y, int next) {
+    nodes.push_back({ x, y, next, -1, false, false, false });
+}
+
+// 把排好序的交点逐边插入链表：每条边的交点串在该边起点之后
+static void WA_LinkHits(std::vector<WANode>& nodes, const std::vector<WAHit>& hits, int firstVertex) {
+    for (size_t k = 0; k < hits.size(); ) {
+        int curr = firstVertex + hits[k].edge;
+        int edge = hits[k].edge;
+        for (; k < hits.size() && hits[k].edge == edge; ++k) {
+            int inter = hits[k].node;
+            nodes[inter].next = nodes[curr].next;
+            nodes[curr].next = inter;
+            curr = inter;
+        }
+    }
 }
 
 // Weiler-Atherton 算法主函数 - 返回多个多边形
@@ -294,13 +949,6 @@ std::vector<std::vector<Point>> ClipPolygon_WeilerAtherton_Rect_Multi(const std:
     
     if (poly.size() < 3) return results;
     
-    // 创建裁剪矩形的四个顶点（顺时针）
-    std::vector<Point> clipPoly;
-    clipPoly.push_back({r.left, r.top});
-    clipPoly.push_back({r.right, r.top});
-    clipPoly.push_back({r.right, r.bottom});
-    clipPoly.push_back({r.left, r.bottom});
-    
     // 检查主多边形是否完全在裁剪区内
     bool allInside = true;
     for (const auto& p : poly) {
@@ -314,227 +962,136 @@ std::vector<std::vector<Point>> ClipPolygon_WeilerAtherton_Rect_Multi(const std:
         return results;
     }
     
-    // 检查主多边形是否完全在裁剪区外
-    bool allOutside = true;
-    for (const auto& p : poly) {
-        if (WA_PointInRect((double)p.x, (double)p.y, r)) {
-            allOutside = false;
-            break;
-        }
-    }
-    if (allOutside) {
-    }
+    // 裁剪矩形的四个顶点（顺时针）
+    const Point clipPoly[4] = { {r.left, r.top}, {r.right, r.top}, {r.right, r.bottom}, {r.left, r.bottom} };
+    const int n = (int)poly.size();
+    const int clipFirst = n;    // 节点 [0, n) 为主多边形顶点，[n, n + 4) 为裁剪矩形顶点，其后为交点对
     
-    // 构建主多边形的循环链表
-    WAVertex* subjHead = nullptr;
-    WAVertex* subjTail = nullptr;
-    std::vector<WAVertex*> subjVertices;
-    for (const auto& p : poly) {
-        WAVertex* v = new WAVertex((double)p.x, (double)p.y);
-        subjVertices.push_back(v);
-        if (!subjHead) {
-            subjHead = v;
-            subjTail = v;
-        } else {
-            subjTail->next = v;
-            subjTail = v;
-        }
-    }
-    subjTail->next = subjHead;
-    
-    // 构建裁剪多边形的循环链表
-    WAVertex* clipHead = nullptr;
-    WAVertex* clipTail = nullptr;
-    std::vector<WAVertex*> clipVertices;
-    for (const auto& p : clipPoly) {
-        WAVertex* v = new WAVertex((double)p.x, (double)p.y);
-        clipVertices.push_back(v);
-        if (!clipHead) {
-            clipHead = v;
-            clipTail = v;
-        } else {
-            clipTail->next = v;
-            clipTail = v;
-        }
-    }
-    clipTail->next = clipHead;
+    thread_local WAScratch scratch;
+    std::vector<WANode>& nodes = scratch.nodes;
+    std::vector<WAHit>& subjHits = scratch.subjHits;
+    std::vector<WAHit>& clipHits = scratch.clipHits;
+    nodes.clear();
+    subjHits.clear();
+    clipHits.clear();
     
-    // 存储所有交点，按主多边形边排序
-    std::vector<std::vector<std::pair<double, WAVertex*>>> subjIntersections(poly.size());
-    std::vector<std::vector<std::pair<double, WAVertex*>>> clipIntersections(clipPoly.size());
+    // 构建两个循环链表
+    for (int i = 0; i < n; i++)
+        WA_AddNode(nodes, (double)poly[i].x, (double)poly[i].y, (i + 1) % n);
+    for (int j = 0; j < 4; j++)
+        WA_AddNode(nodes, (double)clipPoly[j].x, (double)clipPoly[j].y, clipFirst + (j + 1) % 4);
     
     // 判断所有点，到底是出点还是入点
-    for (size_t i = 0; i < poly.size(); i++) {
-        size_t i2 = (i + 1) % poly.size();
+    for (int i = 0; i < n; i++) {
+        int i2 = (i + 1) % n;
         double sx1 = (double)poly[i].x, sy1 = (double)poly[i].y;
         double sx2 = (double)poly[i2].x, sy2 = (double)poly[i2].y;
         
-        for (size_t j = 0; j < clipPoly.size(); j++) {
-            size_t j2 = (j + 1) % clipPoly.size();
+        for (int j = 0; j < 4; j++) {
+            int j2 = (j + 1) % 4;
             double cx1 = (double)clipPoly[j].x, cy1 = (double)clipPoly[j].y;
             double cx2 = (double)clipPoly[j2].x, cy2 = (double)clipPoly[j2].y;
             
             double ix, iy, t1, t2;
             if (WA_LineIntersect(sx1, sy1, sx2, sy2, cx1, cy1, cx2, cy2, ix, iy, t1, t2)) {
-                // 创建两个交点节点
-                WAVertex* vSubj = new WAVertex(ix, iy);
-                WAVertex* vClip = new WAVertex(ix, iy);
-                vSubj->isIntersection = true;
-                vClip->isIntersection = true;
-                vSubj->t = t1;
-                vClip->t = t2;
-                vSubj->other = vClip;
-                vClip->other = vSubj;
-                
-                // 判断进入/离开
-                // 从主多边形边的方向向量和裁剪边的法向量计算
-                double dx = sx2 - sx1;
-                double dy = sy2 - sy1;
                 // 裁剪边的内法向量（指向矩形内部）
-                double cx = cx2 - cx1;
-                double cy = cy2 - cy1;
-                // 根据边界判断法向量方向
                 double nx, ny;
                 if (j == 0) { nx = 0; ny = 1; }       // 上边，内法向向下
                 else if (j == 1) { nx = -1; ny = 0; } // 右边，内法向向左
                 else if (j == 2) { nx = 0; ny = -1; } // 下边，内法向向上
                 else { nx = 1; ny = 0; }              // 左边，内法向向右
                 
-                double dot = dx * nx + dy * ny;
-                vSubj->isEntering = (dot > 0);
-                vClip->isEntering = !vSubj->isEntering;
+                // 从主多边形边的方向向量和裁剪边的法向量判断进入/离开
+                double dot = (sx2 - sx1) * nx + (sy2 - sy1) * ny;
                 
-                subjIntersections[i].push_back({t1, vSubj});
-                clipIntersections[j].push_back({t2, vClip});
+                // 创建两个交点节点，相邻存放
+                int vSubj = (int)nodes.size();
+                int vClip = vSubj + 1;
+                WA_AddNode(nodes, ix, iy, -1);
+                WA_AddNode(nodes, ix, iy, -1);
+                nodes[vSubj].isIntersection = nodes[vClip].isIntersection = true;
+                nodes[vSubj].other = vClip;
+                nodes[vClip].other = vSubj;
+                nodes[vSubj].isEntering = (dot > 0);
+                nodes[vClip].isEntering = !nodes[vSubj].isEntering;
+                
+                subjHits.push_back({ i, t1, vSubj });
+                clipHits.push_back({ j, t2, vClip });
             }
         }
     }
     
     // 如果没有交点
-    if (subjIntersections.empty() || 
-        std::all_of(subjIntersections.begin(), subjIntersections.end(),
-            [](const auto& v) { return v.empty(); })) {
-        // 释放资源
-        WA_FreeList(subjHead);
-        WA_FreeList(clipHead);
-        
-        if (allInside) {
-            results.push_back(poly);
-            return results;
-        }
-        return results;
-    }
+    if (subjHits.empty()) return results;
     
-    // 按参数t排序每条边上的交点
-    for (auto& v : subjIntersections) {
-        std::sort(v.begin(), v.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
-    }
-    for (auto& v : clipIntersections) {
-        std::sort(v.begin(), v.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
-    }
+    // 按参数t排序每条边上的交点；主多边形的交点已按边的顺序生成
+    std::sort(subjHits.begin(), subjHits.end(), WA_HitLess);
+    std::sort(clipHits.begin(), clipHits.end(), WA_HitLess);
     
-    // 将交点插入主多边形链表
-    for (size_t i = 0; i < poly.size(); i++) {
-        WAVertex* startV = subjVertices[i];
-        WAVertex* endV = startV->next;
-        WAVertex* curr = startV;
-        for (auto& p : subjIntersections[i]) {
-            WAVertex* inter = p.second;
-            inter->next = curr->next;
-            curr->next = inter;
-            curr = inter;
-        }
-    }
+    // 将交点插入两个链表
+    WA_LinkHits(nodes, subjHits, 0);
+    WA_LinkHits(nodes, clipHits, clipFirst);
     
-    // 将交点插入裁剪多边形链表
-    for (size_t j = 0; j < clipPoly.size(); j++) {
-        WAVertex* startV = clipVertices[j];
-        WAVertex* curr = startV;
-        for (auto& p : clipIntersections[j]) {
-            WAVertex* inter = p.second;
-            inter->next = curr->next;
-            curr->next = inter;
-            curr = inter;
+    // 按主多边形上的顺序查找下一个未访问的进入交点；已访问的不会复原，游标只需前进
+    size_t cursor = 0;
+    auto findNextEnteringPoint = [&]() -> int {
+        for (; cursor < subjHits.size(); cursor++) {
+            const WANode& v = nodes[subjHits[cursor].node];
+            if (v.isEntering && !v.visited)
+                return subjHits[cursor].node;
         }
-    }
-    
-    // 辅助函数：查找下一个未访问的进入交点
-    auto findNextEnteringPoint = [&subjIntersections]() -> WAVertex* {
-        for (size_t i = 0; i < subjIntersections.size(); i++) {
-            for (auto& p : subjIntersections[i]) {
-                if (p.second->isEntering && !p.second->visited) {
-                    return p.second;
-                }
-            }
-        }
-        return nullptr;
+        return -1;
     };
     
     // 遍历所有未访问的进入点，生成多个多边形
-    WAVertex* start = findNextEnteringPoint();
+    std::vector<Point>& result = scratch.ring;
+    const size_t limit = poly.size() * 4 + 10;
+    int start = findNextEnteringPoint();
     
-    while (start != nullptr) {
-        std::vector<Point> result;
+    while (start >= 0) {
+        result.clear();
         
         // 遍历生成一个结果多边形
-        WAVertex* curr = start;
+        int curr = start;
         bool onSubject = true;  // 当前在主多边形上遍历
         
         do {
-            result.push_back({(LONG)std::round(curr->x), (LONG)std::round(curr->y)});
-            curr->visited = true;
-            if (curr->other) curr->other->visited = true;
+            WANode& v = nodes[curr];
+            result.push_back({(LONG)std::round(v.x), (LONG)std::round(v.y)});
+            v.visited = true;
+            if (v.other >= 0) nodes[v.other].visited = true;
             
-            if (curr->isIntersection) {
+            if (v.isIntersection) {
                 // 切换到另一个多边形
-                if (curr->isEntering) {
+                if (v.isEntering) {
                     // 进入点：沿主多边形前进
                     onSubject = true;
                 } else {
                     // 离开点：切换到裁剪多边形
                     onSubject = false;
-                    curr = curr->other;
+                    curr = v.other;
                 }
             }
             
-            curr = curr->next;
+            curr = nodes[curr].next;
             
             // 如果遇到进入点但在裁剪多边形上，切回主多边形
-            if (curr->isIntersection && !onSubject && curr->other->isEntering) {
-                curr = curr->other;
+            if (nodes[curr].isIntersection && !onSubject && nodes[nodes[curr].other].isEntering) {
+                curr = nodes[curr].other;
                 onSubject = true;
             }
             
-        } while (curr != start && result.size() < poly.size() * 4 + 10);
+        } while (curr != start && result.size() < limit);
         
         // 如果生成的多边形有效（至少3个顶点），添加到结果列表
         if (result.size() >= 3) {
-            results.push_back(result);
+            results.emplace_back(result.begin(), result.end());
         }
         
         // 查找下一个未访问的进入点
         start = findNextEnteringPoint();
     }
     
-    // 如果没有生成任何多边形，检查是否有进入点（可能没有交点的情况已在前面处理）
-    if (results.empty()) {
-        // 释放资源并返回空
-    }
-    
-    // 清理内存
-    WAVertex* v = subjHead;
-    do {
-        WAVertex* next = v->next;
-        delete v;
-        v = next;
-    } while (v != subjHead);
-    
-    // 裁剪多边形的顶点已在上面释放（交点是共享的）
-    // 只释放非交点的裁剪顶点
-    for (WAVertex* cv : clipVertices) {
-        delete cv;
-    }
-    
     return results;
 }
 
@@ -546,7 +1103,7 @@ std::vector<Point> ClipPolygon_WeilerAtherton_Rect(const std::vector<Point>& pol
 }
 
 // 将矩形转换为4个顶点的多边形
-static std::vector<Point> RectToPolygon(const std::vector<Point>& v) {
+static std::vector<Point> RectToPolygon(const PointList& v) {
     if (v.size() < 2) return {};
     int x1 = (std::min)(v[0].x, v[1].x);
     int x2 = (std::max)(v[0].x, v[1].x);
@@ -555,72 +1112,166 @@ static std::vector<Point> RectToPolygon(const std::vector<Point>& v) {
     return {{x1, y1}, {x2, y1}, {x2, y2}, {x1, y2}};
 }
 
-void ClipAllPolygons_SH(const RECT& clip) {
-    std::vector<Shape> newShapes;
-    
-    for (auto& s : g_shapes) {
-        if (s.type == DrawMode::DrawPolygon) {
-            // 使用新的多多边形返回函数
-            auto clippedPolygons = ClipPolygon_SutherlandHodgman_Multi(s.vertices, clip);
-            for (auto& clippedPoly : clippedPolygons) {
-                if (clippedPoly.size() >= 3) {
-                    Shape ns = s;
-                    ns.vertices = clippedPoly;
-                    newShapes.push_back(ns);
-                }
-            }
-        } else if (s.type == DrawMode::DrawRectangle) {
-            // 将矩形转换为多边形再裁剪
-            std::vector<Point> rectPoly = RectToPolygon(s.vertices);
-            auto clippedPolygons = ClipPolygon_SutherlandHodgman_Multi(rectPoly, clip);
-            for (auto& clippedPoly : clippedPolygons) {
-                if (clippedPoly.size() >= 3) {
-                    Shape ns = s;
-                    ns.type = DrawMode::DrawPolygon;  // 裁剪后变成多边形
-                    ns.vertices = clippedPoly;
-                    newShapes.push_back(ns);
+// 圆转成内接正多边形：边数取到弦与圆弧的最大距离不超过半个像素
+static std::vector<Point> CircleToPolygon(const PointList& v) {
+    int r = CircleRadius(v);
+    if (r <= 0) return {};
+    double step = 2 * std::acos((std::max)(1 - 0.5 / r, -1.0));
+    int n = (std::max)(8, (int)std::ceil(CLIP_TWO_PI / step));
+    std::vector<Point> poly;
+    poly.reserve(n);
+    for (int k = 0; k < n; ++k) {
+        double a = CLIP_TWO_PI * k / n;
+        poly.push_back({ v[0].x + (int)std::lround(r * std::cos(a)), v[0].y + (int)std::lround(r * std::sin(a)) });
+    }
+    return poly;
+}
+
+// 取出闭合图形的各条轮廓（矩形先转成 4 顶点多边形，填充的圆转成正多边形）
+static void ShapeContours(const Shape& s, std::vector<std::vector<Point>>& out) {
+    out.clear();
+    if (s.type == DrawMode::DrawCircleMidpoint || s.type == DrawMode::DrawCircleBresenham) {
+        out.push_back(CircleToPolygon(s.vertices));
+    }
+    else if (s.type == DrawMode::DrawRectangle) {
+        out.push_back(RectToPolygon(s.vertices));
+    }
+    else if (s.type == DrawMode::DrawPolygon) {
+        out.emplace_back(s.vertices.begin(), s.vertices.end());
+    }
+    else if (s.type == DrawMode::DrawCompound) {
+        size_t start = 0;
+        for (int n : ShapeContourSizes(s)) {
+            if (n <= 0 || start + n > s.vertices.size()) break;
+            out.emplace_back(s.vertices.begin() + start, s.vertices.begin() + start + n);
+            start += n;
+        }
+    }
+}
+
+typedef std::vector<std::vector<Point>> (*PolygonClipFn)(const std::vector<Point>&, const RECT&);
+
+bool IsClosedShape(const Shape& s) {
+    if (s.type == DrawMode::DrawCircleMidpoint || s.type == DrawMode::DrawCircleBresenham)
+        return s.fillMode != 0;
+    return s.type == DrawMode::DrawPolygon || s.type == DrawMode::DrawRectangle ||
+        s.type == DrawMode::DrawCompound;
+}
+
+// 逐条轮廓裁剪，所有结果合成一个图形（多块时为复合路径），只需一次填充
+// 裁剪区是凸的，逐轮廓裁剪后按原填充规则仍能得到正确的洞
+// 完全在框内的多边形、复合路径与填充的圆原样保留；矩形仍照常转换成多边形
+static void ClipAllClosedShapes(const RECT& clip, PolygonClipFn clipFn) {
+    std::vector<char> cls;
+    ClassifyForClip(clip, cls);
+    ClipShapesParallel([&](int begin, int end, char* keep) {
+        thread_local std::vector<std::vector<Point>> contours, pieces;
+        for (int i = begin; i < end; ++i) {
+            Shape& s = g_shapes[i];
+            keep[i] = !IsClosedShape(s) || (cls[i] == CLIP_INSIDE && s.type != DrawMode::DrawRectangle);
+            if (keep[i] || cls[i] == CLIP_OUTSIDE) continue;
+            ShapeContours(s, contours);
+            pieces.clear();
+            for (auto& c : contours) {
+                auto clipped = clipFn(c, clip);
+                for (auto& poly : clipped) {
+                    if (poly.size() >= 3)
+                        pieces.push_back(std::move(poly));
                 }
             }
-        } else {
-            newShapes.push_back(s);
+            if (pieces.empty()) continue;
+            s = MakeContourShape(s, pieces);
+            keep[i] = 1;
         }
-    }
-    
-    g_shapes.swap(newShapes);
+    });
+}
+
+void ClipAllPolygons_SH(const RECT& clip) {
+    ClipAllClosedShapes(clip, ClipPolygon_SutherlandHodgman_Multi);
 }
 
 void ClipAllPolygons_WA(const RECT& clip) {
+    ClipAllClosedShapes(clip, ClipPolygon_WeilerAtherton_Rect_Multi);
+}
+
+// 布尔运算的结果轮廓互不交叉，洞是单独的轮廓，按奇偶规则填充
+static Shape MakeBooleanShape(const Shape& style, std::vector<std::vector<Point>>& pieces) {
+    Shape ns = MakeContourShape(style, pieces);
+    ns.fillRule = FillRule::EvenOdd;
+    return ns;
+}
+
+// 窗口包围盒之外的图形直接删去，其余按各自的填充规则与窗口求交
+void ClipAllPolygons_Window(const std::vector<Point>& window) {
+    if (window.size() < 3) return;
+    RECT bounds = { window[0].x, window[0].y, window[0].x, window[0].y };
+    for (const Point& p : window) {
+        bounds.left = (std::min)(bounds.left, (LONG)p.x);
+        bounds.top = (std::min)(bounds.top, (LONG)p.y);
+        bounds.right = (std::max)(bounds.right, (LONG)p.x);
+        bounds.bottom = (std::max)(bounds.bottom, (LONG)p.y);
+    }
+    std::vector<char> cls;
+    ClassifyForClip(bounds, cls);
+    const std::vector<std::vector<Point>> windowContours{ window };
+    ClipShapesParallel([&](int begin, int end, char* keep) {
+        thread_local std::vector<std::vector<Point>> contours, pieces;
+        for (int i = begin; i < end; ++i) {
+            Shape& s = g_shapes[i];
+            keep[i] = !IsClosedShape(s);
+            if (keep[i] || cls[i] == CLIP_OUTSIDE) continue;
+            ShapeContours(s, contours);
+            PolygonBoolean(contours, s.fillRule, windowContours, FillRule::EvenOdd, BooleanOp::Intersection, pieces);
+            if (pieces.empty()) continue;
+            s = MakeBooleanShape(s, pieces);
+            keep[i] = 1;
+        }
+    });
+}
+
+bool CombineShapes(const std::vector<int>& indices, BooleanOp op, int& result) {
+    result = -1;
+    std::vector<int> operands;
+    for (int i : indices)
+        if (i >= 0 && i < (int)g_shapes.size() && IsClosedShape(g_shapes[i]))
+            operands.push_back(i);
+    std::sort(operands.begin(), operands.end());
+    operands.erase(std::unique(operands.begin(), operands.end()), operands.end());
+    if (operands.size() < 2) return false;
+
+    // 依次运算：前面的结果已是互不交叉的轮廓，按奇偶规则参与下一次运算
+    std::vector<std::vector<Point>> acc, contours, next;
+    ShapeContours(g_shapes[operands[0]], acc);
+    FillRule accRule = g_shapes[operands[0]].fillRule;
+    for (size_t k = 1; k < operands.size(); ++k) {
+        const Shape& s = g_shapes[operands[k]];
+        ShapeContours(s, contours);
+        PolygonBoolean(acc, accRule, contours, s.fillRule, op, next);
+        acc.swap(next);
+        accRule = FillRule::EvenOdd;
+    }
+
     std::vector<Shape> newShapes;
-    
-    for (auto& s : g_shapes) {
-        if (s.type == DrawMode::DrawPolygon) {
-            // 使用新的多多边形返回函数
-            auto clippedPolygons = ClipPolygon_WeilerAtherton_Rect_Multi(s.vertices, clip);
-            for (auto& clippedPoly : clippedPolygons) {
-                if (clippedPoly.size() >= 3) {
-                    Shape ns = s;
-                    ns.vertices = clippedPoly;
-                    newShapes.push_back(ns);
-                }
-            }
-        } else if (s.type == DrawMode::DrawRectangle) {
-            // 将矩形转换为多边形再裁剪
-            std::vector<Point> rectPoly = RectToPolygon(s.vertices);
-            auto clippedPolygons = ClipPolygon_WeilerAtherton_Rect_Multi(rectPoly, clip);
-            for (auto& clippedPoly : clippedPolygons) {
-                if (clippedPoly.size() >= 3) {
-                    Shape ns = s;
-                    ns.type = DrawMode::DrawPolygon;  // 裁剪后变成多边形
-                    ns.vertices = clippedPoly;
-                    newShapes.push_back(ns);
-                }
+    newShapes.reserve(g_shapes.size());
+    size_t k = 1;
+    for (int i = 0; i < (int)g_shapes.size(); ++i) {
+        if (i == operands[0]) {
+            if (!acc.empty()) {
+                result = (int)newShapes.size();
+                newShapes.push_back(MakeBooleanShape(g_shapes[i], acc));
             }
-        } else {
-            newShapes.push_back(s);
+            continue;
+        }
+        if (k < operands.size() && operands[k] == i) {
+            k++;
+            continue;
         }
+        newShapes.push_back(std::move(g_shapes[i]));
     }
-    
+
     g_shapes.swap(newShapes);
+    RebuildShapeIndex(g_shapeIndex, g_shapes);
+    return true;
 }
 
-} 
+}
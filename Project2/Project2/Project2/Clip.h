@@ -1,6 +1,7 @@
 #pragma once
 
-#include "GraphicsState.h"
+#include "ShapeList.h"
+#include "PolygonBoolean.h"
 #include <utility>
 
 namespace GraphicsEngine {
@@ -11,20 +12,26 @@ bool CohenSutherlandClip(double& x1, double& y1, double& x2, double& y2,
     double xmin, double xmax, double ymin, double ymax);
 void ClipAllLines_CohenSutherland(const RECT& clip);
 
+// Liang-Barsky 线段裁剪（批量 SIMD，见 LineClip.h）
+void ClipAllLines_LiangBarsky(const RECT& clip);
+
 // 中点分割法线段裁剪
 bool InsideRect(double x, double y, double xmin, double xmax, double ymin, double ymax);
-void MidClipLineRec(double x1, double y1, double x2, double y2,
-    double xmin, double xmax, double ymin, double ymax,
-    int depth,
-    std::vector<std::pair<Point, Point>>& outSegs);
+// 在原线段的步号区间 [first, last]（last < 0 为整条）内找出框内的一段，可见时改写区间并返回 true
+bool MidpointClipLine(const Point& p1, const Point& p2, const RECT& r, int& first, int& last);
 void ClipAllLines_Midpoint(const RECT& clip);
 
+// 圆、圆弧与 B 样条按描边裁剪，结果仍是曲线：圆与圆弧换成框内的圆弧，
+// B 样条在与框边界的交点处截断，被截断的段换成等价的控制点；填充的圆是区域，留给多边形裁剪
+void ClipAllCurves(const RECT& clip);
+
 // Sutherland-Hodgman 多边形裁剪
 Point IntersectEdge(const Point& p1, const Point& p2, char edge, const RECT& r);
 bool InsideEdge(const Point& p, char edge, const RECT& r);
 std::vector<Point> ClipWithEdge(const std::vector<Point>& poly, char edge, const RECT& r);
+// 四条边流水线处理，不生成中间数组；不连通时各块由框边界上的桥边连成一圈
 std::vector<Point> ClipPolygon_SutherlandHodgman(const std::vector<Point>& poly, const RECT& r);
-// 返回多个多边形（处理不连通的裁剪结果）
+// 返回多个多边形：去掉桥边，不连通的裁剪结果拆成各自独立的多边形
 std::vector<std::vector<Point>> ClipPolygon_SutherlandHodgman_Multi(const std::vector<Point>& poly, const RECT& r);
 
 // Weiler-Atherton 多边形裁剪
@@ -33,8 +40,18 @@ std::vector<std::vector<Point>> ClipPolygon_WeilerAtherton_Rect_Multi(const std:
 // 兼容旧接口，只返回第一个多边形
 std::vector<Point> ClipPolygon_WeilerAtherton_Rect(const std::vector<Point>& poly, const RECT& r);
 
+// 按区域裁剪的闭合图形：多边形、矩形、复合路径与填充的圆（裁剪后换成多边形）
+bool IsClosedShape(const Shape& s);
+
 // 对所有图形执行裁剪
 void ClipAllPolygons_SH(const RECT& clip);
 void ClipAllPolygons_WA(const RECT& clip);
 
+// 任意多边形窗口裁剪（扫描线布尔运算，见 PolygonBoolean.h）：所有闭合图形与窗口（奇偶规则）求交
+void ClipAllPolygons_Window(const std::vector<Point>& window);
+// 图形间的布尔运算：indices 中的闭合图形按下标顺序依次运算，结果替换下标最小的一个，
+// 其余参与运算的图形删去；result 为结果图形的新下标，结果为空时为 -1
+// 参与运算的闭合图形不足两个时不做改动，返回 false
+bool CombineShapes(const std::vector<int>& indices, BooleanOp op, int& result);
+
 } // namespace GraphicsEngine
@@ -0,0 +1,454 @@
+#include "CommandBuffer.h"
+#include "Fill.h"
+#include "DamageRegion.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace GraphicsEngine {
+
+static DrawCommand MakeCommand(CommandOp op, COLORREF color, int a, int b, int c, int d) {
+    DrawCommand cmd;
+    cmd.op = op;
+    cmd.mode = DrawMode::None;
+    cmd.rule = FillRule::EvenOdd;
+    cmd.color = color;
+    cmd.a = a; cmd.b = b; cmd.c = c; cmd.d = d;
+    cmd.first = 0;
+    cmd.count = 0;
+    cmd.spans = nullptr;
+    return cmd;
+}
+
+static void EmitLine(CommandBuffer& cb, DrawMode mode, const Point& p, const Point& q, COLORREF c) {
+    DrawCommand cmd = MakeCommand(CommandOp::Line, c, p.x, p.y, q.x, q.y);
+    cmd.mode = mode;
+    cb.commands.push_back(cmd);
+}
+
+// 把 et 中的边排好序后移入边池，生成一条多边形填充命令
+static void EmitEdges(CommandBuffer& cb, EdgeTable& et, CommandOp op, COLORREF c, FillRule rule, int fenceX) {
+    if (et.edges.empty()) return;
+    SortEdges(et);
+    DrawCommand cmd = MakeCommand(op, c, fenceX, 0, 0, 0);
+    cmd.rule = rule;
+    cmd.first = (int)cb.edges.size();
+    cmd.count = (int)et.edges.size();
+    cb.edges.insert(cb.edges.end(), et.edges.begin(), et.edges.end());
+    cb.commands.push_back(cmd);
+}
+
+// 与 FillShapeScanline / FillShapeFence 相同的填充
+static void CompileFill(CommandBuffer& cb, const Shape& s, EdgeTable& et) {
+    const auto& v = s.vertices;
+    if (v.size() < 2) return;
+    bool fence = s.fillMode == 2;
+    COLORREF c = fence ? FenceXorColor(s.fillColor) : s.fillColor;
+
+    switch (s.type) {
+    case DrawMode::DrawRectangle:
+        cb.commands.push_back(MakeCommand(fence ? CommandOp::FenceRect : CommandOp::FillRect, c,
+            (std::min)(v[0].x, v[1].x), (std::min)(v[0].y, v[1].y),
+            (std::max)(v[0].x, v[1].x), (std::max)(v[0].y, v[1].y)));
+        break;
+    case DrawMode::DrawCircleMidpoint:
+    case DrawMode::DrawCircleBresenham:
+        cb.commands.push_back(MakeCommand(fence ? CommandOp::FenceCircle : CommandOp::FillCircle, c,
+            v[0].x, v[0].y, CircleRadius(v), 0));
+        break;
+    case DrawMode::DrawPolygon:
+    case DrawMode::DrawCompound: {
+        if (v.size() < 3) return;
+        ResetEdgeTable(et);
+        FillRule rule = FillRule::EvenOdd;
+        if (s.type == DrawMode::DrawPolygon) {
+            AddContour(et, v.data(), v.size());
+        }
+        else {
+            rule = s.fillRule;
+            size_t start = 0;
+            for (int n : ShapeContourSizes(s)) {
+                if (n <= 0 || start + n > v.size()) break;
+                if (n >= 3) AddContour(et, v.data() + start, (size_t)n);
+                start += n;
+            }
+        }
+        int minX = v[0].x;
+        for (auto& p : v) minX = (std::min)(minX, p.x);
+        EmitEdges(cb, et, fence ? CommandOp::FenceEdges : CommandOp::FillEdges, c, rule, minX - 1);
+    } break;
+    default:
+        break;
+    }
+}
+
+// 与 DrawShapeBorder 相同的描边；矩形、多边形、复合路径、B 样条都展开为直线段
+// 圆弧的起止方向点移入弧池
+static void CompileBorder(CommandBuffer& cb, const Shape& s) {
+    const auto& v = s.vertices;
+    if (v.size() < 2) return;
+    COLORREF c = s.color;
+
+    switch (s.type) {
+    case DrawMode::DrawLineMidpoint:
+    case DrawMode::DrawLineBresenham:
+    case DrawMode::DrawLineRunSlice: {
+        EmitLine(cb, s.type, v[0], v[1], c);
+        LineSteps steps = ShapeLineSteps(s);
+        if (steps.last >= 0) {
+            cb.commands.back().first = steps.first;
+            cb.commands.back().count = steps.last - steps.first + 1;
+        }
+    } break;
+    case DrawMode::DrawCircleMidpoint:
+    case DrawMode::DrawCircleBresenham: {
+        DrawCommand cmd = MakeCommand(CommandOp::Circle, c, v[0].x, v[0].y, CircleRadius(v), 0);
+        cmd.mode = s.type;
+        cb.commands.push_back(cmd);
+    } break;
+    case DrawMode::DrawArc: {
+        DrawCommand cmd = MakeCommand(CommandOp::Arc, c, v[0].x, v[0].y, CircleRadius(v), 0);
+        cmd.first = (int)cb.arcs.size();
+        cmd.count = (int)v.size() - 2;
+        cb.arcs.insert(cb.arcs.end(), v.begin() + 2, v.end());
+        cb.commands.push_back(cmd);
+    } break;
+    case DrawMode::DrawRectangle: {
+        int x1 = (std::min)(v[0].x, v[1].x);
+        int x2 = (std::max)(v[0].x, v[1].x);
+        int y1 = (std::min)(v[0].y, v[1].y);
+        int y2 = (std::max)(v[0].y, v[1].y);
+        EmitLine(cb, DrawMode::DrawLineMidpoint, { x1, y1 }, { x2, y1 }, c);
+        EmitLine(cb, DrawMode::DrawLineMidpoint, { x2, y1 }, { x2, y2 }, c);
+        EmitLine(cb, DrawMode::DrawLineMidpoint, { x2, y2 }, { x1, y2 }, c);
+        EmitLine(cb, DrawMode::DrawLineMidpoint, { x1, y2 }, { x1, y1 }, c);
+    } break;
+    case DrawMode::DrawPolygon:
+        for (size_t i = 0; i + 1 < v.size(); ++i)
+            EmitLine(cb, DrawMode::DrawLineMidpoint, v[i], v[i + 1], c);
+        EmitLine(cb, DrawMode::DrawLineMidpoint, v.back(), v.front(), c);
+        break;
+    case DrawMode::DrawBSpline: {
+        Point pts[BSPLINE_SEGMENT_MAX_POINTS];
+        ForEachBSplinePiece(s, [&](const Point* ctrl, size_t count) {
+            for (size_t i = 0; i + 3 < count; ++i) {
+                int n = BSplineSegmentPoints(&ctrl[i], pts);
+                for (int k = 1; k < n; ++k)
+                    EmitLine(cb, DrawMode::DrawLineMidpoint, pts[k - 1], pts[k], c);
+            }
+        });
+    } break;
+    case DrawMode::DrawCompound: {
+        size_t start = 0;
+        for (int n : ShapeContourSizes(s)) {
+            if (n <= 0 || start + n > v.size()) break;
+            for (int i = 0; i < n; ++i)
+                EmitLine(cb, DrawMode::DrawLineMidpoint, v[start + i], v[start + (i + 1) % n], c);
+            start += n;
+        }
+    } break;
+    default:
+        break;
+    }
+}
+
+// 光栅化用的暂存表面上限（像素数），更大的图形不缓存，仍按命令绘制
+static const long long SPAN_CACHE_MAX_AREA = 2048LL * 2048LL;
+
+static bool SpanCacheable(const Shape& s) {
+    if (ShapeRasterKey(s) == 0) return false;
+    switch (s.type) {
+    case DrawMode::DrawRectangle:
+    case DrawMode::DrawCircleMidpoint:
+    case DrawMode::DrawCircleBresenham:
+    case DrawMode::DrawArc:
+    case DrawMode::DrawPolygon:
+    case DrawMode::DrawCompound:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 把暂存表面上的非零像素按行收集成像素段，(ox, oy) 为暂存表面原点对应的坐标
+static void CollectRuns(const PixelSurface& surf, int ox, int oy, std::vector<SpanRun>& out) {
+    for (int y = 0; y < surf.height; ++y) {
+        const uint32_t* row = SurfaceRow(surf, y);
+        int x = 0;
+        while (x < surf.width) {
+            if (!row[x]) { ++x; continue; }
+            int x0 = x;
+            while (x < surf.width && row[x]) ++x;
+            out.push_back({ y + oy, x0 + ox, x - 1 + ox });
+        }
+    }
+}
+
+// 把图形移到暂存表面左上角，分别画填充与描边，再收集覆盖到的像素
+// 直线、圆、边表的步进都只依赖坐标差，整数平移前后光栅化结果逐像素一致
+static bool RasterizeSpans(const Shape& s, const RECT& bounds, ShapeSpans& out) {
+    long long w = bounds.right - bounds.left, h = bounds.bottom - bounds.top;
+    if (w <= 0 || h <= 0 || w * h > SPAN_CACHE_MAX_AREA) return false;
+    Shape local = s;
+    for (auto& p : local.vertices) {
+        p.x -= bounds.left;
+        p.y -= bounds.top;
+    }
+    local.color = RGB(255, 255, 255);
+
+    thread_local HeapSurface scratch;
+    CreateHeapSurface(scratch, (int)w, (int)h);
+    PixelSurface& surf = scratch.surface;
+    Point offset = ShapeRasterOffset(s);
+    int ox = bounds.left - offset.x;
+    int oy = bounds.top - offset.y;
+    out.fillMode = s.fillMode;
+    if (s.fillMode == 1 || s.fillMode == 2) {
+        ClearSurface(surf, RGB(0, 0, 0));
+        if (s.fillMode == 1)
+            FillShapeScanline(surf, local, RGB(255, 255, 255));
+        else
+            FillShapeFence(surf, local, RGB(0, 0, 0));     // 异或色为白色
+        CollectRuns(surf, ox, oy, out.fill);
+    }
+    ClearSurface(surf, RGB(0, 0, 0));
+    DrawShapeBorder(surf, local);
+    CollectRuns(surf, ox, oy, out.border);
+    return true;
+}
+
+// 取图形的光栅覆盖缓存，没有则现场光栅化；不适合缓存时返回 nullptr
+static const ShapeSpans* CachedSpans(CommandBuffer& cb, const Shape& s, const RECT& bounds) {
+    if (!SpanCacheable(s)) return nullptr;
+    auto it = cb.spanCache.find(ShapeRasterKey(s));
+    if (it != cb.spanCache.end())
+        return it->second.fillMode == s.fillMode ? &it->second : nullptr;
+    ShapeSpans spans;
+    if (!RasterizeSpans(s, bounds, spans)) return nullptr;
+    cb.rasterizedLastUpdate++;
+    return &cb.spanCache.emplace(ShapeRasterKey(s), std::move(spans)).first->second;
+}
+
+static void EmitSpans(CommandBuffer& cb, const Shape& s, const ShapeSpans& spans) {
+    Point offset = ShapeRasterOffset(s);
+    int dx = offset.x, dy = offset.y;
+    if (!spans.fill.empty()) {
+        bool fence = s.fillMode == 2;
+        DrawCommand cmd = MakeCommand(fence ? CommandOp::XorSpans : CommandOp::FillSpans,
+            fence ? FenceXorColor(s.fillColor) : s.fillColor, dx, dy, 0, 0);
+        cmd.spans = &spans.fill;
+        cb.commands.push_back(cmd);
+    }
+    if (!spans.border.empty()) {
+        DrawCommand cmd = MakeCommand(CommandOp::FillSpans, s.color, dx, dy, 0, 0);
+        cmd.spans = &spans.border;
+        cb.commands.push_back(cmd);
+    }
+}
+
+static void CompileShape(CommandBuffer& cb, const Shape& s, EdgeTable& et) {
+    CompiledShape cs;
+    cs.revision = s.revision;
+    cs.visible = ShapeBounds(s, cs.bounds);
+    cs.firstCommand = (int)cb.commands.size();
+    const ShapeSpans* spans = cs.visible ? CachedSpans(cb, s, cs.bounds) : nullptr;
+    if (spans) {
+        EmitSpans(cb, s, *spans);
+    }
+    else {
+        if (s.fillMode == 1 || s.fillMode == 2)
+            CompileFill(cb, s, et);
+        CompileBorder(cb, s);
+    }
+    cs.commandCount = (int)cb.commands.size() - cs.firstCommand;
+    cb.shapes.push_back(cs);
+}
+
+// 把旧缓冲中一个图形的命令连同它引用的边、弧拷到新缓冲
+static void CopyCompiledShape(CommandBuffer& dst, const CommandBuffer& src, const CompiledShape& cs) {
+    CompiledShape out = cs;
+    out.firstCommand = (int)dst.commands.size();
+    for (int i = 0; i < cs.commandCount; ++i) {
+        DrawCommand cmd = src.commands[cs.firstCommand + i];
+        if (cmd.op == CommandOp::FillEdges || cmd.op == CommandOp::FenceEdges) {
+            int first = (int)dst.edges.size();
+            dst.edges.insert(dst.edges.end(), src.edges.begin() + cmd.first,
+                src.edges.begin() + cmd.first + cmd.count);
+            cmd.first = first;
+        }
+        else if (cmd.op == CommandOp::Arc) {
+            int first = (int)dst.arcs.size();
+            dst.arcs.insert(dst.arcs.end(), src.arcs.begin() + cmd.first,
+                src.arcs.begin() + cmd.first + cmd.count);
+            cmd.first = first;
+        }
+        dst.commands.push_back(cmd);
+    }
+    dst.shapes.push_back(out);
+}
+
+void UpdateCommandBuffer(CommandBuffer& cb, const ShapeStore& shapes) {
+    size_t count = ShapeCount(shapes);
+    CommandBuffer next;
+    next.shapes.reserve(count);
+    next.commands.reserve(cb.commands.size());
+    next.edges.reserve(cb.edges.size());
+    // 像素段缓存整体移交（结点地址不变，旧命令里的指针仍然有效），最后剔除不再使用的
+    next.spanCache.swap(cb.spanCache);
+    std::unordered_set<unsigned long long> liveKeys;
+    EdgeTable et;
+    Shape s;
+
+    // 图形表中间插入或删除后下标会错位，此时按版本号查找旧的编译结果
+    std::unordered_map<unsigned long long, int> byRevision;
+    bool indexed = false;
+    // 只扫描版本号一列，需要重新编译时才取出整个图形
+    for (size_t i = 0; i < count; ++i) {
+        unsigned long long revision = shapes.revisions[i];
+        unsigned long long key = StoreRasterKey(shapes, i);
+        if (key != 0) liveKeys.insert(key);
+        int old = -1;
+        if (revision != 0) {
+            if (i < cb.shapes.size() && cb.shapes[i].revision == revision) {
+                old = (int)i;
+            }
+            else {
+                if (!indexed) {
+                    for (size_t k = 0; k < cb.shapes.size(); ++k)
+                        if (cb.shapes[k].revision != 0) byRevision[cb.shapes[k].revision] = (int)k;
+                    indexed = true;
+                }
+                auto it = byRevision.find(revision);
+                if (it != byRevision.end()) old = it->second;
+            }
+        }
+        if (old >= 0) {
+            CopyCompiledShape(next, cb, cb.shapes[old]);
+        }
+        else {
+            LoadShape(shapes, i, s);
+            CompileShape(next, s, et);
+            next.compiledLastUpdate++;
+        }
+    }
+    for (auto it = next.spanCache.begin(); it != next.spanCache.end();) {
+        if (liveKeys.count(it->first)) ++it;
+        else it = next.spanCache.erase(it);
+    }
+    cb.shapes.swap(next.shapes);
+    cb.commands.swap(next.commands);
+    cb.edges.swap(next.edges);
+    cb.arcs.swap(next.arcs);
+    cb.spanCache.swap(next.spanCache);
+    cb.compiledLastUpdate = next.compiledLastUpdate;
+    cb.rasterizedLastUpdate = next.rasterizedLastUpdate;
+}
+
+// 按行号二分跳过裁剪区上方的段，逐段写入到裁剪区下方为止
+static void ReplaySpans(PixelSurface& surf, const std::vector<SpanRun>& spans, int dx, int dy,
+    COLORREF c, bool xorMode) {
+    uint32_t px = ColorToPixel(c);
+    auto it = std::lower_bound(spans.begin(), spans.end(), surf.clipTop - dy,
+        [](const SpanRun& r, int y) { return r.y < y; });
+    int yEnd = surf.clipBottom - dy;
+    for (; it != spans.end() && it->y < yEnd; ++it) {
+        if (it->x1 + dx < surf.clipLeft || it->x0 + dx >= surf.clipRight) continue;
+        if (xorMode)
+            XorSpan(surf, it->y + dy, it->x0 + dx, it->x1 + dx, px);
+        else
+            FillSpan(surf, it->y + dy, it->x0 + dx, it->x1 + dx, px);
+    }
+}
+
+static void ReplayCommand(PixelSurface& surf, const CommandBuffer& cb, const DrawCommand& cmd, EdgeTable& et) {
+    switch (cmd.op) {
+    case CommandOp::Line:
+        if (cmd.count > 0) {
+            int last = cmd.first + cmd.count - 1;
+            if (cmd.mode == DrawMode::DrawLineBresenham)
+                DrawLineBresenhamSteps(surf, cmd.a, cmd.b, cmd.c, cmd.d, cmd.first, last, cmd.color);
+            else if (cmd.mode == DrawMode::DrawLineRunSlice)
+                DrawLineRunSliceSteps(surf, cmd.a, cmd.b, cmd.c, cmd.d, cmd.first, last, cmd.color);
+            else
+                DrawLineMidpointSteps(surf, cmd.a, cmd.b, cmd.c, cmd.d, cmd.first, last, cmd.color);
+        }
+        else if (cmd.mode == DrawMode::DrawLineBresenham)
+            DrawLineBresenham(surf, cmd.a, cmd.b, cmd.c, cmd.d, cmd.color);
+        else if (cmd.mode == DrawMode::DrawLineRunSlice)
+            DrawLineRunSlice(surf, cmd.a, cmd.b, cmd.c, cmd.d, cmd.color);
+        else
+            DrawLineMidpoint(surf, cmd.a, cmd.b, cmd.c, cmd.d, cmd.color);
+        break;
+    case CommandOp::Circle:
+        if (cmd.mode == DrawMode::DrawCircleBresenham)
+            DrawCircleBresenham(surf, cmd.a, cmd.b, cmd.c, cmd.color);
+        else
+            DrawCircleMidpoint(surf, cmd.a, cmd.b, cmd.c, cmd.color);
+        break;
+    case CommandOp::Arc:
+        DrawArcMidpoint(surf, cmd.a, cmd.b, cmd.c, cb.arcs.data() + cmd.first, (size_t)cmd.count, cmd.color);
+        break;
+    case CommandOp::FillRect:
+        FillRectScanline(surf, { cmd.a, cmd.b }, { cmd.c, cmd.d }, cmd.color, false);
+        break;
+    case CommandOp::FenceRect:
+        FenceFillRect(surf, { cmd.a, cmd.b }, { cmd.c, cmd.d }, cmd.color);
+        break;
+    case CommandOp::FillCircle:
+        FillCircleRadius(surf, cmd.a, cmd.b, cmd.c, cmd.color);
+        break;
+    case CommandOp::FenceCircle:
+        FenceFillCircleRadius(surf, cmd.a, cmd.b, cmd.c, cmd.color);
+        break;
+    case CommandOp::FillEdges:
+    case CommandOp::FenceEdges:
+        et.edges.assign(cb.edges.begin() + cmd.first, cb.edges.begin() + cmd.first + cmd.count);
+        if (cmd.op == CommandOp::FillEdges)
+            FillSortedEdges(surf, et, cmd.color, cmd.rule);
+        else
+            FenceFillSortedEdges(surf, et, cmd.a, cmd.color, cmd.rule);
+        break;
+    case CommandOp::FillSpans:
+    case CommandOp::XorSpans:
+        ReplaySpans(surf, *cmd.spans, cmd.a, cmd.b, cmd.color, cmd.op == CommandOp::XorSpans);
+        break;
+    }
+}
+
+void ReplayShapeCommands(PixelSurface& surf, const CommandBuffer& cb, int index) {
+    // 分块绘制时各线程各用一份边表，重放过程中不再分配内存
+    thread_local EdgeTable et;
+    const CompiledShape& cs = cb.shapes[index];
+    for (int i = 0; i < cs.commandCount; ++i)
+        ReplayCommand(surf, cb, cb.commands[cs.firstCommand + i], et);
+}
+
+void ReplayCommands(PixelSurface& surf, const CommandBuffer& cb, const std::vector<int>* skip) {
+    RECT clip = { surf.clipLeft, surf.clipTop, surf.clipRight, surf.clipBottom };
+    size_t next = 0;    // skip 中下一个要跳过的位置
+    for (size_t i = 0; i < cb.shapes.size(); ++i) {
+        const CompiledShape& cs = cb.shapes[i];
+        while (skip && next < skip->size() && (*skip)[next] < (int)i) ++next;
+        if (skip && next < skip->size() && (*skip)[next] == (int)i) continue;
+        if (!cs.visible || !RectsOverlap(cs.bounds, clip)) continue;
+        ReplayShapeCommands(surf, cb, (int)i);
+    }
+}
+
+bool ReplayCachedShape(PixelSurface& surf, const CommandBuffer& cb, const Shape& s) {
+    if (!SpanCacheable(s)) return false;
+    auto it = cb.spanCache.find(ShapeRasterKey(s));
+    if (it == cb.spanCache.end() || it->second.fillMode != s.fillMode) return false;
+    const ShapeSpans& spans = it->second;
+    Point offset = ShapeRasterOffset(s);
+    int dx = offset.x, dy = offset.y;
+    if (s.fillMode == 2)
+        ReplaySpans(surf, spans.fill, dx, dy, FenceXorColor(s.fillColor), true);
+    else
+        ReplaySpans(surf, spans.fill, dx, dy, s.fillColor, false);
+    ReplaySpans(surf, spans.border, dx, dy, s.color, false);
+    return true;
+}
+
+} // namespace GraphicsEngine
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "EdgeTable.h"
+#include "Shapes.h"
+#include "ShapeStore.h"
+
+namespace GraphicsEngine {
+
+// 保留模式命令缓冲：图形表编译成一串参数已解析好的绘制命令（半径、矩形角点、
+// 多边形排好序的边表都预先算好），重绘时直接重放，不再按 DrawMode 分派
+// 矩形、圆、圆弧、多边形、复合路径进一步光栅化成按行的像素段缓存，重放时只剩逐段写入
+
+// 光栅覆盖的一段：第 y 行的 [x0, x1]（闭区间）
+struct SpanRun {
+    int y, x0, x1;
+};
+
+// 一个图形的光栅覆盖，按 y 升序；坐标是图形累计平移 (ShapeRasterOffset) 为 (0, 0) 时的位置
+struct ShapeSpans {
+    int fillMode;
+    std::vector<SpanRun> fill;      // 扫描线填充的像素；栅栏填充时为被异或奇数次的像素
+    std::vector<SpanRun> border;
+};
+
+enum class CommandOp : unsigned char {
+    Line,           // (a, b) - (c, d)，mode 为直线算法；count > 0 时只画步号 [first, first + count)
+    Circle,         // 圆心 (a, b)，半径 c，mode 为画圆算法
+    Arc,            // 圆心 (a, b)，半径 c，弧的起止方向点为弧池 [first, first + count)
+    FillRect,       // 规范化后的角点 (a, b) - (c, d)
+    FenceRect,
+    FillCircle,     // 圆心 (a, b)，半径 c
+    FenceCircle,
+    FillEdges,      // 边池 [first, first + count)，已按 yTop 排序
+    FenceEdges,     // 同上，a 为栅栏 x
+    FillSpans,      // spans 中的像素段平移 (a, b) 后写入
+    XorSpans        // 同上，异或写入
+};
+
+struct DrawCommand {
+    CommandOp op;
+    DrawMode mode;
+    FillRule rule;
+    COLORREF color;     // 栅栏填充为异或色
+    int a, b, c, d;
+    int first, count;
+    const std::vector<SpanRun>* spans;
+};
+
+// 一个图形编译出的命令范围
+struct CompiledShape {
+    unsigned long long revision;
+    RECT bounds;        // 同 ShapeBounds
+    bool visible;
+    int firstCommand;
+    int commandCount;
+};
+
+struct CommandBuffer {
+    std::vector<CompiledShape> shapes;      // 与图形表一一对应
+    std::vector<DrawCommand> commands;
+    std::vector<ETEdge> edges;
+    std::vector<Point> arcs;                // 圆弧命令的起止方向点
+    // 按光栅缓存键（ShapeRasterKey）索引的光栅覆盖；只保留当前图形表仍在用的
+    std::unordered_map<unsigned long long, ShapeSpans> spanCache;
+    int compiledLastUpdate = 0;             // 上次更新中实际重新编译的图形数
+    int rasterizedLastUpdate = 0;           // 其中重新光栅化的图形数（平移过的图形复用缓存）
+};
+
+// 按图形表更新命令缓冲：版本号未变的图形直接复用已编译的命令，只编译改动过的图形
+void UpdateCommandBuffer(CommandBuffer& cb, const ShapeStore& shapes);
+// 重放单个图形的命令（与 RenderShape 逐像素一致）
+void ReplayShapeCommands(PixelSurface& surf, const CommandBuffer& cb, int index);
+// 按顺序重放所有与表面裁剪区相交的图形，skip 中的图形不画（下标升序）
+void ReplayCommands(PixelSurface& surf, const CommandBuffer& cb, const std::vector<int>* skip = nullptr);
+// 用缓存的像素段绘制一个不在命令缓冲中的图形（如拖动预览）；没有可用缓存时返回 false
+bool ReplayCachedShape(PixelSurface& surf, const CommandBuffer& cb, const Shape& s);
+
+} // namespace GraphicsEngine
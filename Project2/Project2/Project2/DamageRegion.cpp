@@ -0,0 +1,82 @@
+#include "DamageRegion.h"
+#include <algorithm>
+
+namespace GraphicsEngine {
+
+static bool RectEmpty(const RECT& rc) {
+    return rc.left >= rc.right || rc.top >= rc.bottom;
+}
+
+// 相交或共边都算：合并后不会多出需要重绘的面积以外的碎片
+static bool RectsTouch(const RECT& a, const RECT& b) {
+    return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static void UnionInto(RECT& a, const RECT& b) {
+    a.left = (std::min)(a.left, b.left);
+    a.top = (std::min)(a.top, b.top);
+    a.right = (std::max)(a.right, b.right);
+    a.bottom = (std::max)(a.bottom, b.bottom);
+}
+
+bool RectsOverlap(const RECT& a, const RECT& b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+void ClearDamage(DamageRegion& d) {
+    d.rects.clear();
+}
+
+void AddDamage(DamageRegion& d, const RECT& rc) {
+    if (RectEmpty(rc)) return;
+    RECT merged = rc;
+    // 合并后的矩形可能又碰到别的矩形，重复直到稳定
+    bool grew = true;
+    while (grew) {
+        grew = false;
+        for (size_t i = 0; i < d.rects.size(); ++i) {
+            if (!RectsTouch(merged, d.rects[i])) continue;
+            UnionInto(merged, d.rects[i]);
+            d.rects[i] = d.rects.back();
+            d.rects.pop_back();
+            grew = true;
+            break;
+        }
+    }
+    d.rects.push_back(merged);
+
+    if ((int)d.rects.size() > DAMAGE_MAX_RECTS) {
+        RECT all = d.rects[0];
+        for (auto& r : d.rects) UnionInto(all, r);
+        d.rects.assign(1, all);
+    }
+}
+
+void AddDamage(DamageRegion& d, const DamageRegion& other) {
+    for (auto& rc : other.rects)
+        AddDamage(d, rc);
+}
+
+void AddShapeDamage(DamageRegion& d, const Shape& s, int margin) {
+    RECT rc;
+    if (!ShapeBounds(s, rc)) return;
+    rc.left -= margin;
+    rc.top -= margin;
+    rc.right += margin;
+    rc.bottom += margin;
+    AddDamage(d, rc);
+}
+
+void ClipDamage(DamageRegion& d, int width, int height) {
+    size_t keep = 0;
+    for (auto rc : d.rects) {
+        rc.left = (std::max)(rc.left, (LONG)0);
+        rc.top = (std::max)(rc.top, (LONG)0);
+        rc.right = (std::min)(rc.right, (LONG)width);
+        rc.bottom = (std::min)(rc.bottom, (LONG)height);
+        if (!RectEmpty(rc)) d.rects[keep++] = rc;
+    }
+    d.rects.resize(keep);
+}
+
+} // namespace GraphicsEngine
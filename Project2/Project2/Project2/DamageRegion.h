@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include "Shapes.h"
+
+namespace GraphicsEngine {
+
+// 矩形个数超过上限时退化为一个包围盒，避免逐矩形重绘的开销失控
+constexpr int DAMAGE_MAX_RECTS = 16;
+
+// 脏区域：一组互不相交的半开矩形，记录下一次需要重绘并拷贝到窗口的范围
+struct DamageRegion {
+    std::vector<RECT> rects;
+};
+
+void ClearDamage(DamageRegion& d);
+// 加入一个矩形：与已有矩形相交或相邻时合并为包围盒
+void AddDamage(DamageRegion& d, const RECT& rc);
+void AddDamage(DamageRegion& d, const DamageRegion& other);
+// 加入图形当前占用的范围，margin 为额外外扩（选中高亮等）
+void AddShapeDamage(DamageRegion& d, const Shape& s, int margin);
+// 把脏区域裁到 [0, width) x [0, height)
+void ClipDamage(DamageRegion& d, int width, int height);
+
+bool RectsOverlap(const RECT& a, const RECT& b);
+
+} // namespace GraphicsEngine
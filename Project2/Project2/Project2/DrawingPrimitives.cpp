@@ -1,5 +1,8 @@
 #include "DrawingPrimitives.h"
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <utility>
 
 namespace GraphicsEngine {
 
@@ -12,32 +15,27 @@ void BSplineBase(float t, float* b) {
     b[3] = t3 / 6.0f;
 }
 
-void DrawPixel(HDC hdc, int x, int y, COLORREF c) {
-    SetPixel(hdc, x, y, c);
+// 包围盒完全落在裁剪区外时整条图元可以跳过（分块绘制时大部分图元只与少数块相交）
+static bool BoxOutsideClip(const PixelSurface& surf, int xa, int ya, int xb, int yb) {
+    if (xa > xb) std::swap(xa, xb);
+    if (ya > yb) std::swap(ya, yb);
+    return xb < surf.clipLeft || xa >= surf.clipRight || yb < surf.clipTop || ya >= surf.clipBottom;
 }
 
-void DrawPixelXor(HDC hdc, int x, int y, COLORREF c) {
-    COLORREF old = GetPixel(hdc, x, y);
-    if (old == CLR_INVALID) old = RGB(255, 255, 255);
-    BYTE r = GetRValue(old) ^ GetRValue(c);
-    BYTE g = GetGValue(old) ^ GetGValue(c);
-    BYTE b = GetBValue(old) ^ GetBValue(c);
-    SetPixel(hdc, x, y, RGB(r, g, b));
-}
-
-void DrawLineMidpoint(HDC hdc, int x1, int y1, int x2, int y2, COLORREF c) {
-    int dx = abs(x2 - x1), dy = abs(y2 - y1);
+void DrawLineMidpoint(PixelSurface& surf, int x1, int y1, int x2, int y2, COLORREF c) {
+    if (BoxOutsideClip(surf, x1, y1, x2, y2)) return;
+    int dx = std::abs(x2 - x1), dy = std::abs(y2 - y1);
     int sx = (x2 >= x1) ? 1 : -1;
     int sy = (y2 >= y1) ? 1 : -1;
     int x = x1, y = y1;
-    DrawPixel(hdc, x, y, c);
+    DrawPixel(surf, x, y, c);
     if (dx > dy) {
         int d = 2 * dy - dx;
         for (int i = 0; i < dx; ++i) {
             x += sx;
             if (d < 0) d += 2 * dy;
             else { y += sy; d += 2 * (dy - dx); }
-            DrawPixel(hdc, x, y, c);
+            DrawPixel(surf, x, y, c);
         }
     }
     else {
@@ -46,24 +44,25 @@ void DrawLineMidpoint(HDC hdc, int x1, int y1, int x2, int y2, COLORREF c) {
             y += sy;
             if (d < 0) d += 2 * dx;
             else { x += sx; d += 2 * (dx - dy); }
-            DrawPixel(hdc, x, y, c);
+            DrawPixel(surf, x, y, c);
         }
     }
 }
 
-void DrawLineBresenham(HDC hdc, int x1, int y1, int x2, int y2, COLORREF c) {
-    int dx = abs(x2 - x1), dy = abs(y2 - y1);
+void DrawLineBresenham(PixelSurface& surf, int x1, int y1, int x2, int y2, COLORREF c) {
+    if (BoxOutsideClip(surf, x1, y1, x2, y2)) return;
+    int dx = std::abs(x2 - x1), dy = std::abs(y2 - y1);
     int sx = (x2 >= x1) ? 1 : -1;
     int sy = (y2 >= y1) ? 1 : -1;
     int x = x1, y = y1;
-    DrawPixel(hdc, x, y, c);
+    DrawPixel(surf, x, y, c);
     if (dx > dy) {
         int e = -dx;
         for (int i = 0; i < dx; ++i) {
             x += sx;
             e += 2 * dy;
             if (e >= 0) { y += sy; e -= 2 * dx; }
-            DrawPixel(hdc, x, y, c);
+            DrawPixel(surf, x, y, c);
         }
     }
     else {
@@ -72,80 +71,310 @@ void DrawLineBresenham(HDC hdc, int x1, int y1, int x2, int y2, COLORREF c) {
             y += sy;
             e += 2 * dx;
             if (e >= 0) { x += sx; e -= 2 * dy; }
-            DrawPixel(hdc, x, y, c);
+            DrawPixel(surf, x, y, c);
+        }
+    }
+}
+
+// 画一段水平/竖直的连续像素，端点顺序任意
+static void DrawRunH(PixelSurface& surf, int y, int xa, int xb, uint32_t px) {
+    if (xa <= xb) FillSpan(surf, y, xa, xb, px);
+    else FillSpan(surf, y, xb, xa, px);
+}
+
+static void DrawRunV(PixelSurface& surf, int x, int ya, int yb, uint32_t px) {
+    if (ya <= yb) FillColumn(surf, x, ya, yb, px);
+    else FillColumn(surf, x, yb, ya, px);
+}
+
+// 按段写入只在横向段不短于 2 个像素时划算：竖直方向的段每个像素各占一行，
+// 与逐像素写法访存相同却多了分段开销，因此斜率大于 1/2 的直线（竖直线除外）改为逐像素
+static bool PreferPerPixel(int dx, int dy) {
+    return dx != 0 && dx < 2 * dy;
+}
+
+// Run-Slice 直线：按行一次算出整段像素的长度再整段写入
+// 误差项与 Bresenham 完全一致，因此输出像素与前两种算法相同
+void DrawLineRunSlice(PixelSurface& surf, int x1, int y1, int x2, int y2, COLORREF c) {
+    if (BoxOutsideClip(surf, x1, y1, x2, y2)) return;
+    uint32_t px = ColorToPixel(c);
+    int dx = std::abs(x2 - x1), dy = std::abs(y2 - y1);
+    if (PreferPerPixel(dx, dy)) { DrawLineBresenham(surf, x1, y1, x2, y2, c); return; }
+    int sx = (x2 >= x1) ? 1 : -1;
+    int sy = (y2 >= y1) ? 1 : -1;
+    if (dx > dy) {
+        if (dy == 0) { DrawRunH(surf, y1, x1, x2, px); return; }
+        int q = dx / dy;                        // 中间各段的基本长度
+        int rStep = 2 * (dx % dy);
+        int first = (dx + 2 * dy - 1) / (2 * dy); // 首段长度 ceil(dx / 2dy)
+        int r = first * 2 * dy - dx;
+        int x = x1, y = y1;
+        DrawRunH(surf, y, x, x + sx * (first - 1), px);
+        x += sx * first;
+        for (int k = 1; k < dy; ++k) {
+            y += sy;
+            int len = q;
+            if (r < rStep) { ++len; r += 2 * dy; }
+            r -= rStep;
+            DrawRunH(surf, y, x, x + sx * (len - 1), px);
+            x += sx * len;
+        }
+        DrawRunH(surf, y2, x, x2, px);          // 末段直接延伸到终点
+    }
+    else if (dy == 0) DrawPixel(surf, x1, y1, c);
+    else DrawRunV(surf, x1, y1, y2, px);        // 其余情况只剩竖直线
+}
+
+// ----- 只画一段步号的直线 -----
+// 第 t 步的副方向偏移为 floor((2 |d| t + steps) / (2 steps))，即逐步推进时误差项 >= 0 就前进一格
+static int LerpStep(int a, int d, long long t, long long steps) {
+    long long num = 2 * (long long)d * t;
+    long long q = (num >= 0 ? num + steps : num - steps) / (2 * steps);
+    return a + (int)q;
+}
+
+long long LineStepCount(int x1, int y1, int x2, int y2) {
+    return (std::max)(std::abs((long long)x2 - x1), std::abs((long long)y2 - y1));
+}
+
+Point LineStepPoint(int x1, int y1, int x2, int y2, long long t) {
+    long long steps = LineStepCount(x1, y1, x2, y2);
+    if (steps == 0) return { x1, y1 };
+    return { LerpStep(x1, x2 - x1, t, steps), LerpStep(y1, y2 - y1, t, steps) };
+}
+
+// 把 [first, last] 截到 [0, 步数]，并求出首末两步的像素；整段不可见时返回 false
+static bool LineStepRange(const PixelSurface& surf, int x1, int y1, int x2, int y2, int& first, int& last,
+    Point& p, Point& q) {
+    long long steps = LineStepCount(x1, y1, x2, y2);
+    first = (std::max)(first, 0);
+    last = (int)(std::min)((long long)last, steps);
+    if (first > last) return false;
+    p = LineStepPoint(x1, y1, x2, y2, first);
+    q = LineStepPoint(x1, y1, x2, y2, last);
+    return !BoxOutsideClip(surf, p.x, p.y, q.x, q.y);
+}
+
+static long long CeilDiv(long long n, long long d) {
+    return n >= 0 ? (n + d - 1) / d : -((-n) / d);
+}
+
+void DrawLineMidpointSteps(PixelSurface& surf, int x1, int y1, int x2, int y2, int first, int last, COLORREF c) {
+    Point p, q;
+    if (!LineStepRange(surf, x1, y1, x2, y2, first, last, p, q)) return;
+    int dx = std::abs(x2 - x1), dy = std::abs(y2 - y1);
+    int sx = (x2 >= x1) ? 1 : -1;
+    int sy = (y2 >= y1) ? 1 : -1;
+    int x = p.x, y = p.y;
+    DrawPixel(surf, x, y, c);
+    // 判别式取从起点逐步推进到第 first 步时的值
+    if (dx > dy) {
+        int d = (int)(2LL * dy * (first + 1) - dx - 2LL * dx * std::abs(y - y1));
+        for (int i = first; i < last; ++i) {
+            x += sx;
+            if (d < 0) d += 2 * dy;
+            else { y += sy; d += 2 * (dy - dx); }
+            DrawPixel(surf, x, y, c);
+        }
+    }
+    else {
+        int d = (int)(2LL * dx * (first + 1) - dy - 2LL * dy * std::abs(x - x1));
+        for (int i = first; i < last; ++i) {
+            y += sy;
+            if (d < 0) d += 2 * dx;
+            else { x += sx; d += 2 * (dx - dy); }
+            DrawPixel(surf, x, y, c);
+        }
+    }
+}
+
+void DrawLineBresenhamSteps(PixelSurface& surf, int x1, int y1, int x2, int y2, int first, int last, COLORREF c) {
+    Point p, q;
+    if (!LineStepRange(surf, x1, y1, x2, y2, first, last, p, q)) return;
+    int dx = std::abs(x2 - x1), dy = std::abs(y2 - y1);
+    int sx = (x2 >= x1) ? 1 : -1;
+    int sy = (y2 >= y1) ? 1 : -1;
+    int x = p.x, y = p.y;
+    DrawPixel(surf, x, y, c);
+    if (dx > dy) {
+        int e = (int)(2LL * dy * first - dx - 2LL * dx * std::abs(y - y1));
+        for (int i = first; i < last; ++i) {
+            x += sx;
+            e += 2 * dy;
+            if (e >= 0) { y += sy; e -= 2 * dx; }
+            DrawPixel(surf, x, y, c);
+        }
+    }
+    else {
+        int e = (int)(2LL * dx * first - dy - 2LL * dy * std::abs(x - x1));
+        for (int i = first; i < last; ++i) {
+            y += sy;
+            e += 2 * dx;
+            if (e >= 0) { x += sx; e -= 2 * dy; }
+            DrawPixel(surf, x, y, c);
         }
     }
 }
 
-void DrawCirclePoints(HDC hdc, int xc, int yc, int x, int y, COLORREF c) {
-    DrawPixel(hdc, xc + x, yc + y, c);
-    DrawPixel(hdc, xc - x, yc + y, c);
-    DrawPixel(hdc, xc + x, yc - y, c);
-    DrawPixel(hdc, xc - x, yc - y, c);
-    DrawPixel(hdc, xc + y, yc + x, c);
-    DrawPixel(hdc, xc - y, yc + x, c);
-    DrawPixel(hdc, xc + y, yc - x, c);
-    DrawPixel(hdc, xc - y, yc - x, c);
+// 第 j 行（列）从第 ceil((2 dx j - dx) / 2dy) 步开始；r 为该值乘 2dy 后多出的部分，
+// 之后各行的长度按 DrawLineRunSlice 的递推得到
+void DrawLineRunSliceSteps(PixelSurface& surf, int x1, int y1, int x2, int y2, int first, int last, COLORREF c) {
+    if (PreferPerPixel(std::abs(x2 - x1), std::abs(y2 - y1))) {
+        DrawLineBresenhamSteps(surf, x1, y1, x2, y2, first, last, c);
+        return;
+    }
+    Point head, tail;
+    if (!LineStepRange(surf, x1, y1, x2, y2, first, last, head, tail)) return;
+    uint32_t px = ColorToPixel(c);
+    int dx = std::abs(x2 - x1), dy = std::abs(y2 - y1);
+    int sx = (x2 >= x1) ? 1 : -1;
+    int sy = (y2 >= y1) ? 1 : -1;
+    if (dx > dy) {
+        if (dy == 0) { DrawRunH(surf, y1, x1 + sx * first, x1 + sx * last, px); return; }
+        int q = dx / dy;
+        int rStep = 2 * (dx % dy);
+        long long num = 2LL * dx * std::abs(head.y - y1) - dx;
+        long long t = CeilDiv(num, 2LL * dy);
+        int r = (int)(t * 2 * dy - num);
+        for (int y = head.y;; y += sy) {
+            int len = q;
+            if (r < rStep) { ++len; r += 2 * dy; }
+            r -= rStep;
+            long long a = (std::max)(t, (long long)first), b = (std::min)(t + len - 1, (long long)last);
+            DrawRunH(surf, y, x1 + sx * (int)a, x1 + sx * (int)b, px);
+            if (y == tail.y) break;
+            t += len;
+        }
+    }
+    else DrawRunV(surf, x1, y1 + sy * first, y1 + sy * last, px); // 竖直线
 }
 
-void DrawCircleMidpoint(HDC hdc, int xc, int yc, int r, COLORREF c) {
+void DrawCirclePoints(PixelSurface& surf, int xc, int yc, int x, int y, COLORREF c) {
+    DrawPixel(surf, xc + x, yc + y, c);
+    DrawPixel(surf, xc - x, yc + y, c);
+    DrawPixel(surf, xc + x, yc - y, c);
+    DrawPixel(surf, xc - x, yc - y, c);
+    DrawPixel(surf, xc + y, yc + x, c);
+    DrawPixel(surf, xc - y, yc + x, c);
+    DrawPixel(surf, xc + y, yc - x, c);
+    DrawPixel(surf, xc - y, yc - x, c);
+}
+
+void DrawCircleMidpoint(PixelSurface& surf, int xc, int yc, int r, COLORREF c) {
     if (r <= 0) return;
+    if (BoxOutsideClip(surf, xc - r, yc - r, xc + r, yc + r)) return;
     int x = 0, y = r;
     int d = 1 - r;
-    DrawCirclePoints(hdc, xc, yc, x, y, c);
+    DrawCirclePoints(surf, xc, yc, x, y, c);
     while (x < y) {
         ++x;
         if (d < 0) d += 2 * x + 1;
         else { --y; d += 2 * (x - y) + 1; }
-        DrawCirclePoints(hdc, xc, yc, x, y, c);
+        DrawCirclePoints(surf, xc, yc, x, y, c);
     }
 }
 
-void DrawCircleBresenham(HDC hdc, int xc, int yc, int r, COLORREF c) {
+void DrawCircleBresenham(PixelSurface& surf, int xc, int yc, int r, COLORREF c) {
     if (r <= 0) return;
+    if (BoxOutsideClip(surf, xc - r, yc - r, xc + r, yc + r)) return;
     int x = 0, y = r;
     int e = 3 - 2 * r;
-    DrawCirclePoints(hdc, xc, yc, x, y, c);
+    DrawCirclePoints(surf, xc, yc, x, y, c);
     while (x < y) {
         if (e < 0) e += 4 * x + 6;
         else { e += 4 * (x - y) + 10; --y; }
         ++x;
-        DrawCirclePoints(hdc, xc, yc, x, y, c);
+        DrawCirclePoints(surf, xc, yc, x, y, c);
+    }
+}
+
+bool ArcCoversDirection(int xc, int yc, const Point* ends, size_t n, int dx, int dy) {
+    for (size_t i = 0; i + 1 < n; i += 2) {
+        long long sx = ends[i].x - xc, sy = ends[i].y - yc;
+        long long ex = ends[i + 1].x - xc, ey = ends[i + 1].y - yc;
+        long long se = sx * ey - sy * ex;
+        long long sv = sx * dy - sy * dx;
+        long long ve = dx * ey - dy * ex;
+        // 弧不超过半圆时方向要同时在起点之后、终点之前，超过半圆时满足其一即可
+        if (se > 0 ? (sv >= 0 && ve >= 0) : (sv >= 0 || ve >= 0))
+            return true;
     }
+    return false;
+}
+
+static void DrawArcPoints(PixelSurface& surf, int xc, int yc, int x, int y,
+    const Point* ends, size_t n, COLORREF c) {
+    const int off[8][2] = { { x, y }, { -x, y }, { x, -y }, { -x, -y },
+        { y, x }, { -y, x }, { y, -x }, { -y, -x } };
+    for (auto& o : off)
+        if (ArcCoversDirection(xc, yc, ends, n, o[0], o[1]))
+            DrawPixel(surf, xc + o[0], yc + o[1], c);
 }
 
-void DrawPolyline(HDC hdc, const std::vector<Point>& v, COLORREF c, bool closed) {
-    if (v.size() < 2) return;
-    for (size_t i = 0; i + 1 < v.size(); ++i)
-        DrawLineMidpoint(hdc, v[i].x, v[i].y, v[i + 1].x, v[i + 1].y, c);
+void DrawArcMidpoint(PixelSurface& surf, int xc, int yc, int r, const Point* ends, size_t n, COLORREF c) {
+    if (r <= 0 || n < 2) return;
+    if (BoxOutsideClip(surf, xc - r, yc - r, xc + r, yc + r)) return;
+    int x = 0, y = r;
+    int d = 1 - r;
+    DrawArcPoints(surf, xc, yc, x, y, ends, n, c);
+    while (x < y) {
+        ++x;
+        if (d < 0) d += 2 * x + 1;
+        else { --y; d += 2 * (x - y) + 1; }
+        DrawArcPoints(surf, xc, yc, x, y, ends, n, c);
+    }
+}
+
+void DrawPolyline(PixelSurface& surf, const Point* v, size_t n, COLORREF c, bool closed) {
+    if (n < 2) return;
+    for (size_t i = 0; i + 1 < n; ++i)
+        DrawLineMidpoint(surf, v[i].x, v[i].y, v[i + 1].x, v[i + 1].y, c);
     if (closed)
-        DrawLineMidpoint(hdc, v.back().x, v.back().y, v.front().x, v.front().y, c);
+        DrawLineMidpoint(surf, v[n - 1].x, v[n - 1].y, v[0].x, v[0].y, c);
 }
 
-void DrawBSpline(HDC hdc, const std::vector<Point>& ctrl, COLORREF c) {
-    if (ctrl.size() < 4) return;
-    for (size_t i = 0; i + 3 < ctrl.size(); ++i) {
+void DrawBSpline(PixelSurface& surf, const Point* ctrl, size_t n, COLORREF c) {
+    if (n < 4) return;
+    for (size_t i = 0; i + 3 < n; ++i) {
         Point p1 = ctrl[i];
         Point p2 = ctrl[i + 1];
         Point p3 = ctrl[i + 2];
         Point p4 = ctrl[i + 3];
 
-        float b0[4];
-        BSplineBase(0.0f, b0);
-        Point last;
-        last.x = int(b0[0] * p1.x + b0[1] * p2.x + b0[2] * p3.x + b0[3] * p4.x);
-        last.y = int(b0[0] * p1.y + b0[1] * p2.y + b0[2] * p3.y + b0[3] * p4.y);
-
-        for (float t = 0.01f; t <= 1.0f; t += 0.01f) {
-            float b[4];
-            BSplineBase(t, b);
-            Point cur;
-            cur.x = int(b[0] * p1.x + b[1] * p2.x + b[2] * p3.x + b[3] * p4.x);
-            cur.y = int(b[0] * p1.y + b[1] * p2.y + b[2] * p3.y + b[3] * p4.y);
-            DrawLineMidpoint(hdc, last.x, last.y, cur.x, cur.y, c);
-            last = cur;
-        }
+        // 曲线段落在 4 个控制点的凸包内；多留 1 像素覆盖浮点截断误差
+        int minX = (std::min)((std::min)(p1.x, p2.x), (std::min)(p3.x, p4.x)) - 1;
+        int maxX = (std::max)((std::max)(p1.x, p2.x), (std::max)(p3.x, p4.x)) + 1;
+        int minY = (std::min)((std::min)(p1.y, p2.y), (std::min)(p3.y, p4.y)) - 1;
+        int maxY = (std::max)((std::max)(p1.y, p2.y), (std::max)(p3.y, p4.y)) + 1;
+        if (BoxOutsideClip(surf, minX, minY, maxX, maxY)) continue;
+
+        Point pts[BSPLINE_SEGMENT_MAX_POINTS];
+        int count = BSplineSegmentPoints(&ctrl[i], pts);
+        for (int k = 1; k < count; ++k)
+            DrawLineMidpoint(surf, pts[k - 1].x, pts[k - 1].y, pts[k].x, pts[k].y, c);
+    }
+}
+
+int BSplineSegmentPoints(const Point* ctrl, Point* out) {
+    const Point& p1 = ctrl[0];
+    const Point& p2 = ctrl[1];
+    const Point& p3 = ctrl[2];
+    const Point& p4 = ctrl[3];
+    int n = 0;
+    float b0[4];
+    BSplineBase(0.0f, b0);
+    out[n].x = int(b0[0] * p1.x + b0[1] * p2.x + b0[2] * p3.x + b0[3] * p4.x);
+    out[n].y = int(b0[0] * p1.y + b0[1] * p2.y + b0[2] * p3.y + b0[3] * p4.y);
+    ++n;
+
+    for (float t = 0.01f; t <= 1.0f && n < BSPLINE_SEGMENT_MAX_POINTS; t += 0.01f) {
+        float b[4];
+        BSplineBase(t, b);
+        out[n].x = int(b[0] * p1.x + b[1] * p2.x + b[2] * p3.x + b[3] * p4.x);
+        out[n].y = int(b[0] * p1.y + b[1] * p2.y + b[2] * p3.y + b[3] * p4.y);
+        ++n;
     }
+    return n;
 }
 
 } // namespace GraphicsEngine
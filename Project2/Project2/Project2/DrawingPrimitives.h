@@ -1,20 +1,56 @@
 #pragma once
 
-#include <windows.h>
 #include <vector>
-#include "GraphicsState.h"
+#include "PixelSurface.h"
+#include "ShapeTypes.h"
 
 namespace GraphicsEngine {
 
 void BSplineBase(float t, float* b);
-void DrawPixel(HDC hdc, int x, int y, COLORREF c);
-void DrawPixelXor(HDC hdc, int x, int y, COLORREF c);
-void DrawLineMidpoint(HDC hdc, int x1, int y1, int x2, int y2, COLORREF c);
-void DrawLineBresenham(HDC hdc, int x1, int y1, int x2, int y2, COLORREF c);
-void DrawCirclePoints(HDC hdc, int xc, int yc, int x, int y, COLORREF c);
-void DrawCircleMidpoint(HDC hdc, int xc, int yc, int r, COLORREF c);
-void DrawCircleBresenham(HDC hdc, int xc, int yc, int r, COLORREF c);
-void DrawPolyline(HDC hdc, const std::vector<Point>& v, COLORREF c, bool closed);
-void DrawBSpline(HDC hdc, const std::vector<Point>& ctrl, COLORREF c);
+
+// 一段三次 B 样条曲线（4 个控制点）的折线采样点数上限
+constexpr int BSPLINE_SEGMENT_MAX_POINTS = 128;
+// 按 t 步长 0.01 采样 ctrl[0..3] 决定的曲线段，返回写入 out 的点数
+int BSplineSegmentPoints(const Point* ctrl, Point* out);
+
+// 单像素写入：直接写表面内存，越出裁剪区的像素被忽略
+inline void DrawPixel(PixelSurface& surf, int x, int y, COLORREF c) {
+    PutPixel(surf, x, y, ColorToPixel(c));
+}
+
+// 按 RGB 分量异或；COLORREF 与像素格式只差字节顺序，因此可直接异或
+inline void DrawPixelXor(PixelSurface& surf, int x, int y, COLORREF c) {
+    XorPixel(surf, x, y, ColorToPixel(c));
+}
+
+void DrawLineMidpoint(PixelSurface& surf, int x1, int y1, int x2, int y2, COLORREF c);
+void DrawLineBresenham(PixelSurface& surf, int x1, int y1, int x2, int y2, COLORREF c);
+void DrawLineRunSlice(PixelSurface& surf, int x1, int y1, int x2, int y2, COLORREF c);
+// 直线的步数 max(|dx|, |dy|)，以及第 t 步（0..步数）的像素；三种直线算法画出的像素都是这些点
+long long LineStepCount(int x1, int y1, int x2, int y2);
+Point LineStepPoint(int x1, int y1, int x2, int y2, long long t);
+// 只画第 first..last 步（超出 [0, 步数] 的部分忽略），像素与画整条线段时的对应部分相同
+void DrawLineMidpointSteps(PixelSurface& surf, int x1, int y1, int x2, int y2, int first, int last, COLORREF c);
+void DrawLineBresenhamSteps(PixelSurface& surf, int x1, int y1, int x2, int y2, int first, int last, COLORREF c);
+void DrawLineRunSliceSteps(PixelSurface& surf, int x1, int y1, int x2, int y2, int first, int last, COLORREF c);
+void DrawCirclePoints(PixelSurface& surf, int xc, int yc, int x, int y, COLORREF c);
+void DrawCircleMidpoint(PixelSurface& surf, int xc, int yc, int r, COLORREF c);
+void DrawCircleBresenham(PixelSurface& surf, int xc, int yc, int r, COLORREF c);
+// 圆弧：ends 中每两个点为一段弧，从圆心指向第一个点的方向沿角度增大方向（屏幕坐标下顺时针）
+// 转到指向第二个点的方向；ends 只表示方向，不必落在圆上。n 为点数
+// 相对圆心偏移 (dx, dy) 的方向是否落在某段弧内
+bool ArcCoversDirection(int xc, int yc, const Point* ends, size_t n, int dx, int dy);
+// 中点画圆算法（与 Bresenham 画圆逐像素相同）画出的圆上落在弧内的像素
+void DrawArcMidpoint(PixelSurface& surf, int xc, int yc, int r, const Point* ends, size_t n, COLORREF c);
+void DrawPolyline(PixelSurface& surf, const Point* v, size_t n, COLORREF c, bool closed);
+void DrawBSpline(PixelSurface& surf, const Point* ctrl, size_t n, COLORREF c);
+
+inline void DrawPolyline(PixelSurface& surf, const std::vector<Point>& v, COLORREF c, bool closed) {
+    DrawPolyline(surf, v.data(), v.size(), c, closed);
+}
+
+inline void DrawBSpline(PixelSurface& surf, const std::vector<Point>& ctrl, COLORREF c) {
+    DrawBSpline(surf, ctrl.data(), ctrl.size(), c);
+}
 
 } // namespace GraphicsEngine
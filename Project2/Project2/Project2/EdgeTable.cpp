@@ -0,0 +1,118 @@
+#include "EdgeTable.h"
+#include <algorithm>
+
+namespace GraphicsEngine {
+
+// a 的交点是否在 b 的左边：整数部分相同时比较 rem/dy
+static bool CrossingLess(const ETEdge& a, const ETEdge& b) {
+    if (a.x != b.x) return a.x < b.x;
+    return (long long)a.rem * b.dy < (long long)b.rem * a.dy;
+}
+
+static void StepEdge(ETEdge& e) {
+    e.x += e.stepX;
+    e.rem += e.stepRem;
+    if (e.rem >= e.dy) {
+        e.rem -= e.dy;
+        e.x++;
+    }
+}
+
+void ResetEdgeTable(EdgeTable& et) {
+    et.edges.clear();
+    et.active.clear();
+    et.nextEdge = 0;
+    et.y = 0;
+}
+
+void AddContour(EdgeTable& et, const Point* pts, size_t n) {
+    if (n < 2) return;
+    for (size_t i = 0; i < n; ++i) {
+        Point p1 = pts[i], p2 = pts[(i + 1) % n];
+        if (p1.y == p2.y) continue;
+
+        ETEdge e;
+        e.winding = p1.y < p2.y ? 1 : -1;
+        if (p1.y > p2.y) std::swap(p1, p2);
+        int dx = p2.x - p1.x;
+        e.yTop = p1.y;
+        e.yBottom = p2.y;
+        e.dy = p2.y - p1.y;
+        e.x = p1.x;
+        e.rem = 0;
+        // 向下取整的除法，保证 stepRem 非负
+        e.stepX = dx / e.dy;
+        e.stepRem = dx % e.dy;
+        if (e.stepRem < 0) {
+            e.stepX--;
+            e.stepRem += e.dy;
+        }
+        et.edges.push_back(e);
+    }
+}
+
+void BeginScan(EdgeTable& et) {
+    SortEdges(et);
+    RewindScan(et);
+}
+
+void SortEdges(EdgeTable& et) {
+    std::sort(et.edges.begin(), et.edges.end(),
+        [](const ETEdge& a, const ETEdge& b) { return a.yTop < b.yTop; });
+}
+
+void RewindScan(EdgeTable& et) {
+    et.active.clear();
+    et.nextEdge = 0;
+    et.y = et.edges.empty() ? 0 : et.edges[0].yTop - 1;
+}
+
+bool NextScanline(EdgeTable& et, int& y) {
+    auto& act = et.active;
+
+    // 活性边步进到下一行，并移除已经结束的边
+    int ny = et.y + 1;
+    size_t keep = 0;
+    for (size_t i = 0; i < act.size(); ++i) {
+        if (act[i].yBottom <= ny) continue;
+        StepEdge(act[i]);
+        act[keep++] = act[i];
+    }
+    act.resize(keep);
+
+    // 活性边表为空时直接跳到下一条边的起始行
+    if (act.empty()) {
+        if (et.nextEdge >= et.edges.size()) return false;
+        ny = et.edges[et.nextEdge].yTop;
+    }
+    while (et.nextEdge < et.edges.size() && et.edges[et.nextEdge].yTop == ny)
+        act.push_back(et.edges[et.nextEdge++]);
+
+    // 相邻行之间交点顺序基本不变，插入排序接近线性
+    for (size_t i = 1; i < act.size(); ++i) {
+        ETEdge e = act[i];
+        size_t j = i;
+        while (j > 0 && CrossingLess(e, act[j - 1])) {
+            act[j] = act[j - 1];
+            --j;
+        }
+        act[j] = e;
+    }
+
+    et.y = ny;
+    y = ny;
+    return true;
+}
+
+void CollectCrossings(const EdgeTable& et, FillRule rule, std::vector<EdgeCrossing>& out) {
+    out.clear();
+    int w = 0;
+    for (const ETEdge& e : et.active) {
+        int before = w;
+        w += e.winding;
+        if (rule == FillRule::NonZero && (before != 0) == (w != 0)) continue;
+        out.push_back({ e.x, e.rem > 0 ? e.x + 1 : e.x });
+    }
+}
+
+} // namespace GraphicsEngine
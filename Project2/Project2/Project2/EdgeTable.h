@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "ShapeTypes.h"
+
+namespace GraphicsEngine {
+
+// 边表中的一条边：y 方向取 [yTop, yBottom)，x 以“整数 + 余数/dy”精确步进
+struct ETEdge {
+    int yTop;
+    int yBottom;
+    int x;          // 当前扫描线交点的整数部分 floor(x)
+    int rem;        // 小数部分的分子，0 <= rem < dy
+    int dy;
+    int stepX;      // 每行 x 的整数增量 floor(dx / dy)
+    int stepRem;    // 每行余数增量，0 <= stepRem < dy
+    int winding;    // 原始方向向下为 +1，向上为 -1
+};
+
+// 扫描线与填充边界的交点
+struct EdgeCrossing {
+    int xFloor;
+    int xCeil;
+};
+
+// 边表 + 活性边表：可复用，多次填充之间不重新分配内存
+struct EdgeTable {
+    std::vector<ETEdge> edges;      // BeginScan 后按 yTop 升序
+    std::vector<ETEdge> active;     // 当前扫描线的活性边，按交点 x 升序
+    size_t nextEdge = 0;
+    int y = 0;
+};
+
+void ResetEdgeTable(EdgeTable& et);
+// 加入一条闭合轮廓（首尾自动相连），水平边被忽略
+void AddContour(EdgeTable& et, const Point* pts, size_t n);
+// 开始扫描：SortEdges + RewindScan
+void BeginScan(EdgeTable& et);
+// 按 yTop 排序边；预先排好序的边表可以只调用 RewindScan，多次重放
+void SortEdges(EdgeTable& et);
+void RewindScan(EdgeTable& et);
+// 前进到下一条有活性边的扫描线；没有更多扫描线时返回 false
+bool NextScanline(EdgeTable& et, int& y);
+// 按填充规则取出当前扫描线上内外状态发生翻转的交点（个数为偶数）
+void CollectCrossings(const EdgeTable& et, FillRule rule, std::vector<EdgeCrossing>& out);
+
+} // namespace GraphicsEngine
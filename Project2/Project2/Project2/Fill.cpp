@@ -4,176 +4,241 @@
 
 namespace GraphicsEngine {
 
-void FillPolygonScanline(HDC hdc, const std::vector<Point>& v, COLORREF c, bool innerOnly) {
-    if (v.size() < 3) return;
-    int ymin = v[0].y, ymax = v[0].y;
-    for (auto& p : v) { ymin = min(ymin, p.y); ymax = max(ymax, p.y); }
-
-    for (int y = ymin; y <= ymax; ++y) {
-        std::vector<float> xs;
-        for (size_t i = 0; i < v.size(); ++i) {
-            Point p1 = v[i], p2 = v[(i + 1) % v.size()];
-            if (p1.y == p2.y) continue;
-            int yMin = min(p1.y, p2.y);
-            int yMax = max(p1.y, p2.y);
-            if (y < yMin || y >= yMax) continue;
-            float x = p1.x + (float)(y - p1.y) * (float)(p2.x - p1.x) / (float)(p2.y - p1.y);
-            xs.push_back(x);
-        }
-        if (xs.size() < 2) continue;
-        std::sort(xs.begin(), xs.end());
+// 把复合路径的所有轮廓加入同一张边表
+static void AddShapeContours(EdgeTable& et, const Shape& s) {
+    const auto& v = s.vertices;
+    size_t start = 0;
+    for (int n : ShapeContourSizes(s)) {
+        if (n <= 0 || start + n > v.size()) break;
+        if (n >= 3) AddContour(et, v.data() + start, (size_t)n);
+        start += n;
+    }
+}
+
+static int ShapeMinX(const Point* v, size_t n) {
+    int minX = v[0].x;
+    for (size_t i = 0; i < n; ++i) minX = (std::min)(minX, v[i].x);
+    return minX;
+}
+
+// 扫描边表中所有轮廓，一遍填完
+// 边表须已排好序
+static void ScanFillEdgeTable(PixelSurface& surf, EdgeTable& et, uint32_t px, bool innerOnly, FillRule rule) {
+    RewindScan(et);
+
+    std::vector<EdgeCrossing> xs;
+    int y;
+    while (NextScanline(et, y)) {
+        if (y >= surf.clipBottom) break;
+        if (y < surf.clipTop) continue;
+        CollectCrossings(et, rule, xs);
         for (size_t i = 0; i + 1 < xs.size(); i += 2) {
-            int x1 = (int)std::ceil(xs[i]);
-            int x2 = (int)std::floor(xs[i + 1]);
+            int x1 = xs[i].xCeil;
+            int x2 = xs[i + 1].xFloor;
             if (innerOnly) { x1++; x2--; }
             if (x1 > x2) continue;
-            for (int x = x1; x <= x2; ++x)
-                DrawPixel(hdc, x, y, c);
+            FillSpan(surf, y, x1, x2, px);
         }
     }
 }
 
-void FillRectScanline(HDC hdc, const Point& p1, const Point& p2, COLORREF c, bool innerOnly) {
-    int x1 = min(p1.x, p2.x);
-    int x2 = max(p1.x, p2.x);
-    int y1 = min(p1.y, p2.y);
-    int y2 = max(p1.y, p2.y);
+void FillPolygonScanline(PixelSurface& surf, const Point* v, size_t n, COLORREF c, bool innerOnly, FillRule rule) {
+    if (n < 3) return;
+    EdgeTable et;
+    AddContour(et, v, n);
+    SortEdges(et);
+    ScanFillEdgeTable(surf, et, ColorToPixel(c), innerOnly, rule);
+}
+
+void FillCompoundScanline(PixelSurface& surf, const Shape& s, COLORREF c) {
+    if (s.vertices.size() < 3) return;
+    EdgeTable et;
+    AddShapeContours(et, s);
+    SortEdges(et);
+    ScanFillEdgeTable(surf, et, ColorToPixel(c), false, s.fillRule);
+}
+
+void FillSortedEdges(PixelSurface& surf, EdgeTable& et, COLORREF c, FillRule rule) {
+    ScanFillEdgeTable(surf, et, ColorToPixel(c), false, rule);
+}
+
+void FillRectScanline(PixelSurface& surf, const Point& p1, const Point& p2, COLORREF c, bool innerOnly) {
+    int x1 = (std::min)(p1.x, p2.x);
+    int x2 = (std::max)(p1.x, p2.x);
+    int y1 = (std::min)(p1.y, p2.y);
+    int y2 = (std::max)(p1.y, p2.y);
 
     if (innerOnly) { x1++; x2--; y1++; y2--; }
     if (x1 > x2 || y1 > y2) return;
 
+    uint32_t px = ColorToPixel(c);
+    // 只遍历裁剪区内的行（分块绘制时每块只处理自己的行）
+    y1 = (std::max)(y1, surf.clipTop);
+    y2 = (std::min)(y2, surf.clipBottom - 1);
     for (int y = y1; y <= y2; ++y)
-        for (int x = x1; x <= x2; ++x)
-            DrawPixel(hdc, x, y, c);
+        FillSpan(surf, y, x1, x2, px);
 }
 
-void FillCircleScanline(HDC hdc, const Point& center, const Point& onCircle, COLORREF c, bool innerOnly) {
+void FillCircleScanline(PixelSurface& surf, const Point& center, const Point& onCircle, COLORREF c, bool innerOnly) {
     int xc = center.x, yc = center.y;
     int r = int(std::sqrt(double((onCircle.x - xc) * (onCircle.x - xc) +
         (onCircle.y - yc) * (onCircle.y - yc))));
     if (innerOnly && r > 0) r--;
+    FillCircleRadius(surf, xc, yc, r, c);
+}
+
+void FillCircleRadius(PixelSurface& surf, int xc, int yc, int r, COLORREF c) {
     if (r <= 0) return;
 
-    for (int y = yc - r; y <= yc + r; ++y) {
+    uint32_t px = ColorToPixel(c);
+    int yBegin = (std::max)(yc - r, surf.clipTop);
+    int yEnd = (std::min)(yc + r, surf.clipBottom - 1);
+    for (int y = yBegin; y <= yEnd; ++y) {
         int dy = y - yc;
         int t = r * r - dy * dy;
         if (t < 0) continue;
         int dx = int(std::sqrt(double(t)));
-        int x1 = xc - dx, x2 = xc + dx;
-        for (int x = x1; x <= x2; ++x)
-            DrawPixel(hdc, x, y, c);
+        FillSpan(surf, y, xc - dx, xc + dx, px);
     }
 }
 
-void FillShapeScanline(HDC hdc, const Shape& s, COLORREF c) {
+void FillShapeScanline(PixelSurface& surf, const Shape& s, COLORREF c) {
     const auto& v = s.vertices;
     switch (s.type) {
     case DrawMode::DrawRectangle:
-        FillRectScanline(hdc, v[0], v[1], c, false); break;
+        FillRectScanline(surf, v[0], v[1], c, false); break;
     case DrawMode::DrawCircleMidpoint:
     case DrawMode::DrawCircleBresenham:
-        FillCircleScanline(hdc, v[0], v[1], c, false); break;
+        FillCircleScanline(surf, v[0], v[1], c, false); break;
     case DrawMode::DrawPolygon:
-        FillPolygonScanline(hdc, v, c, false);        break;
+        FillPolygonScanline(surf, v.data(), v.size(), c, false);        break;
+    case DrawMode::DrawCompound:
+        FillCompoundScanline(surf, s, c);              break;
     default: break;
     }
 }
 
-void FenceFillRect(HDC hdc, const Point& p1, const Point& p2, COLORREF xorColor) {
-    int x1 = min(p1.x, p2.x);
-    int x2 = max(p1.x, p2.x);
-    int y1 = min(p1.y, p2.y);
-    int y2 = max(p1.y, p2.y);
+// 一行上的栅栏异或：原算法对每个交点 e 把 [fenceX, e] 整段异或一次
+// 像素被异或偶数次等于不变，因此只异或被覆盖奇数次的区间，结果逐位相同
+// ends 须升序；小于 fenceX 的交点原算法直接跳过
+static void FenceXorRow(PixelSurface& surf, int y, int fenceX, const int* ends, size_t n, uint32_t px) {
+    size_t i = 0;
+    while (i < n && ends[i] < fenceX) ++i;
+    int from = fenceX;
+    for (; i < n; ++i) {
+        // [from, ends[i]] 内的像素被剩余 n - i 个交点覆盖
+        if (((n - i) & 1) && from <= ends[i])
+            XorSpan(surf, y, from, ends[i], px);
+        from = (std::max)(from, ends[i] + 1);
+    }
+}
+
+void FenceFillRect(PixelSurface& surf, const Point& p1, const Point& p2, COLORREF xorColor) {
+    int x1 = (std::min)(p1.x, p2.x);
+    int x2 = (std::max)(p1.x, p2.x);
+    int y1 = (std::min)(p1.y, p2.y);
+    int y2 = (std::max)(p1.y, p2.y);
     int fenceX = x1 - 1;
+    uint32_t px = ColorToPixel(xorColor);
 
-    for (int y = y1; y <= y2; ++y) {
-        int xs[2] = { x1, x2 };
-        for (int k = 0; k < 2; ++k) {
-            int xEnd = xs[k];
-            if (xEnd < fenceX) continue;
-            for (int x = fenceX; x <= xEnd; ++x)
-                DrawPixelXor(hdc, x, y, xorColor);
-        }
-    }
+    int xs[2] = { x1, x2 };
+    y1 = (std::max)(y1, surf.clipTop);
+    y2 = (std::min)(y2, surf.clipBottom - 1);
+    for (int y = y1; y <= y2; ++y)
+        FenceXorRow(surf, y, fenceX, xs, 2, px);
 }
 
-void FenceFillCircle(HDC hdc, const Point& center, const Point& onCircle, COLORREF xorColor) {
+void FenceFillCircle(PixelSurface& surf, const Point& center, const Point& onCircle, COLORREF xorColor) {
     int xc = center.x, yc = center.y;
     int r = int(std::sqrt(double((onCircle.x - xc) * (onCircle.x - xc) +
         (onCircle.y - yc) * (onCircle.y - yc))));
+    FenceFillCircleRadius(surf, xc, yc, r, xorColor);
+}
+
+void FenceFillCircleRadius(PixelSurface& surf, int xc, int yc, int r, COLORREF xorColor) {
     if (r <= 0) return;
 
     int minX = xc - r;
     int fenceX = minX - 1;
+    uint32_t px = ColorToPixel(xorColor);
 
-    for (int y = yc - r; y <= yc + r; ++y) {
+    int yBegin = (std::max)(yc - r, surf.clipTop);
+    int yEnd = (std::min)(yc + r, surf.clipBottom - 1);
+    for (int y = yBegin; y <= yEnd; ++y) {
         int dy = y - yc;
         int t = r * r - dy * dy;
         if (t < 0) continue;
         int dx = int(std::sqrt(double(t)));
         int xs[2] = { xc - dx, xc + dx };
-        for (int k = 0; k < 2; ++k) {
-            int xEnd = xs[k];
-            if (xEnd < fenceX) continue;
-            for (int x = fenceX; x <= xEnd; ++x)
-                DrawPixelXor(hdc, x, y, xorColor);
-        }
+        FenceXorRow(surf, y, fenceX, xs, 2, px);
     }
 }
 
-void FenceFillPolygon(HDC hdc, const std::vector<Point>& v, COLORREF xorColor) {
-    if (v.size() < 3) return;
-
-    int minX = v[0].x, ymin = v[0].y, ymax = v[0].y;
-    for (auto& p : v) {
-        minX = min(minX, p.x);
-        ymin = min(ymin, p.y);
-        ymax = max(ymax, p.y);
+// 边表须已排好序
+static void FenceFillEdgeTable(PixelSurface& surf, EdgeTable& et, int fenceX, uint32_t px, FillRule rule) {
+    RewindScan(et);
+
+    std::vector<EdgeCrossing> xs;
+    std::vector<int> ends;
+    int y;
+    while (NextScanline(et, y)) {
+        if (y >= surf.clipBottom) break;
+        if (y < surf.clipTop) continue;
+        CollectCrossings(et, rule, xs);
+        ends.clear();
+        for (auto& x : xs)
+            ends.push_back(x.xFloor);
+        FenceXorRow(surf, y, fenceX, ends.data(), ends.size(), px);
     }
-    int fenceX = minX - 1;
+}
 
-    for (int y = ymin; y <= ymax; ++y) {
-        std::vector<float> xs;
-        for (size_t i = 0; i < v.size(); ++i) {
-            Point p1 = v[i], p2 = v[(i + 1) % v.size()];
-            if (p1.y == p2.y) continue;
-            int yMin = min(p1.y, p2.y);
-            int yMax = max(p1.y, p2.y);
-            if (y < yMin || y >= yMax) continue;
-            float x = p1.x + (float)(y - p1.y) * (float)(p2.x - p1.x) / (float)(p2.y - p1.y);
-            xs.push_back(x);
-        }
-        if (xs.empty()) continue;
-        std::sort(xs.begin(), xs.end());
-        for (size_t i = 0; i < xs.size(); ++i) {
-            int xEnd = (int)std::floor(xs[i]);
-            if (xEnd < fenceX) continue;
-            for (int x = fenceX; x <= xEnd; ++x)
-                DrawPixelXor(hdc, x, y, xorColor);
-        }
-    }
+void FenceFillPolygon(PixelSurface& surf, const Point* v, size_t n, COLORREF xorColor, FillRule rule) {
+    if (n < 3) return;
+    EdgeTable et;
+    AddContour(et, v, n);
+    SortEdges(et);
+    FenceFillEdgeTable(surf, et, ShapeMinX(v, n) - 1, ColorToPixel(xorColor), rule);
 }
 
-void FillShapeFence(HDC hdc, const Shape& s, COLORREF fillColor) {
-    const auto& v = s.vertices;
-    if (v.size() < 2) return;
+void FenceFillCompound(PixelSurface& surf, const Shape& s, COLORREF xorColor) {
+    if (s.vertices.size() < 3) return;
+    EdgeTable et;
+    AddShapeContours(et, s);
+    SortEdges(et);
+    FenceFillEdgeTable(surf, et, ShapeMinX(s.vertices.data(), s.vertices.size()) - 1, ColorToPixel(xorColor), s.fillRule);
+}
 
-    COLORREF xorColor = RGB(
+void FenceFillSortedEdges(PixelSurface& surf, EdgeTable& et, int fenceX, COLORREF xorColor, FillRule rule) {
+    FenceFillEdgeTable(surf, et, fenceX, ColorToPixel(xorColor), rule);
+}
+
+COLORREF FenceXorColor(COLORREF fillColor) {
+    return RGB(
         255 ^ GetRValue(fillColor),
         255 ^ GetGValue(fillColor),
         255 ^ GetBValue(fillColor)
     );
+}
+
+void FillShapeFence(PixelSurface& surf, const Shape& s, COLORREF fillColor) {
+    const auto& v = s.vertices;
+    if (v.size() < 2) return;
+
+    COLORREF xorColor = FenceXorColor(fillColor);
 
     switch (s.type) {
     case DrawMode::DrawRectangle:
-        FenceFillRect(hdc, v[0], v[1], xorColor);
+        FenceFillRect(surf, v[0], v[1], xorColor);
         break;
     case DrawMode::DrawCircleMidpoint:
     case DrawMode::DrawCircleBresenham:
-        FenceFillCircle(hdc, v[0], v[1], xorColor);
+        FenceFillCircle(surf, v[0], v[1], xorColor);
         break;
     case DrawMode::DrawPolygon:
-        FenceFillPolygon(hdc, v, xorColor);
+        FenceFillPolygon(surf, v.data(), v.size(), xorColor);
+        break;
+    case DrawMode::DrawCompound:
+        FenceFillCompound(surf, s, xorColor);
         break;
     default:
         break;
@@ -1,20 +1,45 @@
 #pragma once
 
-#include "GraphicsState.h"
 #include "DrawingPrimitives.h"
+#include "EdgeTable.h"
 
 namespace GraphicsEngine {
 
 // 扫描线填充
-void FillPolygonScanline(HDC hdc, const std::vector<Point>& v, COLORREF c, bool innerOnly);
-void FillRectScanline(HDC hdc, const Point& p1, const Point& p2, COLORREF c, bool innerOnly);
-void FillCircleScanline(HDC hdc, const Point& center, const Point& onCircle, COLORREF c, bool innerOnly);
-void FillShapeScanline(HDC hdc, const Shape& s, COLORREF c);
+void FillPolygonScanline(PixelSurface& surf, const Point* v, size_t n, COLORREF c, bool innerOnly,
+    FillRule rule = FillRule::EvenOdd);
+void FillRectScanline(PixelSurface& surf, const Point& p1, const Point& p2, COLORREF c, bool innerOnly);
+void FillCircleScanline(PixelSurface& surf, const Point& center, const Point& onCircle, COLORREF c, bool innerOnly);
+// 复合路径：所有轮廓共用一张边表，一遍扫描完成
+void FillCompoundScanline(PixelSurface& surf, const Shape& s, COLORREF c);
+void FillShapeScanline(PixelSurface& surf, const Shape& s, COLORREF c);
 
 // 栅栏填充 (XOR)
-void FenceFillRect(HDC hdc, const Point& p1, const Point& p2, COLORREF xorColor);
-void FenceFillCircle(HDC hdc, const Point& center, const Point& onCircle, COLORREF xorColor);
-void FenceFillPolygon(HDC hdc, const std::vector<Point>& v, COLORREF xorColor);
-void FillShapeFence(HDC hdc, const Shape& s, COLORREF fillColor);
+void FenceFillRect(PixelSurface& surf, const Point& p1, const Point& p2, COLORREF xorColor);
+void FenceFillCircle(PixelSurface& surf, const Point& center, const Point& onCircle, COLORREF xorColor);
+void FenceFillPolygon(PixelSurface& surf, const Point* v, size_t n, COLORREF xorColor,
+    FillRule rule = FillRule::EvenOdd);
+void FenceFillCompound(PixelSurface& surf, const Shape& s, COLORREF xorColor);
+void FillShapeFence(PixelSurface& surf, const Shape& s, COLORREF fillColor);
+// 栅栏填充实际异或的颜色：与白底异或后得到 fillColor
+COLORREF FenceXorColor(COLORREF fillColor);
+
+inline void FillPolygonScanline(PixelSurface& surf, const std::vector<Point>& v, COLORREF c, bool innerOnly,
+    FillRule rule = FillRule::EvenOdd) {
+    FillPolygonScanline(surf, v.data(), v.size(), c, innerOnly, rule);
+}
+
+inline void FenceFillPolygon(PixelSurface& surf, const std::vector<Point>& v, COLORREF xorColor,
+    FillRule rule = FillRule::EvenOdd) {
+    FenceFillPolygon(surf, v.data(), v.size(), xorColor, rule);
+}
+
+// 预先解析好参数的填充（命令缓冲重放用）
+// 半径已算好的圆
+void FillCircleRadius(PixelSurface& surf, int xc, int yc, int r, COLORREF c);
+void FenceFillCircleRadius(PixelSurface& surf, int xc, int yc, int r, COLORREF xorColor);
+// 边表已由 SortEdges 排好序，可以反复扫描
+void FillSortedEdges(PixelSurface& surf, EdgeTable& et, COLORREF c, FillRule rule);
+void FenceFillSortedEdges(PixelSurface& surf, EdgeTable& et, int fenceX, COLORREF xorColor, FillRule rule);
 
 } // namespace GraphicsEngine
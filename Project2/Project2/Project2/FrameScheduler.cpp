@@ -0,0 +1,96 @@
+#include "FrameScheduler.h"
+#include <chrono>
+
+namespace GraphicsEngine {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+HWND g_frameHwnd = nullptr;
+int g_targetHz = 60;
+Clock::duration g_interval = std::chrono::microseconds(1000000 / 60);
+Clock::time_point g_lastFrame;
+Clock::time_point g_dueTime;            // 挂起帧的预定渲染时刻
+bool g_framePending = false;
+FrameStats g_stats;
+
+int DisplayRefreshRate() {
+    DEVMODEW dm{};
+    dm.dmSize = sizeof(dm);
+    // 0 和 1 表示“硬件默认”，按 60Hz 处理
+    if (EnumDisplaySettingsW(NULL, ENUM_CURRENT_SETTINGS, &dm) && dm.dmDisplayFrequency > 1)
+        return (int)dm.dmDisplayFrequency;
+    return 60;
+}
+
+} // namespace
+
+void InitFrameScheduler(HWND hwnd, int targetHz) {
+    g_frameHwnd = hwnd;
+    g_framePending = false;
+    g_lastFrame = Clock::time_point();
+    g_stats = FrameStats{};
+    SetTargetFrameRate(targetHz);
+}
+
+void ShutdownFrameScheduler() {
+    if (g_frameHwnd)
+        KillTimer(g_frameHwnd, FRAME_TIMER_ID);
+    g_frameHwnd = nullptr;
+    g_framePending = false;
+}
+
+void SetTargetFrameRate(int targetHz) {
+    if (targetHz <= 0) targetHz = DisplayRefreshRate();
+    if (targetHz > 1000) targetHz = 1000;
+    g_targetHz = targetHz;
+    g_interval = std::chrono::microseconds(1000000 / targetHz);
+}
+
+int GetTargetFrameRate() {
+    return g_targetHz;
+}
+
+bool RequestFrame() {
+    g_stats.inputEvents++;
+    if (g_framePending) {
+        g_stats.coalescedEvents++;
+        return false;
+    }
+    Clock::time_point now = Clock::now();
+    if (now - g_lastFrame >= g_interval || !g_frameHwnd)
+        return true;
+
+    // 本周期已经出过帧：挂起，到下个周期再渲染最新状态
+    g_framePending = true;
+    g_dueTime = g_lastFrame + g_interval;
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(g_dueTime - now).count();
+    SetTimer(g_frameHwnd, FRAME_TIMER_ID, (UINT)(wait > 0 ? wait : 1), NULL);
+    return false;
+}
+
+bool OnFrameTimer(UINT_PTR timerId) {
+    if (timerId != FRAME_TIMER_ID) return false;
+    if (g_frameHwnd)
+        KillTimer(g_frameHwnd, FRAME_TIMER_ID);
+    if (!g_framePending) return false;
+    g_framePending = false;
+
+    // 定时器精度有限（约 10~16ms），迟到超过一个周期视为丢帧
+    Clock::duration late = Clock::now() - g_dueTime;
+    if (late > g_interval)
+        g_stats.droppedFrames += (unsigned long long)(late / g_interval);
+    return true;
+}
+
+void FrameRendered() {
+    g_lastFrame = Clock::now();
+    g_stats.framesRendered++;
+}
+
+const FrameStats& GetFrameStats() {
+    return g_stats;
+}
+
+} // namespace GraphicsEngine
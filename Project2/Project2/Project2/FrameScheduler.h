@@ -0,0 +1,33 @@
+#pragma once
+
+#include <windows.h>
+
+namespace GraphicsEngine {
+
+// 帧节拍器：把高频输入（鼠标移动）合并为“最新状态”，每个刷新周期最多渲染一帧
+// 距上一帧已满一个周期时立即渲染（延迟最低），否则挂起并用一次性定时器补一帧
+
+constexpr UINT_PTR FRAME_TIMER_ID = 1;
+
+struct FrameStats {
+    unsigned long long inputEvents = 0;     // 收到的输入事件
+    unsigned long long coalescedEvents = 0; // 被合并到后续帧、没有单独渲染的事件
+    unsigned long long framesRendered = 0;
+    unsigned long long droppedFrames = 0;   // 定时器迟到而错过的刷新周期数
+};
+
+// targetHz <= 0 时使用显示器刷新率
+void InitFrameScheduler(HWND hwnd, int targetHz);
+void ShutdownFrameScheduler();
+void SetTargetFrameRate(int targetHz);
+int GetTargetFrameRate();
+
+// 有新输入：返回 true 表示应立即渲染，false 表示已合并到待渲染的帧
+bool RequestFrame();
+// 处理 WM_TIMER：返回 true 表示挂起的帧现在应当渲染
+bool OnFrameTimer(UINT_PTR timerId);
+// 渲染完一帧后调用
+void FrameRendered();
+const FrameStats& GetFrameStats();
+
+} // namespace GraphicsEngine
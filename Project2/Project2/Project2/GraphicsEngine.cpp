@@ -5,12 +5,20 @@
 #include "Fill.h"
 #include "Transform.h"
 #include "Clip.h"
+#include "SceneRender.h"
+#include "WorkerPool.h"
+#include "DamageRegion.h"
+#include "FrameScheduler.h"
+#include "RenderThread.h"
+#include "PickBuffer.h"
 #include "resource.h"
 
 #include <windowsx.h>
 #include <commdlg.h>
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <string>
 #include <gdiplus.h>
 
 #pragma comment(lib, "gdi32.lib")
@@ -25,24 +33,35 @@ namespace GraphicsEngine {
 
 // ===== Global state definitions =====
 HWND g_hwnd = nullptr;
+// 后台缓冲由渲染线程独占
 HDC g_hdcMem = nullptr;
 HBITMAP g_hbmMem = nullptr;
+PixelSurface g_surface;
 ULONG_PTR g_gdiplusToken;
 
 DrawMode g_currentMode = DrawMode::None;
 std::vector<Shape> g_shapes;
+ShapeIndex g_shapeIndex;
 std::vector<Point> g_currentPoints;
 bool g_isDrawing = false;
 
 COLORREF g_drawColor = RGB(0, 0, 0);
 COLORREF g_fillColor = RGB(253, 151, 47);
 
+std::vector<int> g_selection;
 int g_selectedShapeIndex = -1;
 Point g_firstClick{ 0, 0 };
 double g_scaleBaseDist = 1.0;
 double g_rotBaseAngle = 0.0;
 
 Point g_currentMousePos{ 0, 0 };
+bool g_tiledRender = false;
+bool g_pixelPicking = false;
+// 像素精确拾取的 ID 缓冲，只在 UI 线程上维护；未开启时不跟踪脏区域
+static PickBuffer g_pickBuffer;
+// UI 线程记录的客户区尺寸，随快照交给渲染线程
+static int g_clientWidth = 0;
+static int g_clientHeight = 0;
 
 // 3D Globals
 bool is3DMode = false;
@@ -54,16 +73,66 @@ Light g_light = { {5, 10, 5}, {0.2f, 0.2f, 0.2f, 1.0f}, {0.8f, 0.8f, 0.8f, 1.0f}
 Point g_lastMousePos = {0, 0};
 bool g_isSettingLightPos = false;
 
+// 变换拖动的静态背景层：拖动开始时把未选中的图形画一次，
+// 之后每帧只从它拷贝背景，再把变换中的选中图形画在最上面
+// UI 线程只记录是否在拖动，背景层本身由渲染线程在第一帧按快照生成
+static bool g_dragLayerActive = false;
+
+static void BeginDragLayer() {
+    g_dragLayerActive = true;
+}
+
+static void EndDragLayer() {
+    g_dragLayerActive = false;
+}
+
+// 变换模式下在空白处按下后进入框选，第二次点击确定选框
+static bool g_rubberBand = false;
+// 选中图形较多时只画总包围盒，不再逐个画高亮与控制点
+static const size_t SELECTION_DETAIL_LIMIT = 64;
+
+// 最近一次改动后的图形表副本（结构数组），供快照共享；图形改动时置空，发布下一帧时重新拷贝
+static std::shared_ptr<const ShapeStore> g_sceneShapes;
+
+static void MarkShapesChanged() {
+    g_sceneShapes.reset();
+}
+
+static const std::shared_ptr<const ShapeStore>& SceneShapes() {
+    if (!g_sceneShapes) {
+        auto store = std::make_shared<ShapeStore>();
+        BuildShapeStore(*store, g_shapes);
+        g_sceneShapes = store;
+    }
+    return g_sceneShapes;
+}
+
+// 选中下标的副本，供快照共享；选择改变时置空
+static std::shared_ptr<const std::vector<int>> g_sceneSelection;
+
+static const std::shared_ptr<const std::vector<int>>& SceneSelection() {
+    if (!g_sceneSelection)
+        g_sceneSelection = std::make_shared<const std::vector<int>>(g_selection);
+    return g_sceneSelection;
+}
+
+static void UpdateClientSize(HWND hwnd) {
+    RECT rc{};
+    GetClientRect(hwnd, &rc);
+    g_clientWidth = rc.right - rc.left;
+    g_clientHeight = rc.bottom - rc.top;
+}
+
 // ===== Internal helper functions =====
-void RecreateBackBuffer(HWND hwnd) {
-    if (!hwnd) return;
-    HDC hdc = GetDC(hwnd);
+// 渲染线程调用：按快照中的客户区尺寸重建后台缓冲
+void RecreateBackBuffer(int width, int height) {
+    if (!g_hwnd) return;
+    HDC hdc = GetDC(g_hwnd);
     if (!g_hdcMem) {
         g_hdcMem = CreateCompatibleDC(hdc);
     }
-    RECT rc{};
-    GetClientRect(hwnd, &rc);
-    HBITMAP newBitmap = CreateCompatibleBitmap(hdc, rc.right - rc.left, rc.bottom - rc.top);
+    // 使用 DIB 段作为后台缓冲，光栅算法通过 g_surface 直接写像素内存
+    HBITMAP newBitmap = CreateDIBSurface(hdc, width, height, g_surface);
     HBITMAP oldBitmap = static_cast<HBITMAP>(SelectObject(g_hdcMem, newBitmap));
     if (oldBitmap && oldBitmap != g_hbmMem) {
         DeleteObject(oldBitmap);
@@ -72,18 +141,183 @@ void RecreateBackBuffer(HWND hwnd) {
         DeleteObject(g_hbmMem);
     }
     g_hbmMem = newBitmap;
-    ReleaseDC(hwnd, hdc);
+    ReleaseDC(g_hwnd, hdc);
+}
+
+// ===== 脏矩形跟踪 =====
+// 选中高亮（虚线包围盒、控制点）相对图形向外扩出的像素数
+static const int HIGHLIGHT_MARGIN = 8;
+// 上一帧叠加层（变换预览、高亮、裁剪框、绘制中的橡皮筋线）占用的范围，下一帧先擦除
+static DamageRegion g_overlayDamage;
+static void RenderInteractiveFrame();
+static void RenderThreadStart();
+static void RenderThreadFrame(const FrameSnapshot& frame);
+static void RenderThreadStop();
+static void LoadCameraMatrices(const Camera& cam, int width, int height);
+
+static void InvalidateDamage(const DamageRegion& d) {
+    if (g_pixelPicking) InvalidatePickBuffer(g_pickBuffer, d);
+    if (!g_hwnd) return;
+    for (auto& rc : d.rects)
+        InvalidateRect(g_hwnd, &rc, FALSE);
+}
+
+// 标记图形当前占用的范围需要重绘；图形改动前后各调用一次
+static void InvalidateShape(const Shape& s) {
+    MarkShapesChanged();
+    DamageRegion d;
+    AddShapeDamage(d, s, HIGHLIGHT_MARGIN);
+    InvalidateDamage(d);
+}
+
+static void InvalidateOverlay() {
+    InvalidateDamage(g_overlayDamage);
+}
+
+static bool IsTransformMode(DrawMode m) {
+    return m == DrawMode::TransformTranslate || m == DrawMode::TransformScale ||
+        m == DrawMode::TransformRotate;
+}
+
+// 选中图形的总包围盒；m 非空时为按 m 变换后的
+static bool SelectionBounds(const Affine2D* m, RECT& out) {
+    bool any = false;
+    for (int i : g_selection) {
+        RECT rc;
+        if (!(m ? TransformedShapeBounds(g_shapes[i], *m, rc) : ShapeBounds(g_shapes[i], rc))) continue;
+        if (!any) {
+            out = rc;
+            any = true;
+            continue;
+        }
+        out.left = (std::min)(out.left, rc.left);
+        out.top = (std::min)(out.top, rc.top);
+        out.right = (std::max)(out.right, rc.right);
+        out.bottom = (std::max)(out.bottom, rc.bottom);
+    }
+    return any;
+}
+
+// 选中高亮（各图形的高亮与总包围盒）占用的范围；m 非空时为拖动预览的位置
+static void AddSelectionDamage(DamageRegion& d, const Affine2D* m) {
+    for (int i : g_selection) {
+        RECT rc;
+        if (!(m ? TransformedShapeBounds(g_shapes[i], *m, rc) : ShapeBounds(g_shapes[i], rc))) continue;
+        InflateRect(&rc, HIGHLIGHT_MARGIN, HIGHLIGHT_MARGIN);
+        AddDamage(d, rc);
+    }
+    RECT all;
+    if (g_selection.size() > 1 && SelectionBounds(m, all)) {
+        InflateRect(&all, HIGHLIGHT_MARGIN, HIGHLIGHT_MARGIN);
+        AddDamage(d, all);
+    }
+}
+
+static void InvalidateSelection() {
+    if (g_selection.empty()) return;
+    DamageRegion d;
+    AddSelectionDamage(d, nullptr);
+    InvalidateDamage(d);
+}
+
+// 替换选择集，新旧高亮都要重绘
+static void SetSelection(std::vector<int> sel) {
+    InvalidateSelection();
+    std::sort(sel.begin(), sel.end());
+    sel.erase(std::unique(sel.begin(), sel.end()), sel.end());
+    g_selection = std::move(sel);
+    g_sceneSelection.reset();
+    InvalidateSelection();
+    if (g_selection.empty()) g_selectedShapeIndex = -1;
+}
+
+// 图形下标失效（清空、裁剪删去图形）时直接丢弃选择集，旧下标不能再用来算脏区域
+static void DropSelection() {
+    g_selection.clear();
+    g_sceneSelection.reset();
+    g_selectedShapeIndex = -1;
+}
+
+// 对选中的所有图形施加同一个变换（顶点计算分到工作线程上），并同步索引与脏区域
+static void TransformSelection(const Affine2D& m) {
+    MarkShapesChanged();
+    InvalidateSelection();
+    TransformShapes(g_shapes, g_selection, m);
+    for (int i : g_selection)
+        IndexShape(g_shapeIndex, i, g_shapes[i]);
+    InvalidateSelection();
+}
+
+// 点 (x, y) 处的图形：开启像素精确拾取时读 ID 缓冲，否则按 PointInShape 判断
+static int PickShape(int x, int y) {
+    if (!g_pixelPicking)
+        return HitTestShape(g_shapes, g_shapeIndex, x, y);
+    ResizePickBuffer(g_pickBuffer, g_clientWidth, g_clientHeight);
+    return PickShapeAt(g_pickBuffer, g_shapes, g_shapeIndex, x, y);
+}
+
+// 裁剪会改动的图形：类型匹配且没有完全落在裁剪框内（完全在框内的图形裁剪后不变）
+// 直线裁剪同时裁剪圆、圆弧与 B 样条；clip 为空时（多边形窗口）类型匹配的图形都算
+static void DamageClippedShapes(DamageRegion& d, const RECT* clip, bool lines) {
+    for (const auto& s : g_shapes) {
+        bool isClosed = IsClosedShape(s);
+        bool isStroke = !isClosed && (s.type == DrawMode::DrawLineMidpoint || s.type == DrawMode::DrawLineBresenham ||
+            s.type == DrawMode::DrawLineRunSlice || s.type == DrawMode::DrawCircleMidpoint ||
+            s.type == DrawMode::DrawCircleBresenham || s.type == DrawMode::DrawArc ||
+            s.type == DrawMode::DrawBSpline);
+        if (lines ? !isStroke : !isClosed) continue;
+        RECT b;
+        if (!ShapeBounds(s, b)) continue;
+        if (clip && b.left >= clip->left && b.top >= clip->top && b.right <= clip->right && b.bottom <= clip->bottom)
+            continue;
+        AddShapeDamage(d, s, HIGHLIGHT_MARGIN);
+    }
+}
+
+// 用绘制好的多边形窗口裁剪所有闭合图形；之后可以接着画下一个窗口
+static void ClipWithWindow() {
+    if (g_currentPoints.size() >= 3) {
+        DamageRegion damage;
+        DamageClippedShapes(damage, nullptr, false);
+        ClipAllPolygons_Window(g_currentPoints);
+        MarkShapesChanged();
+        InvalidatePickBuffer(g_pickBuffer);
+        DropSelection();
+        InvalidateDamage(damage);
+    }
+    g_currentPoints.clear();
+    InvalidateOverlay();
+}
+
+// 对选中的图形做布尔运算，结果替换下标最小的闭合图形并保持选中
+static void CombineSelection(BooleanOp op) {
+    if (g_selection.size() < 2) return;
+    DamageRegion damage;
+    for (int i : g_selection)
+        AddShapeDamage(damage, g_shapes[i], HIGHLIGHT_MARGIN);
+    int result;
+    if (!CombineShapes(g_selection, op, result)) return;
+    MarkShapesChanged();
+    InvalidatePickBuffer(g_pickBuffer);
+    DropSelection();
+    InvalidateDamage(damage);
+    if (result >= 0) SetSelection({ result });
 }
 
 static void FinishDrawing() {
+    if (g_currentMode == DrawMode::ClipPolyWindow) {
+        ClipWithWindow();
+        return;
+    }
     if (g_currentPoints.empty()) { g_isDrawing = false; return; }
 
     Shape s;
     s.type = g_currentMode;
-    s.vertices = g_currentPoints;
+    s.vertices.assign(g_currentPoints);
     s.color = g_drawColor;
     s.fillColor = g_fillColor;
     s.fillMode = 0;
+    TouchShape(s);
 
     if (s.type == DrawMode::DrawPolygon && s.vertices.size() < 3) {
         // ignore invalid polygon
@@ -93,6 +327,8 @@ static void FinishDrawing() {
     }
     else {
         g_shapes.push_back(s);
+        IndexShape(g_shapeIndex, (int)g_shapes.size() - 1, s);
+        InvalidateShape(s);
     }
 
     g_currentPoints.clear();
@@ -100,65 +336,68 @@ static void FinishDrawing() {
         g_currentMode != DrawMode::DrawBSpline) {
         g_isDrawing = false;
     }
-    if (g_hwnd)
-        InvalidateRect(g_hwnd, NULL, FALSE);
+    InvalidateOverlay();
 }
 
 static void ClearCanvas() {
+    EndDragLayer();
+    MarkShapesChanged();
     g_shapes.clear();
+    ResetShapeIndex(g_shapeIndex);
+    InvalidatePickBuffer(g_pickBuffer);
     g_currentPoints.clear();
     g_isDrawing = false;
     g_currentMode = DrawMode::None;
-    g_selectedShapeIndex = -1;
+    g_rubberBand = false;
+    DropSelection();
     if (g_hwnd)
         InvalidateRect(g_hwnd, NULL, TRUE);
 }
 
-static void RedrawAllShapesOn(HDC hdc, const std::vector<Shape>& shapes, int highlightIndex = -1) {
-    for (size_t i = 0; i < shapes.size(); i++) {
-        const auto& s = shapes[i];
-        if (s.fillMode == 1)
-            FillShapeScanline(hdc, s, s.fillColor);
-        else if (s.fillMode == 2)
-            FillShapeFence(hdc, s, s.fillColor);
-        DrawShapeBorder(hdc, s);
-        
-        // 高亮显示选中的图形
-        if ((int)i == highlightIndex && !s.vertices.empty()) {
-            // 绘制选中边框（虚线）
-            HPEN hPenHighlight = CreatePen(PS_DASH, 2, RGB(0, 120, 255));
-            HPEN hOldPen = (HPEN)SelectObject(hdc, hPenHighlight);
-            HBRUSH hOldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
-            
-            // 计算包围盒
-            LONG minX = s.vertices[0].x, maxX = s.vertices[0].x;
-            LONG minY = s.vertices[0].y, maxY = s.vertices[0].y;
-            for (const auto& v : s.vertices) {
-                if (v.x < minX) minX = v.x;
-                if (v.x > maxX) maxX = v.x;
-                if (v.y < minY) minY = v.y;
-                if (v.y > maxY) maxY = v.y;
-            }
-            // 绘制包围盒
-            Rectangle(hdc, minX - 5, minY - 5, maxX + 5, maxY + 5);
-            
-            // 绘制控制点
-            HBRUSH hBrushPoint = CreateSolidBrush(RGB(0, 120, 255));
-            for (const auto& v : s.vertices) {
-                RECT rcPoint = { v.x - 4, v.y - 4, v.x + 4, v.y + 4 };
-                FillRect(hdc, &rcPoint, hBrushPoint);
-            }
-            DeleteObject(hBrushPoint);
-            
-            SelectObject(hdc, hOldBrush);
-            SelectObject(hdc, hOldPen);
-            DeleteObject(hPenHighlight);
-        }
+// 选中图形的高亮：虚线包围盒 + 控制点（GDI 绘制）
+static void DrawSelectionHighlight(HDC hdc, const Shape& s) {
+    if (s.vertices.empty()) return;
+    // 绘制选中边框（虚线）
+    HPEN hPenHighlight = CreatePen(PS_DASH, 2, RGB(0, 120, 255));
+    HPEN hOldPen = (HPEN)SelectObject(hdc, hPenHighlight);
+    HBRUSH hOldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
+
+    // 中点分割裁剪过的直线只标出可见部分的两端
+    Point ends[2];
+    const Point* pts = s.vertices.data();
+    size_t n = s.vertices.size();
+    if (ShapeLineSteps(s).last >= 0) {
+        LineVisibleEnds(s, ends[0], ends[1]);
+        pts = ends;
+        n = 2;
     }
-}
 
-static void RedrawAllShapes(HDC hdc) {
-    RedrawAllShapesOn(hdc, g_shapes);
+    // 计算包围盒
+    LONG minX = pts[0].x, maxX = pts[0].x;
+    LONG minY = pts[0].y, maxY = pts[0].y;
+    for (size_t i = 0; i < n; ++i) {
+        const Point& v = pts[i];
+        if (v.x < minX) minX = v.x;
+        if (v.x > maxX) maxX = v.x;
+        if (v.y < minY) minY = v.y;
+        if (v.y > maxY) maxY = v.y;
+    }
+    // 绘制包围盒
+    Rectangle(hdc, minX - 5, minY - 5, maxX + 5, maxY + 5);
+
+    // 绘制控制点
+    HBRUSH hBrushPoint = CreateSolidBrush(RGB(0, 120, 255));
+    for (size_t i = 0; i < n; ++i) {
+        const Point& v = pts[i];
+        RECT rcPoint = { v.x - 4, v.y - 4, v.x + 4, v.y + 4 };
+        FillRect(hdc, &rcPoint, hBrushPoint);
+    }
+    DeleteObject(hBrushPoint);
+
+    SelectObject(hdc, hOldBrush);
+    SelectObject(hdc, hOldPen);
+    DeleteObject(hPenHighlight);
+    GdiFlush();
 }
 
 // ===== Public API =====
@@ -167,35 +406,39 @@ void Initialize(HWND hwnd) {
     GdiplusStartup(&g_gdiplusToken, &gdiplusStartupInput, NULL);
 
     g_hwnd = hwnd;
-    RecreateBackBuffer(hwnd);
+    UpdateClientSize(hwnd);
     InitGL(hwnd);
+    InitFrameScheduler(hwnd, 0);
+    // GL 像素格式须先由 InitGL 设置好，渲染线程才能创建自己的上下文
+    StartRenderThread({ RenderThreadStart, RenderThreadFrame, RenderThreadStop });
 }
 
 void Shutdown() {
-    if (g_hbmMem) {
-        DeleteObject(g_hbmMem);
-        g_hbmMem = nullptr;
-    }
-    if (g_hdcMem) {
-        DeleteDC(g_hdcMem);
-        g_hdcMem = nullptr;
-    }
+    // 先停渲染线程：它独占后台缓冲并共享 g_hRC 的纹理
+    StopRenderThread();
+    EndDragLayer();
+    MarkShapesChanged();
     if (g_hRC) {
         wglDeleteContext(g_hRC);
         g_hRC = nullptr;
     }
     g_hwnd = nullptr;
     g_shapes.clear();
+    ResetShapeIndex(g_shapeIndex);
     g_currentPoints.clear();
     g_isDrawing = false;
-    g_selectedShapeIndex = -1;
+    g_rubberBand = false;
+    DropSelection();
+    ShutdownWorkerPool();
+    ShutdownFrameScheduler();
 
     GdiplusShutdown(g_gdiplusToken);
 }
 
 void Resize(HWND hwnd) {
     g_hwnd = hwnd;
-    RecreateBackBuffer(hwnd);
+    // 后台缓冲由渲染线程在收到新尺寸的快照时重建
+    UpdateClientSize(hwnd);
     InvalidateRect(hwnd, NULL, FALSE);
 }
 
@@ -258,11 +501,17 @@ void HandleCommand(int commandId) {
         return;
     }
 
+    // 切换工具会中断正在进行的拖动与框选；选择集保留，但只在变换模式下显示
+    EndDragLayer();
+    g_rubberBand = false;
+    bool wasTransform = IsTransformMode(g_currentMode);
     switch (commandId) {
     case ID_DRAW_LINE_MIDPOINT:
         g_currentMode = DrawMode::DrawLineMidpoint;   g_currentPoints.clear(); g_isDrawing = false; break;
     case ID_DRAW_LINE_BRESENHAM:
         g_currentMode = DrawMode::DrawLineBresenham;  g_currentPoints.clear(); g_isDrawing = false; break;
+    case ID_DRAW_LINE_RUNSLICE:
+        g_currentMode = DrawMode::DrawLineRunSlice;   g_currentPoints.clear(); g_isDrawing = false; break;
     case ID_DRAW_CIRCLE_MIDPOINT:
         g_currentMode = DrawMode::DrawCircleMidpoint; g_currentPoints.clear(); g_isDrawing = false; break;
     case ID_DRAW_CIRCLE_BRESENHAM:
@@ -278,26 +527,59 @@ void HandleCommand(int commandId) {
     case ID_FILL_FENCE:
         g_currentMode = DrawMode::FillFence;          break;
     case ID_TRANS_TRANSLATE:
-        g_currentMode = DrawMode::TransformTranslate; g_isDrawing = false; g_selectedShapeIndex = -1; break;
+        g_currentMode = DrawMode::TransformTranslate; g_isDrawing = false; break;
     case ID_TRANS_SCALE:
-        g_currentMode = DrawMode::TransformScale;     g_isDrawing = false; g_selectedShapeIndex = -1; break;
+        g_currentMode = DrawMode::TransformScale;     g_isDrawing = false; break;
     case ID_TRANS_ROTATE:
-        g_currentMode = DrawMode::TransformRotate;    g_isDrawing = false; g_selectedShapeIndex = -1; break;
+        g_currentMode = DrawMode::TransformRotate;    g_isDrawing = false; break;
     case ID_CLIP_LINE_CS:
         g_currentMode = DrawMode::ClipLineCS;         g_isDrawing = false; break;
     case ID_CLIP_LINE_MID:
         g_currentMode = DrawMode::ClipLineMid;        g_isDrawing = false; break;
+    case ID_CLIP_LINE_LB:
+        g_currentMode = DrawMode::ClipLineLB;         g_isDrawing = false; break;
     case ID_CLIP_POLY_SH:
         g_currentMode = DrawMode::ClipPolySH;         g_isDrawing = false; break;
     case ID_CLIP_POLY_WA:
         g_currentMode = DrawMode::ClipPolyWA;         g_isDrawing = false; break;
+    case ID_CLIP_POLY_WINDOW:
+        g_currentMode = DrawMode::ClipPolyWindow;     g_currentPoints.clear(); g_isDrawing = true;  break;
+    case ID_BOOL_UNION:
+        CombineSelection(BooleanOp::Union);           break;
+    case ID_BOOL_INTERSECT:
+        CombineSelection(BooleanOp::Intersection);    break;
+    case ID_BOOL_DIFFERENCE:
+        CombineSelection(BooleanOp::Difference);      break;
+    case ID_BOOL_XOR:
+        CombineSelection(BooleanOp::Xor);             break;
     case ID_EDIT_FINISH:
         FinishDrawing();                              break;
     case ID_EDIT_CLEAR:
         ClearCanvas();                                break;
+    case ID_VIEW_TILED_RENDER:
+        g_tiledRender = !g_tiledRender;
+        InvalidateRect(g_hwnd, NULL, FALSE);
+        break;
+    case ID_VIEW_PIXEL_PICKING:
+        g_pixelPicking = !g_pixelPicking;
+        // 关闭期间没有跟踪脏区域
+        if (g_pixelPicking) InvalidatePickBuffer(g_pickBuffer);
+        break;
+    case ID_VIEW_FRAME_STATS: {
+        const FrameStats& st = GetFrameStats();
+        std::wstring msg = L"目标帧率: " + std::to_wstring(GetTargetFrameRate()) + L" Hz"
+            + L"\n输入事件: " + std::to_wstring(st.inputEvents)
+            + L"\n合并的事件: " + std::to_wstring(st.coalescedEvents)
+            + L"\n渲染帧数: " + std::to_wstring(st.framesRendered)
+            + L"\n丢帧: " + std::to_wstring(st.droppedFrames)
+            + L"\n被覆盖的快照: " + std::to_wstring(SupersededFrameCount());
+        MessageBox(g_hwnd, msg.c_str(), L"帧统计", MB_OK | MB_ICONINFORMATION);
+    } break;
     default:
         break;
     }
+    if (wasTransform != IsTransformMode(g_currentMode))
+        InvalidateSelection();
 }
 
 void SetLightPositionFromScreen(int x, int y) {
@@ -305,6 +587,10 @@ void SetLightPositionFromScreen(int x, int y) {
     HDC hdc = GetDC(g_hwnd);
     wglMakeCurrent(hdc, g_hRC);
 
+    // 场景由渲染线程的上下文绘制，这里按当前相机重新设置矩阵后再反投影
+    RECT rc; GetClientRect(g_hwnd, &rc);
+    LoadCameraMatrices(g_camera, rc.right - rc.left, rc.bottom - rc.top);
+
     GLdouble modelview[16], projection[16];
     GLint viewport[4];
     glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
@@ -335,6 +621,100 @@ void SetLightPositionFromScreen(int x, int y) {
     InvalidateRect(g_hwnd, NULL, FALSE);
 }
 
+// 变换拖动中按鼠标位置得到的变换，以第一次点击处为中心
+static bool GetDragTransform(int x, int y, Affine2D& m) {
+    if (!g_isDrawing || g_rubberBand || g_selection.empty()) return false;
+
+    double ddx = x - g_firstClick.x;
+    double ddy = y - g_firstClick.y;
+    switch (g_currentMode) {
+    case DrawMode::TransformTranslate:
+        m = AffineTranslate(x - g_firstClick.x, y - g_firstClick.y);
+        return true;
+    case DrawMode::TransformScale: {
+        double dist = std::sqrt(ddx * ddx + ddy * ddy);
+        double s = dist / g_scaleBaseDist;
+        if (s < 0.01) s = 0.01;
+        m = AffineScale(g_firstClick, s, s);
+    } return true;
+    case DrawMode::TransformRotate: {
+        double ang1 = std::atan2(ddy, ddx);
+        m = AffineRotate(g_firstClick, ang1 - g_rotBaseAngle);
+    } return true;
+    default:
+        return false;
+    }
+}
+
+// 变换模式下的第一次点击：点中图形开始拖动整个选择集（按住 Shift 则切换该图形是否选中），
+// 点在空白处开始框选
+static void BeginTransformClick(int x, int y) {
+    bool additive = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
+    int idx = PickShape(x, y);
+    g_firstClick = { x, y };
+    if (idx < 0) {
+        g_rubberBand = true;
+        g_isDrawing = true;
+        return;
+    }
+
+    bool selected = std::binary_search(g_selection.begin(), g_selection.end(), idx);
+    if (additive) {
+        std::vector<int> sel = g_selection;
+        if (selected)
+            sel.erase(std::lower_bound(sel.begin(), sel.end(), idx));
+        else
+            sel.push_back(idx);
+        SetSelection(std::move(sel));
+        if (!selected) g_selectedShapeIndex = idx;
+        return;
+    }
+    if (!selected)
+        SetSelection({ idx });
+
+    g_selectedShapeIndex = idx;
+    // 缩放、旋转的基准：点中图形的首顶点相对点击处的距离与角度
+    if (!g_shapes[idx].vertices.empty()) {
+        Point v0 = g_shapes[idx].vertices[0], v1;
+        if (ShapeLineSteps(g_shapes[idx]).last >= 0)
+            LineVisibleEnds(g_shapes[idx], v0, v1);
+        double ddx = v0.x - g_firstClick.x;
+        double ddy = v0.y - g_firstClick.y;
+        g_scaleBaseDist = std::sqrt(ddx * ddx + ddy * ddy);
+        if (g_scaleBaseDist < 1) g_scaleBaseDist = 1;
+        g_rotBaseAngle = std::atan2(ddy, ddx);
+    }
+    g_isDrawing = true;
+    BeginDragLayer();
+}
+
+// 框选的第二次点击：选中包围盒完全落在选框内的图形，按住 Shift 则加入原选择集
+static void FinishRubberBand(int x, int y) {
+    bool additive = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
+    RECT band;
+    band.left = (std::min)(g_firstClick.x, x);
+    band.right = (std::max)(g_firstClick.x, x);
+    band.top = (std::min)(g_firstClick.y, y);
+    band.bottom = (std::max)(g_firstClick.y, y);
+
+    std::vector<int> candidates;
+    QueryShapeIndex(g_shapeIndex, band, candidates);
+    std::vector<int> sel;
+    if (additive) sel = g_selection;
+    for (int i : candidates) {
+        RECT b;
+        // ShapeBounds 在顶点外留有 1~2 像素余量
+        if (ShapeBounds(g_shapes[i], b) && b.left + 1 >= band.left && b.top + 1 >= band.top &&
+            b.right - 2 <= band.right && b.bottom - 2 <= band.bottom)
+            sel.push_back(i);
+    }
+    SetSelection(std::move(sel));
+
+    g_rubberBand = false;
+    g_isDrawing = false;
+    InvalidateOverlay();
+}
+
 void HandleLButtonDown(int x, int y) {
     if (is3DMode) {
         if (g_isSettingLightPos) {
@@ -351,6 +731,7 @@ void HandleLButtonDown(int x, int y) {
     switch (g_currentMode) {
     case DrawMode::DrawLineMidpoint:
     case DrawMode::DrawLineBresenham:
+    case DrawMode::DrawLineRunSlice:
     case DrawMode::DrawCircleMidpoint:
     case DrawMode::DrawCircleBresenham:
     case DrawMode::DrawRectangle:
@@ -367,113 +748,63 @@ void HandleLButtonDown(int x, int y) {
 
     case DrawMode::DrawPolygon:
     case DrawMode::DrawBSpline:
+    case DrawMode::ClipPolyWindow:
         g_currentPoints.push_back({ x, y });
-        if (g_hwnd)
-            InvalidateRect(g_hwnd, NULL, FALSE);
+        InvalidateOverlay();
         break;
 
     case DrawMode::FillScanline:
     case DrawMode::FillFence: {
-        for (auto& s : g_shapes) {
-            if (PointInShape(s, x, y)) {
-                s.fillColor = g_fillColor;
-                if (g_currentMode == DrawMode::FillScanline) {
-                    s.fillMode = 1;
-                    if (g_hdcMem)
-                        FillShapeScanline(g_hdcMem, s, s.fillColor);
-                }
-                else {
-                    s.fillMode = 2;
-                    if (g_hdcMem)
-                        FillShapeFence(g_hdcMem, s, s.fillColor);
-                }
-                if (g_hwnd)
-                    InvalidateRect(g_hwnd, NULL, FALSE);
-                break;
-            }
-        }
-    } break;
-
-    case DrawMode::TransformTranslate: {
-        if (!g_isDrawing) {
-            int idx = HitTestShape(x, y);
+        int fillMode = (g_currentMode == DrawMode::FillScanline) ? 1 : 2;
+        if (g_pixelPicking) {
+            // 填充看得见的最上层图形
+            int idx = PickShape(x, y);
             if (idx >= 0) {
-                g_selectedShapeIndex = idx;
-                g_firstClick = { x, y };
-                g_isDrawing = true;
+                Shape& s = g_shapes[idx];
+                s.fillColor = g_fillColor;
+                s.fillMode = fillMode;
+                TouchShapeStyle(s);
+                InvalidateShape(s);
             }
+            break;
         }
-        else {
-            int dx = x - g_firstClick.x;
-            int dy = y - g_firstClick.y;
-            if (g_selectedShapeIndex >= 0 && g_selectedShapeIndex < (int)g_shapes.size())
-                TranslateShape(g_shapes[g_selectedShapeIndex], dx, dy);
-            g_isDrawing = false;
-            if (g_hwnd)
-                InvalidateRect(g_hwnd, NULL, FALSE);
-        }
-    } break;
-
-    case DrawMode::TransformScale: {
-        if (!g_isDrawing) {
-            int idx = HitTestShape(x, y);
-            if (idx >= 0) {
-                g_selectedShapeIndex = idx;
-                g_firstClick = { x, y };
-                if (!g_shapes[idx].vertices.empty()) {
-                    Point v0 = g_shapes[idx].vertices[0];
-                    double ddx = v0.x - g_firstClick.x;
-                    double ddy = v0.y - g_firstClick.y;
-                    g_scaleBaseDist = std::sqrt(ddx * ddx + ddy * ddy);
-                    if (g_scaleBaseDist < 1) g_scaleBaseDist = 1;
-                }
-                g_isDrawing = true;
+        // 与逐个扫描一致：填充图形表中最先命中的图形
+        std::vector<int> candidates;
+        QueryShapeIndexPoint(g_shapeIndex, x, y, candidates);
+        for (int i : candidates) {
+            Shape& s = g_shapes[i];
+            if (PointInShape(s, x, y)) {
+                s.fillColor = g_fillColor;
+                s.fillMode = fillMode;
+                TouchShapeStyle(s);
+                InvalidateShape(s);
+                break;
             }
         }
-        else {
-            double ddx = x - g_firstClick.x;
-            double ddy = y - g_firstClick.y;
-            double dist = std::sqrt(ddx * ddx + ddy * ddy);
-            double s = dist / g_scaleBaseDist;
-            if (s < 0.01) s = 0.01;
-            if (g_selectedShapeIndex >= 0 && g_selectedShapeIndex < (int)g_shapes.size())
-                ScaleShape(g_shapes[g_selectedShapeIndex], g_firstClick, s, s);
-            g_isDrawing = false;
-            if (g_hwnd)
-                InvalidateRect(g_hwnd, NULL, FALSE);
-        }
     } break;
 
+    case DrawMode::TransformTranslate:
+    case DrawMode::TransformScale:
     case DrawMode::TransformRotate: {
         if (!g_isDrawing) {
-            int idx = HitTestShape(x, y);
-            if (idx >= 0) {
-                g_selectedShapeIndex = idx;
-                g_firstClick = { x, y };
-                if (!g_shapes[idx].vertices.empty()) {
-                    Point v0 = g_shapes[idx].vertices[0];
-                    double ddx = v0.x - g_firstClick.x;
-                    double ddy = v0.y - g_firstClick.y;
-                    g_rotBaseAngle = std::atan2(ddy, ddx);
-                }
-                g_isDrawing = true;
-            }
+            BeginTransformClick(x, y);
+        }
+        else if (g_rubberBand) {
+            FinishRubberBand(x, y);
         }
         else {
-            double ddx = x - g_firstClick.x;
-            double ddy = y - g_firstClick.y;
-            double ang1 = std::atan2(ddy, ddx);
-            double delta = ang1 - g_rotBaseAngle;
-            if (g_selectedShapeIndex >= 0 && g_selectedShapeIndex < (int)g_shapes.size())
-                RotateShape(g_shapes[g_selectedShapeIndex], g_firstClick, delta);
+            Affine2D m;
+            if (GetDragTransform(x, y, m))
+                TransformSelection(m);
             g_isDrawing = false;
-            if (g_hwnd)
-                InvalidateRect(g_hwnd, NULL, FALSE);
+            EndDragLayer();
+            InvalidateOverlay();
         }
     } break;
 
     case DrawMode::ClipLineCS:
     case DrawMode::ClipLineMid:
+    case DrawMode::ClipLineLB:
     case DrawMode::ClipPolySH:
     case DrawMode::ClipPolyWA: {
         if (!g_isDrawing) {
@@ -489,17 +820,31 @@ void HandleLButtonDown(int x, int y) {
             rc.top = (std::min)(g_firstClick.y, p2.y);
             rc.bottom = (std::max)(g_firstClick.y, p2.y);
 
-            if (g_currentMode == DrawMode::ClipLineCS)
-                ClipAllLines_CohenSutherland(rc);
-            else if (g_currentMode == DrawMode::ClipLineMid)
-                ClipAllLines_Midpoint(rc);
+            bool lines = g_currentMode == DrawMode::ClipLineCS || g_currentMode == DrawMode::ClipLineMid ||
+                g_currentMode == DrawMode::ClipLineLB;
+            DamageRegion damage;
+            DamageClippedShapes(damage, &rc, lines);
+
+            if (lines) {
+                if (g_currentMode == DrawMode::ClipLineCS)
+                    ClipAllLines_CohenSutherland(rc);
+                else if (g_currentMode == DrawMode::ClipLineMid)
+                    ClipAllLines_Midpoint(rc);
+                else
+                    ClipAllLines_LiangBarsky(rc);
+                ClipAllCurves(rc);
+            }
             else if (g_currentMode == DrawMode::ClipPolySH)
                 ClipAllPolygons_SH(rc);
             else if (g_currentMode == DrawMode::ClipPolyWA)
                 ClipAllPolygons_WA(rc);
 
-            if (g_hwnd)
-                InvalidateRect(g_hwnd, NULL, FALSE);
+            MarkShapesChanged();
+            // 裁剪会删去图形，其后图形的下标都变了
+            InvalidatePickBuffer(g_pickBuffer);
+            DropSelection();
+            InvalidateDamage(damage);
+            InvalidateOverlay();
         }
     } break;
 
@@ -507,9 +852,9 @@ void HandleLButtonDown(int x, int y) {
     }
 }
 
-// 绘制裁剪预览矩形
-static void DrawClipPreviewRect(HDC hdc, const Point& p1, const Point& p2) {
-    HPEN hPen = CreatePen(PS_DASH, 1, RGB(255, 0, 0));
+// 绘制裁剪预览矩形（框选也用它）
+static void DrawClipPreviewRect(HDC hdc, const Point& p1, const Point& p2, COLORREF color = RGB(255, 0, 0)) {
+    HPEN hPen = CreatePen(PS_DASH, 1, color);
     HPEN hOldPen = (HPEN)SelectObject(hdc, hPen);
     HBRUSH hOldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
     
@@ -525,6 +870,360 @@ static void DrawClipPreviewRect(HDC hdc, const Point& p1, const Point& p2) {
     DeleteObject(hPen);
 }
 
+static bool IsClipMode(DrawMode m) {
+    return m == DrawMode::ClipLineCS || m == DrawMode::ClipLineMid || m == DrawMode::ClipLineLB ||
+        m == DrawMode::ClipPolySH || m == DrawMode::ClipPolyWA;
+}
+
+// 当前叠加层会覆盖的范围
+static void CollectOverlayDamage(DamageRegion& d, const Affine2D* preview) {
+    if (preview) {
+        // 原位置的选中图形在拖动中被预览替代，也要重绘
+        AddSelectionDamage(d, nullptr);
+        AddSelectionDamage(d, preview);
+    }
+    if (!g_isDrawing) return;
+
+    Point m = g_currentMousePos;
+    if (IsClipMode(g_currentMode) || g_rubberBand) {
+        RECT rc = { (std::min)(g_firstClick.x, m.x) - 2, (std::min)(g_firstClick.y, m.y) - 2,
+            (std::max)(g_firstClick.x, m.x) + 3, (std::max)(g_firstClick.y, m.y) + 3 };
+        AddDamage(d, rc);
+    }
+    if (!g_currentPoints.empty()) {
+        // 绘制中的折线、橡皮筋线与 B 样条控制点（半径 3 的圆）
+        RECT rc = { m.x, m.y, m.x, m.y };
+        for (auto& p : g_currentPoints) {
+            rc.left = (std::min)(rc.left, (LONG)p.x);
+            rc.top = (std::min)(rc.top, (LONG)p.y);
+            rc.right = (std::max)(rc.right, (LONG)p.x);
+            rc.bottom = (std::max)(rc.bottom, (LONG)p.y);
+        }
+        InflateRect(&rc, 4, 4);
+        rc.right++;
+        rc.bottom++;
+        AddDamage(d, rc);
+    }
+}
+
+// ===== 渲染线程：二维合成 =====
+// 以下函数只在渲染线程上运行，只读快照，只写渲染线程独占的后台缓冲与背景层
+
+// 由快照图形表编译出的命令缓冲；图形表换了才更新，且只重新编译改动过的图形
+static CommandBuffer g_sceneCommands;
+static std::shared_ptr<const ShapeStore> g_sceneCommandsShapes;
+
+static const CommandBuffer& SceneCommands(const Scene2DSnapshot& scene) {
+    if (g_sceneCommandsShapes != scene.shapes) {
+        static const ShapeStore noShapes;
+        UpdateCommandBuffer(g_sceneCommands, scene.shapes ? *scene.shapes : noShapes);
+        g_sceneCommandsShapes = scene.shapes;
+    }
+    return g_sceneCommands;
+}
+
+// 拖动背景层及其对应的图形表、排除的选择集
+static HeapSurface g_dragLayer;
+static std::shared_ptr<const ShapeStore> g_dragLayerShapes;
+static std::shared_ptr<const std::vector<int>> g_dragLayerSkip;
+
+// 快照需要背景层时确保它与快照一致，必要时重新生成
+static bool PrepareDragLayer(const Scene2DSnapshot& scene) {
+    if (!scene.useDragLayer || !scene.hasPreview || !scene.shapes || !scene.selection) return false;
+    if (g_dragLayerShapes == scene.shapes && g_dragLayerSkip == scene.selection &&
+        g_dragLayer.surface.width == g_surface.width && g_dragLayer.surface.height == g_surface.height)
+        return true;
+
+    CreateHeapSurface(g_dragLayer, g_surface.width, g_surface.height);
+    const CommandBuffer& cb = SceneCommands(scene);
+    if (scene.tiled)
+        RenderCommandsTiled(g_dragLayer.surface, cb, scene.selection.get());
+    else
+        ReplayCommands(g_dragLayer.surface, cb, scene.selection.get());
+    g_dragLayerShapes = scene.shapes;
+    g_dragLayerSkip = scene.selection;
+    return true;
+}
+
+// 选中的图形：拖动中为按快照变换矩阵变换后的预览，否则为原样（只在需要逐个画高亮时生成）
+// 每帧在渲染线程上生成一次，供各脏矩形共用
+static std::vector<Shape> g_selectionShapes;
+static std::vector<RECT> g_selectionBounds;
+static std::vector<char> g_selectionVisible;
+// 每个并行任务生成的图形数
+static const int SELECTION_BATCH = 256;
+
+static void BuildSelectionShapes(const Scene2DSnapshot& scene) {
+    const std::vector<int>* sel = scene.selection.get();
+    bool needed = scene.showSelection && sel && scene.shapes &&
+        (scene.hasPreview || sel->size() <= SELECTION_DETAIL_LIMIT);
+    if (!needed) {
+        g_selectionShapes.clear();
+        return;
+    }
+    int count = (int)sel->size();
+    g_selectionShapes.resize(count);
+    g_selectionBounds.resize(count);
+    g_selectionVisible.resize(count);
+    int batches = (count + SELECTION_BATCH - 1) / SELECTION_BATCH;
+    ParallelFor(batches, [&](int b) {
+        int end = (std::min)(count, (b + 1) * SELECTION_BATCH);
+        for (int k = b * SELECTION_BATCH; k < end; ++k) {
+            Shape& s = g_selectionShapes[k];
+            LoadShape(*scene.shapes, (*sel)[k], s);
+            if (scene.hasPreview)
+                ApplyPreviewTransform(s, scene.previewTransform);
+            g_selectionVisible[k] = ShapeBounds(s, g_selectionBounds[k]);
+        }
+    });
+}
+
+// 画第 k 个拖动预览图形（平移预览复用选中图形的像素段）
+static void RenderSelectionShape(const CommandBuffer& cb, size_t k, const RECT& rc) {
+    if (!g_selectionVisible[k] || !RectsOverlap(g_selectionBounds[k], rc)) return;
+    if (!ReplayCachedShape(g_surface, cb, g_selectionShapes[k]))
+        RenderShape(g_surface, g_selectionShapes[k]);
+}
+
+// 多个图形选中时的总包围盒（点线）
+static void DrawSelectionBox(HDC hdc, const RECT& rc) {
+    HPEN hPen = CreatePen(PS_DOT, 1, RGB(0, 120, 255));
+    HPEN hOldPen = (HPEN)SelectObject(hdc, hPen);
+    HBRUSH hOldBrush = (HBRUSH)SelectObject(hdc, GetStockObject(NULL_BRUSH));
+    Rectangle(hdc, rc.left - 4, rc.top - 4, rc.right + 4, rc.bottom + 4);
+    SelectObject(hdc, hOldBrush);
+    SelectObject(hdc, hOldPen);
+    DeleteObject(hPen);
+    GdiFlush();
+}
+
+// 叠加层：选中高亮、裁剪框与选框、绘制中图形的预览
+static void DrawOverlays(HDC hdcMem, const Scene2DSnapshot& scene) {
+    if (scene.showSelection && scene.selection) {
+        if (scene.selection->size() > 1)
+            DrawSelectionBox(hdcMem, scene.selectionBounds);
+        if (scene.selection->size() <= SELECTION_DETAIL_LIMIT)
+            for (const Shape& s : g_selectionShapes)
+                DrawSelectionHighlight(hdcMem, s);
+    }
+
+    int x = scene.mousePos.x, y = scene.mousePos.y;
+    // 绘制裁剪预览矩形与框选矩形
+    if (scene.isDrawing && IsClipMode(scene.mode)) {
+        DrawClipPreviewRect(hdcMem, scene.firstClick, { x, y });
+        GdiFlush();
+    }
+    if (scene.isDrawing && scene.rubberBand) {
+        DrawClipPreviewRect(hdcMem, scene.firstClick, { x, y }, RGB(0, 120, 255));
+        GdiFlush();
+    }
+
+    const std::vector<Point>& points = scene.currentPoints;
+    if (scene.isDrawing && !points.empty()) {
+        Point p0 = points[0];
+        switch (scene.mode) {
+        case DrawMode::DrawLineMidpoint:
+            DrawLineMidpoint(g_surface, p0.x, p0.y, x, y, scene.drawColor); break;
+        case DrawMode::DrawLineBresenham:
+            DrawLineBresenham(g_surface, p0.x, p0.y, x, y, scene.drawColor); break;
+        case DrawMode::DrawLineRunSlice:
+            DrawLineRunSlice(g_surface, p0.x, p0.y, x, y, scene.drawColor); break;
+        case DrawMode::DrawPolygon: {
+            if (points.size() > 1)
+                DrawPolyline(g_surface, points, scene.drawColor, false);
+            Point last = points.back();
+            DrawLineMidpoint(g_surface, last.x, last.y, x, y, scene.drawColor);
+        } break;
+        case DrawMode::ClipPolyWindow: {
+            // 裁剪窗口连同鼠标处的点按闭合多边形预览
+            std::vector<Point> window = points;
+            window.push_back({ x, y });
+            DrawPolyline(g_surface, window, RGB(255, 0, 0), window.size() >= 3);
+        } break;
+        case DrawMode::DrawBSpline: {
+            for (auto& p : points)
+                Ellipse(hdcMem, p.x - 3, p.y - 3, p.x + 3, p.y + 3);
+            GdiFlush();
+            std::vector<Point> tempCtrl = points;
+            tempCtrl.push_back({ x, y });
+            if (tempCtrl.size() > 1)
+                DrawPolyline(g_surface, tempCtrl, RGB(200, 200, 200), false);
+            if (tempCtrl.size() >= 4)
+                DrawBSpline(g_surface, tempCtrl, scene.drawColor);
+        } break;
+        default:
+            break;
+        }
+    }
+}
+
+// 只重绘脏区域：清白、画与之相交的图形（按原顺序），再画叠加层
+// 直接写内存的部分靠表面裁剪区限制，GDI 部分靠设备上下文的裁剪区限制
+static void ComposeRegion(HDC hdcMem, const DamageRegion& region, const Scene2DSnapshot& scene) {
+    const CommandBuffer& cb = SceneCommands(scene);
+    BuildSelectionShapes(scene);
+    const std::vector<int>* preview = scene.hasPreview ? scene.selection.get() : nullptr;
+    bool useDragLayer = PrepareDragLayer(scene);
+    GdiFlush();
+    for (const RECT& rc : region.rects) {
+        SetSurfaceClip(g_surface, rc);
+
+        if (useDragLayer) {
+            // 背景层已含其余所有图形，只需拷贝后画上选中图形
+            CopySurfaceRect(g_surface, g_dragLayer.surface, rc);
+            for (size_t k = 0; k < g_selectionShapes.size(); ++k)
+                RenderSelectionShape(cb, k, rc);
+        }
+        else if (scene.tiled && !preview) {
+            ClearSurface(g_surface, RGB(255, 255, 255));
+            RenderCommandsTiled(g_surface, cb);
+        }
+        else {
+            // 重放已编译的图形，拖动中的预览图形按原顺序绘制
+            ClearSurface(g_surface, RGB(255, 255, 255));
+            size_t next = 0;    // 下一个选中图形在选择集中的位置
+            for (size_t i = 0; i < cb.shapes.size(); ++i) {
+                if (preview && next < preview->size() && (*preview)[next] == (int)i) {
+                    RenderSelectionShape(cb, next++, rc);
+                }
+                else if (cb.shapes[i].visible && RectsOverlap(cb.shapes[i].bounds, rc)) {
+                    ReplayShapeCommands(g_surface, cb, (int)i);
+                }
+            }
+        }
+
+        HRGN clip = CreateRectRgnIndirect(&rc);
+        SelectClipRgn(hdcMem, clip);
+        DrawOverlays(hdcMem, scene);
+        SelectClipRgn(hdcMem, NULL);
+        DeleteObject(clip);
+    }
+    ResetSurfaceClip(g_surface);
+}
+
+static void PresentRegion(HDC hdc, const DamageRegion& region) {
+    for (const RECT& rc : region.rects)
+        BitBlt(hdc, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top,
+            g_hdcMem, rc.left, rc.top, SRCCOPY);
+}
+
+// 渲染线程独占的 GL 上下文，与 g_hRC 共享纹理
+static HGLRC g_renderRC = nullptr;
+
+static void RenderThreadStart() {
+    HDC hdc = GetDC(g_hwnd);
+    g_renderRC = wglCreateContext(hdc);
+    // 须在新上下文创建任何对象之前共享，UI 线程加载的纹理才对它可见
+    if (g_renderRC && g_hRC)
+        wglShareLists(g_hRC, g_renderRC);
+    ReleaseDC(g_hwnd, hdc);
+}
+
+static void RenderThreadFrame(const FrameSnapshot& frame) {
+    if (frame.width <= 0 || frame.height <= 0) return;   // 最小化
+    if (frame.is3D) {
+        DrawScene(nullptr, frame.scene3D);
+        return;
+    }
+
+    DamageRegion region = frame.region;
+    if (!g_surface.bits || g_surface.width != frame.width || g_surface.height != frame.height) {
+        // 新缓冲内容为空，整个客户区都要重画
+        RecreateBackBuffer(frame.width, frame.height);
+        ClearDamage(region);
+        AddDamage(region, RECT{ 0, 0, frame.width, frame.height });
+    }
+    if (!g_surface.bits) return;
+    ClipDamage(region, g_surface.width, g_surface.height);
+    if (region.rects.empty()) return;
+
+    HDC hdc = GetDC(g_hwnd);
+    ComposeRegion(g_hdcMem, region, frame.scene2D);
+    PresentRegion(hdc, region);
+    ReleaseDC(g_hwnd, hdc);
+}
+
+static void RenderThreadStop() {
+    if (g_renderRC) {
+        wglDeleteContext(g_renderRC);
+        g_renderRC = nullptr;
+    }
+    if (g_hbmMem) {
+        DeleteObject(g_hbmMem);
+        g_hbmMem = nullptr;
+    }
+    if (g_hdcMem) {
+        DeleteDC(g_hdcMem);
+        g_hdcMem = nullptr;
+    }
+    g_surface = PixelSurface{};
+    g_sceneCommands = CommandBuffer{};
+    g_sceneCommandsShapes.reset();
+    g_dragLayer = HeapSurface{};
+    g_dragLayerShapes.reset();
+    g_dragLayerSkip.reset();
+    g_selectionShapes = std::vector<Shape>{};
+}
+
+// ===== UI 线程：发布快照 =====
+static void PublishFrame2D(const DamageRegion& region, const Affine2D* preview) {
+    FrameSnapshot& f = BeginFrameSnapshot();
+    f.is3D = false;
+    f.width = g_clientWidth;
+    f.height = g_clientHeight;
+    AddDamage(f.region, region);
+
+    Scene2DSnapshot& scene = f.scene2D;
+    scene.shapes = SceneShapes();
+    scene.tiled = g_tiledRender;
+    scene.showSelection = IsTransformMode(g_currentMode) && !g_selection.empty();
+    scene.selection = scene.showSelection ? SceneSelection() : nullptr;
+    if (!scene.showSelection || !SelectionBounds(preview, scene.selectionBounds))
+        scene.selectionBounds = RECT{};
+    scene.hasPreview = preview != nullptr;
+    if (preview) scene.previewTransform = *preview;
+    scene.useDragLayer = preview && g_dragLayerActive;
+    scene.rubberBand = g_rubberBand;
+    scene.mode = g_currentMode;
+    scene.isDrawing = g_isDrawing;
+    scene.firstClick = g_firstClick;
+    scene.mousePos = g_currentMousePos;
+    scene.currentPoints = g_currentPoints;
+    scene.drawColor = g_drawColor;
+    PublishFrameSnapshot();
+}
+
+static void PublishFrame3D() {
+    FrameSnapshot& f = BeginFrameSnapshot();
+    f.is3D = true;
+    f.width = g_clientWidth;
+    f.height = g_clientHeight;
+
+    Scene3DSnapshot& scene = f.scene3D;
+    scene.objects = g_objects;
+    scene.camera = g_camera;
+    scene.light = g_light;
+    scene.settingLightPos = g_isSettingLightPos;
+    scene.mousePos = g_currentMousePos;
+    PublishFrameSnapshot();
+}
+
+// 取出窗口更新区域中的各个矩形
+static void AddUpdateRegion(DamageRegion& d, HWND hwnd) {
+    HRGN rgn = CreateRectRgn(0, 0, 0, 0);
+    if (GetUpdateRgn(hwnd, rgn, FALSE) > NULLREGION) {
+        DWORD size = GetRegionData(rgn, 0, NULL);
+        std::vector<char> buf(size);
+        RGNDATA* data = reinterpret_cast<RGNDATA*>(buf.data());
+        if (size && GetRegionData(rgn, size, data)) {
+            const RECT* rects = reinterpret_cast<const RECT*>(data->Buffer);
+            for (DWORD i = 0; i < data->rdh.nCount; ++i)
+                AddDamage(d, rects[i]);
+        }
+    }
+    DeleteObject(rgn);
+}
+
 void HandleRButtonDown(int x, int y) {
     if (!is3DMode) return;
 
@@ -576,101 +1275,37 @@ void HandleMouseMove(int x, int y) {
         return;
     }
 
-    if (!g_hwnd || !g_hdcMem) return;
-    
-    g_currentMousePos = { x, y };
-
-    HDC hdc = GetDC(g_hwnd);
-    RECT rc; GetClientRect(g_hwnd, &rc);
-
-    FillRect(g_hdcMem, &rc, (HBRUSH)GetStockObject(WHITE_BRUSH));
-
-    std::vector<Shape> temp;
-    const std::vector<Shape>* shapesToDraw = &g_shapes;
-    int highlightIdx = -1;
-
-    if (g_isDrawing) {
-        switch (g_currentMode) {
-        case DrawMode::TransformTranslate:
-            if (g_selectedShapeIndex >= 0 && g_selectedShapeIndex < (int)g_shapes.size()) {
-                temp = g_shapes;
-                int ddx = x - g_firstClick.x;
-                int ddy = y - g_firstClick.y;
-                TranslateShape(temp[g_selectedShapeIndex], ddx, ddy);
-                shapesToDraw = &temp;
-                highlightIdx = g_selectedShapeIndex;
-            }
-            break;
-        case DrawMode::TransformScale:
-            if (g_selectedShapeIndex >= 0 && g_selectedShapeIndex < (int)g_shapes.size()) {
-                temp = g_shapes;
-                double ddx = x - g_firstClick.x;
-                double ddy = y - g_firstClick.y;
-                double dist = std::sqrt(ddx * ddx + ddy * ddy);
-                double s = dist / g_scaleBaseDist;
-                if (s < 0.01) s = 0.01;
-                ScaleShape(temp[g_selectedShapeIndex], g_firstClick, s, s);
-                shapesToDraw = &temp;
-                highlightIdx = g_selectedShapeIndex;
-            }
-            break;
-        case DrawMode::TransformRotate:
-            if (g_selectedShapeIndex >= 0 && g_selectedShapeIndex < (int)g_shapes.size()) {
-                temp = g_shapes;
-                double ddx = x - g_firstClick.x;
-                double ddy = y - g_firstClick.y;
-                double ang1 = std::atan2(ddy, ddx);
-                double delta = ang1 - g_rotBaseAngle;
-                RotateShape(temp[g_selectedShapeIndex], g_firstClick, delta);
-                shapesToDraw = &temp;
-                highlightIdx = g_selectedShapeIndex;
-            }
-            break;
-        default:
-            break;
-        }
-    }
+    if (!g_hwnd) return;
 
-    RedrawAllShapesOn(g_hdcMem, *shapesToDraw, highlightIdx);
-    
-    // 绘制裁剪预览矩形
-    if (g_isDrawing && (g_currentMode == DrawMode::ClipLineCS ||
-                        g_currentMode == DrawMode::ClipLineMid ||
-                        g_currentMode == DrawMode::ClipPolySH ||
-                        g_currentMode == DrawMode::ClipPolyWA)) {
-        DrawClipPreviewRect(g_hdcMem, g_firstClick, { x, y });
-    }
+    // 只记录最新位置；同一刷新周期内的多次移动合并为一帧
+    g_currentMousePos = { x, y };
+    if (RequestFrame())
+        RenderInteractiveFrame();
+}
 
-    if (g_isDrawing && !g_currentPoints.empty()) {
-        Point p0 = g_currentPoints[0];
-        switch (g_currentMode) {
-        case DrawMode::DrawLineMidpoint:
-            DrawLineMidpoint(g_hdcMem, p0.x, p0.y, x, y, g_drawColor); break;
-        case DrawMode::DrawLineBresenham:
-            DrawLineBresenham(g_hdcMem, p0.x, p0.y, x, y, g_drawColor); break;
-        case DrawMode::DrawPolygon: {
-            if (g_currentPoints.size() > 1)
-                DrawPolyline(g_hdcMem, g_currentPoints, g_drawColor, false);
-            Point last = g_currentPoints.back();
-            DrawLineMidpoint(g_hdcMem, last.x, last.y, x, y, g_drawColor);
-        } break;
-        case DrawMode::DrawBSpline: {
-            for (auto& p : g_currentPoints)
-                Ellipse(g_hdcMem, p.x - 3, p.y - 3, p.x + 3, p.y + 3);
-            std::vector<Point> tempCtrl = g_currentPoints;
-            tempCtrl.push_back({ x, y });
-            if (tempCtrl.size() > 1)
-                DrawPolyline(g_hdcMem, tempCtrl, RGB(200, 200, 200), false);
-            if (tempCtrl.size() >= 4)
-                DrawBSpline(g_hdcMem, tempCtrl, g_drawColor);
-        } break;
-        default:
-            break;
-        }
-    }
+void HandleTimer(UINT_PTR timerId) {
+    if (is3DMode) return;
+    if (OnFrameTimer(timerId))
+        RenderInteractiveFrame();
+}
 
-    BitBlt(hdc, 0, 0, rc.right - rc.left, rc.bottom - rc.top, g_hdcMem, 0, 0, SRCCOPY);
-    ReleaseDC(g_hwnd, hdc);
+// 按最新鼠标位置刷新叠加层：需要更新的只有上一帧与这一帧的叠加层，没有叠加层时什么都不用画
+static void RenderInteractiveFrame() {
+    if (!g_hwnd) return;
+    int x = g_currentMousePos.x, y = g_currentMousePos.y;
+
+    Affine2D preview;
+    const Affine2D* pv = GetDragTransform(x, y, preview) ? &preview : nullptr;
+    DamageRegion overlay;
+    CollectOverlayDamage(overlay, pv);
+    DamageRegion region = g_overlayDamage;
+    AddDamage(region, overlay);
+    ClipDamage(region, g_clientWidth, g_clientHeight);
+    g_overlayDamage = overlay;
+    FrameRendered();
+    if (region.rects.empty()) return;
+
+    PublishFrame2D(region, pv);
 }
 
 void HandleMouseWheel(short delta) {
@@ -687,55 +1322,45 @@ void HandleMouseWheel(short delta) {
         return;
     }
 
-    if (g_currentMode == DrawMode::TransformScale &&
-        g_selectedShapeIndex >= 0 &&
-        g_selectedShapeIndex < (int)g_shapes.size()) {
+    if (g_currentMode == DrawMode::TransformScale && !g_selection.empty()) {
         double step = 0.1;
         double s = 1.0 + step * (delta / 120.0);
         if (s < 0.1) s = 0.1;
-        ScaleShape(g_shapes[g_selectedShapeIndex], g_firstClick, s, s);
-        if (g_hwnd)
-            InvalidateRect(g_hwnd, NULL, FALSE);
+        TransformSelection(AffineScale(g_firstClick, s, s));
     }
 }
 
+// 绘制交给渲染线程：这里只取出更新区域、发布快照并让窗口变为有效
 void OnPaint(HWND hwnd) {
     if (is3DMode) {
-        PAINTSTRUCT ps;
-        HDC hdc = BeginPaint(hwnd, &ps);
-        DrawScene(hdc);
-        EndPaint(hwnd, &ps);
-        return;
-    }
-
-    if (!g_hdcMem) {
         PAINTSTRUCT ps;
         BeginPaint(hwnd, &ps);
         EndPaint(hwnd, &ps);
+        PublishFrame3D();
         return;
     }
 
-    PAINTSTRUCT ps;
-    HDC hdc = BeginPaint(hwnd, &ps);
-    RECT rc; GetClientRect(hwnd, &rc);
-
-    FillRect(g_hdcMem, &rc, (HBRUSH)GetStockObject(WHITE_BRUSH));
-    RedrawAllShapes(g_hdcMem);
-
-    if (g_currentMode == DrawMode::DrawPolygon && g_currentPoints.size() >= 2)
-        DrawPolyline(g_hdcMem, g_currentPoints, g_drawColor, false);
-
-    if (g_currentMode == DrawMode::DrawBSpline && !g_currentPoints.empty()) {
-        for (auto& p : g_currentPoints)
-            Ellipse(g_hdcMem, p.x - 3, p.y - 3, p.x + 3, p.y + 3);
-        if (g_currentPoints.size() > 1)
-            DrawPolyline(g_hdcMem, g_currentPoints, RGB(200, 200, 200), false);
-        if (g_currentPoints.size() >= 4)
-            DrawBSpline(g_hdcMem, g_currentPoints, g_drawColor);
-    }
+    // 更新区域由各处改动时标记的脏矩形累积而成（BeginPaint 会清空它，须先取出）
+    DamageRegion region;
+    AddUpdateRegion(region, hwnd);
 
-    BitBlt(hdc, 0, 0, rc.right - rc.left, rc.bottom - rc.top, g_hdcMem, 0, 0, SRCCOPY);
+    PAINTSTRUCT ps;
+    BeginPaint(hwnd, &ps);
+    if (region.rects.empty())
+        AddDamage(region, ps.rcPaint);
     EndPaint(hwnd, &ps);
+
+    Affine2D preview;
+    const Affine2D* pv = GetDragTransform(g_currentMousePos.x, g_currentMousePos.y, preview) ? &preview : nullptr;
+    DamageRegion overlay;
+    CollectOverlayDamage(overlay, pv);
+    AddDamage(region, g_overlayDamage);
+    AddDamage(region, overlay);
+    ClipDamage(region, g_clientWidth, g_clientHeight);
+    g_overlayDamage = overlay;
+
+    PublishFrame2D(region, pv);
+    FrameRendered();
 }
 
 //-------------三维实验相关代码----------------
@@ -783,15 +1408,30 @@ GLuint LoadTexture(const wchar_t* filename) {
     return texID;
 }
 
-// 绘制三维场景
-void DrawScene(HDC hdc) {
-    if (!g_hRC) return;
+// 按相机与客户区尺寸设置视口、投影与观察矩阵（绘制与屏幕坐标反投影共用）
+static void LoadCameraMatrices(const Camera& cam, int width, int height) {
+    if (height <= 0) height = 1;
+    glViewport(0, 0, width, height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluPerspective(45.0, (double)width / height, 0.1, 100.0);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    gluLookAt(cam.position.x, cam.position.y, cam.position.z,
+              cam.target.x, cam.target.y, cam.target.z,
+              cam.up.x, cam.up.y, cam.up.z);
+}
+
+// 绘制三维场景（渲染线程，使用自己的 GL 上下文）
+void DrawScene(HDC hdc, const Scene3DSnapshot& scene) {
+    if (!g_renderRC) return;
     bool releaseDC = false;
     if (!hdc) {
         hdc = GetDC(g_hwnd);
         releaseDC = true;
     }
-    wglMakeCurrent(hdc, g_hRC);
+    wglMakeCurrent(hdc, g_renderRC);
 
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -800,21 +1440,13 @@ void DrawScene(HDC hdc) {
     glEnable(GL_LIGHT0);
     glEnable(GL_NORMALIZE);
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
     RECT rc; GetClientRect(g_hwnd, &rc);
-    gluPerspective(45.0, (double)(rc.right - rc.left) / (rc.bottom - rc.top), 0.1, 100.0);
-
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    gluLookAt(g_camera.position.x, g_camera.position.y, g_camera.position.z,
-              g_camera.target.x, g_camera.target.y, g_camera.target.z,
-              g_camera.up.x, g_camera.up.y, g_camera.up.z);
+    LoadCameraMatrices(scene.camera, rc.right - rc.left, rc.bottom - rc.top);
 
-    glLightfv(GL_LIGHT0, GL_POSITION, (float*)&g_light.position);
-    glLightfv(GL_LIGHT0, GL_AMBIENT, g_light.ambient);
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, g_light.diffuse);
-    glLightfv(GL_LIGHT0, GL_SPECULAR, g_light.specular);
+    glLightfv(GL_LIGHT0, GL_POSITION, (float*)&scene.light.position);
+    glLightfv(GL_LIGHT0, GL_AMBIENT, scene.light.ambient);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, scene.light.diffuse);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, scene.light.specular);
 
     // 设置全局环境光，确保纹理在无光照区域也有一定亮度
     float globalAmbient[] = { 0.5f, 0.5f, 0.5f, 1.0f };
@@ -844,7 +1476,7 @@ void DrawScene(HDC hdc) {
     glEnd();
 
     // 如果处于光源设置模式，绘制预览点
-    if (g_isSettingLightPos) {
+    if (scene.settingLightPos) {
         // 计算鼠标对应的 3D 位置
         GLdouble modelview[16], projection[16];
         GLint viewport[4];
@@ -856,10 +1488,10 @@ void DrawScene(HDC hdc) {
         GLdouble farX, farY, farZ;
         
         // 使用当前鼠标位置
-        gluUnProject(g_currentMousePos.x, viewport[3] - g_currentMousePos.y, 0.0, modelview, projection, viewport, &nearX, &nearY, &nearZ);
-        gluUnProject(g_currentMousePos.x, viewport[3] - g_currentMousePos.y, 1.0, modelview, projection, viewport, &farX, &farY, &farZ);
+        gluUnProject(scene.mousePos.x, viewport[3] - scene.mousePos.y, 0.0, modelview, projection, viewport, &nearX, &nearY, &nearZ);
+        gluUnProject(scene.mousePos.x, viewport[3] - scene.mousePos.y, 1.0, modelview, projection, viewport, &farX, &farY, &farZ);
 
-        double planeY = g_light.position.y;
+        double planeY = scene.light.position.y;
         double dirY = farY - nearY;
         if (abs(dirY) > 1e-6) {
             double t = (planeY - nearY) / dirY;
@@ -914,7 +1546,7 @@ void DrawScene(HDC hdc) {
     glDisable(GL_BLEND);
     glEnable(GL_LIGHTING);
     // 绘制三维对象
-    for (auto& obj : g_objects) {
+    for (const auto& obj : scene.objects) {
         glPushMatrix(); // 保存当前矩阵状态
         glTranslatef(obj.position.x, obj.position.y, obj.position.z); // 平移到对象位置
         glRotatef(obj.rotation.x, 1, 0, 0); // 旋转
@@ -1232,6 +1864,8 @@ INT_PTR CALLBACK MaterialDlgProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM
                     HDC hdc = GetDC(g_hwnd);
                     wglMakeCurrent(hdc, g_hRC);
                     selectedObject->textureID = LoadTexture(selectedObject->texturePath);
+                    // 纹理与渲染线程的上下文共享，上传完成后才能在那边使用
+                    glFinish();
                     wglMakeCurrent(NULL, NULL);
                     ReleaseDC(g_hwnd, hdc);
                 }
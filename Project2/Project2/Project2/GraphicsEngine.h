@@ -4,9 +4,12 @@
 #include <vector>
 #include <gl/GL.h>
 #include <gl/GLU.h>
+#include "ShapeTypes.h"
 
 namespace GraphicsEngine {
 
+struct Scene3DSnapshot;
+
 constexpr int WINDOW_WIDTH = 800;
 constexpr int WINDOW_HEIGHT = 600;
 
@@ -28,6 +31,16 @@ constexpr UINT ID_CLIP_LINE_CS = 1015;
 constexpr UINT ID_CLIP_LINE_MID = 1016;
 constexpr UINT ID_CLIP_POLY_SH = 1017;
 constexpr UINT ID_CLIP_POLY_WA = 1018;
+constexpr UINT ID_DRAW_LINE_RUNSLICE = 1019;
+constexpr UINT ID_VIEW_TILED_RENDER = 1020;
+constexpr UINT ID_VIEW_FRAME_STATS = 1021;
+constexpr UINT ID_VIEW_PIXEL_PICKING = 1022;
+constexpr UINT ID_CLIP_LINE_LB = 1023;
+constexpr UINT ID_CLIP_POLY_WINDOW = 1024;
+constexpr UINT ID_BOOL_UNION = 1025;
+constexpr UINT ID_BOOL_INTERSECT = 1026;
+constexpr UINT ID_BOOL_DIFFERENCE = 1027;
+constexpr UINT ID_BOOL_XOR = 1028;
 
 // 3D Commands (matching Resource.h)
 constexpr UINT ID_MODE_SWITCH = 2000;
@@ -39,39 +52,6 @@ constexpr UINT ID_3D_LIGHT_SETTINGS = 2005;
 constexpr UINT ID_3D_DELETE_OBJECT = 2008;
 constexpr UINT ID_3D_LIGHT_POS_VISUAL = 2009;
 
-enum class DrawMode {
-    None,
-    DrawLineMidpoint,
-    DrawLineBresenham,
-    DrawCircleMidpoint,
-    DrawCircleBresenham,
-    DrawRectangle,
-    DrawPolygon,
-    DrawBSpline,
-    FillScanline,
-    FillFence,
-    TransformTranslate,
-    TransformScale,
-    TransformRotate,
-    ClipLineCS,
-    ClipLineMid,
-    ClipPolySH,
-    ClipPolyWA
-};
-
-struct Point {
-    int x;
-    int y;
-};
-
-struct Shape {
-    DrawMode type;
-    std::vector<Point> vertices;
-    COLORREF color;
-    COLORREF fillColor;
-    int fillMode;
-};
-
 // 3D Structures
 struct Vector3 {
     float x, y, z;
@@ -123,6 +103,10 @@ struct Light {
 extern bool is3DMode;
 extern Object3D* selectedObject;
 extern Light sceneLight;
+// 2D 场景是否使用分块并行绘制
+extern bool g_tiledRender;
+// 2D 选取是否使用像素精确的拾取缓冲
+extern bool g_pixelPicking;
 
 void Initialize(HWND hwnd);
 void Shutdown();
@@ -132,11 +116,12 @@ void HandleLButtonDown(int x, int y);
 void HandleRButtonDown(int x, int y);
 void HandleMouseMove(int x, int y);
 void HandleMouseWheel(short delta);
+void HandleTimer(UINT_PTR timerId);
 void OnPaint(HWND hwnd);
 
 // 3D Specific Functions
 void InitGL(HWND hwnd);
-void DrawScene(HDC hdc = nullptr);
+void DrawScene(HDC hdc, const Scene3DSnapshot& scene);
 void AddObject3D(ModelType type);
 void SelectObject3D(int x, int y);
 void UpdateObjectTransform(Object3D* obj, Vector3 pos, Vector3 rot, Vector3 scale);
@@ -3,21 +3,26 @@
 #include <windows.h>
 #include <vector>
 #include "GraphicsEngine.h"
+#include "PixelSurface.h"
+#include "ShapeList.h"
 
 namespace GraphicsEngine {
 
 extern HWND g_hwnd;
 extern HDC g_hdcMem;
 extern HBITMAP g_hbmMem;
+// 后台缓冲的像素内存（g_hbmMem 为 DIB 段，光栅算法直接写入），只在渲染线程上访问
+extern PixelSurface g_surface;
 
 extern DrawMode g_currentMode;
-extern std::vector<Shape> g_shapes;
 extern std::vector<Point> g_currentPoints;
 extern bool g_isDrawing;
 
 extern COLORREF g_drawColor;
 extern COLORREF g_fillColor;
 
+// 选中的图形下标（升序）；g_selectedShapeIndex 为最近点中的那个，缩放、旋转以它的首顶点为基准
+extern std::vector<int> g_selection;
 extern int g_selectedShapeIndex;
 extern Point g_firstClick;
 extern double g_scaleBaseDist;
@@ -26,6 +31,6 @@ extern double g_rotBaseAngle;
 // 鼠标当前位置（用于预览）
 extern Point g_currentMousePos;
 
-void RecreateBackBuffer(HWND hwnd);
+void RecreateBackBuffer(int width, int height);
 
 } // namespace GraphicsEngine
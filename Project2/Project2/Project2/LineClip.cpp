@@ -0,0 +1,149 @@
+#include "LineClip.h"
+#include "SpanFill.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define LINE_CLIP_X86 1
+#include <immintrin.h>
+#endif
+
+// MSVC 允许在未开 /arch:AVX2 时直接使用 AVX2 内建函数；GCC/Clang 需按函数开启
+#if defined(LINE_CLIP_X86) && !defined(_MSC_VER)
+#define LINE_CLIP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LINE_CLIP_TARGET_AVX2
+#endif
+
+namespace GraphicsEngine {
+
+// 对一条裁剪边：p 为端点沿边法向的变化量，q 为起点到边的距离
+// p < 0 从外侧进入，收紧 t0；p > 0 向外侧离开，收紧 t1；p == 0 与边平行，q < 0 时整条在外
+bool LiangBarskyClip(double& x1, double& y1, double& x2, double& y2,
+    double xmin, double xmax, double ymin, double ymax) {
+    double dx = x2 - x1;
+    double dy = y2 - y1;
+    double p[4] = { -dx, dx, -dy, dy };
+    double q[4] = { x1 - xmin, xmax - x1, y1 - ymin, ymax - y1 };
+    double t0 = 0, t1 = 1;
+    for (int k = 0; k < 4; ++k) {
+        if (p[k] == 0) {
+            if (q[k] < 0) return false;
+            continue;
+        }
+        double r = q[k] / p[k];
+        if (p[k] < 0) {
+            if (r > t0) t0 = r;
+        }
+        else {
+            if (r < t1) t1 = r;
+        }
+    }
+    if (t0 > t1) return false;
+    // 先算终点：它要用到原起点
+    x2 = x1 + t1 * dx;
+    y2 = y1 + t1 * dy;
+    x1 = x1 + t0 * dx;
+    y1 = y1 + t0 * dy;
+    return true;
+}
+
+static void ClipLinesScalar(double* x1, double* y1, double* x2, double* y2, unsigned char* visible,
+    size_t n, double xmin, double xmax, double ymin, double ymax) {
+    for (size_t i = 0; i < n; ++i)
+        visible[i] = LiangBarskyClip(x1[i], y1[i], x2[i], y2[i], xmin, xmax, ymin, ymax) ? 1 : 0;
+}
+
+#ifdef LINE_CLIP_X86
+// ----- SSE2：每次 2 条线段 -----
+// 与 LiangBarskyClip 相同：r = q / p，按 p 的符号收紧 t0 / t1（p == 0 的通道不参与比较）
+static inline void ClipEdgeSSE2(__m128d p, __m128d q, __m128d& t0, __m128d& t1, __m128d& reject) {
+    __m128d zero = _mm_setzero_pd();
+    __m128d r = _mm_div_pd(q, p);
+    __m128d enter = _mm_and_pd(_mm_cmplt_pd(p, zero), _mm_cmpgt_pd(r, t0));
+    __m128d leave = _mm_and_pd(_mm_cmpgt_pd(p, zero), _mm_cmplt_pd(r, t1));
+    t0 = _mm_or_pd(_mm_and_pd(enter, r), _mm_andnot_pd(enter, t0));
+    t1 = _mm_or_pd(_mm_and_pd(leave, r), _mm_andnot_pd(leave, t1));
+    reject = _mm_or_pd(reject, _mm_and_pd(_mm_cmpeq_pd(p, zero), _mm_cmplt_pd(q, zero)));
+}
+
+static void ClipLinesSSE2(double* x1, double* y1, double* x2, double* y2, unsigned char* visible,
+    size_t n, double xmin, double xmax, double ymin, double ymax) {
+    const __m128d vxmin = _mm_set1_pd(xmin), vxmax = _mm_set1_pd(xmax);
+    const __m128d vymin = _mm_set1_pd(ymin), vymax = _mm_set1_pd(ymax);
+    const __m128d zero = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d ax = _mm_loadu_pd(x1 + i), ay = _mm_loadu_pd(y1 + i);
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(x2 + i), ax);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(y2 + i), ay);
+        __m128d t0 = zero, t1 = _mm_set1_pd(1.0), reject = zero;
+        ClipEdgeSSE2(_mm_sub_pd(zero, dx), _mm_sub_pd(ax, vxmin), t0, t1, reject);
+        ClipEdgeSSE2(dx, _mm_sub_pd(vxmax, ax), t0, t1, reject);
+        ClipEdgeSSE2(_mm_sub_pd(zero, dy), _mm_sub_pd(ay, vymin), t0, t1, reject);
+        ClipEdgeSSE2(dy, _mm_sub_pd(vymax, ay), t0, t1, reject);
+        reject = _mm_or_pd(reject, _mm_cmpgt_pd(t0, t1));
+        _mm_storeu_pd(x2 + i, _mm_add_pd(ax, _mm_mul_pd(t1, dx)));
+        _mm_storeu_pd(y2 + i, _mm_add_pd(ay, _mm_mul_pd(t1, dy)));
+        _mm_storeu_pd(x1 + i, _mm_add_pd(ax, _mm_mul_pd(t0, dx)));
+        _mm_storeu_pd(y1 + i, _mm_add_pd(ay, _mm_mul_pd(t0, dy)));
+        int mask = _mm_movemask_pd(reject);
+        visible[i] = (mask & 1) ? 0 : 1;
+        visible[i + 1] = (mask & 2) ? 0 : 1;
+    }
+    ClipLinesScalar(x1 + i, y1 + i, x2 + i, y2 + i, visible + i, n - i, xmin, xmax, ymin, ymax);
+}
+
+// ----- AVX2：每次 4 条线段 -----
+LINE_CLIP_TARGET_AVX2
+static inline void ClipEdgeAVX2(__m256d p, __m256d q, __m256d& t0, __m256d& t1, __m256d& reject) {
+    __m256d zero = _mm256_setzero_pd();
+    __m256d r = _mm256_div_pd(q, p);
+    __m256d enter = _mm256_and_pd(_mm256_cmp_pd(p, zero, _CMP_LT_OQ), _mm256_cmp_pd(r, t0, _CMP_GT_OQ));
+    __m256d leave = _mm256_and_pd(_mm256_cmp_pd(p, zero, _CMP_GT_OQ), _mm256_cmp_pd(r, t1, _CMP_LT_OQ));
+    t0 = _mm256_blendv_pd(t0, r, enter);
+    t1 = _mm256_blendv_pd(t1, r, leave);
+    reject = _mm256_or_pd(reject,
+        _mm256_and_pd(_mm256_cmp_pd(p, zero, _CMP_EQ_OQ), _mm256_cmp_pd(q, zero, _CMP_LT_OQ)));
+}
+
+LINE_CLIP_TARGET_AVX2
+static void ClipLinesAVX2(double* x1, double* y1, double* x2, double* y2, unsigned char* visible,
+    size_t n, double xmin, double xmax, double ymin, double ymax) {
+    const __m256d vxmin = _mm256_set1_pd(xmin), vxmax = _mm256_set1_pd(xmax);
+    const __m256d vymin = _mm256_set1_pd(ymin), vymax = _mm256_set1_pd(ymax);
+    const __m256d zero = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d ax = _mm256_loadu_pd(x1 + i), ay = _mm256_loadu_pd(y1 + i);
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x2 + i), ax);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y2 + i), ay);
+        __m256d t0 = zero, t1 = _mm256_set1_pd(1.0), reject = zero;
+        ClipEdgeAVX2(_mm256_sub_pd(zero, dx), _mm256_sub_pd(ax, vxmin), t0, t1, reject);
+        ClipEdgeAVX2(dx, _mm256_sub_pd(vxmax, ax), t0, t1, reject);
+        ClipEdgeAVX2(_mm256_sub_pd(zero, dy), _mm256_sub_pd(ay, vymin), t0, t1, reject);
+        ClipEdgeAVX2(dy, _mm256_sub_pd(vymax, ay), t0, t1, reject);
+        reject = _mm256_or_pd(reject, _mm256_cmp_pd(t0, t1, _CMP_GT_OQ));
+        _mm256_storeu_pd(x2 + i, _mm256_add_pd(ax, _mm256_mul_pd(t1, dx)));
+        _mm256_storeu_pd(y2 + i, _mm256_add_pd(ay, _mm256_mul_pd(t1, dy)));
+        _mm256_storeu_pd(x1 + i, _mm256_add_pd(ax, _mm256_mul_pd(t0, dx)));
+        _mm256_storeu_pd(y1 + i, _mm256_add_pd(ay, _mm256_mul_pd(t0, dy)));
+        int mask = _mm256_movemask_pd(reject);
+        for (int k = 0; k < 4; ++k)
+            visible[i + k] = (mask >> k) & 1 ? 0 : 1;
+    }
+    ClipLinesSSE2(x1 + i, y1 + i, x2 + i, y2 + i, visible + i, n - i, xmin, xmax, ymin, ymax);
+}
+#endif
+
+static LineClipKernels SelectLineClipKernels() {
+#ifdef LINE_CLIP_X86
+    if (CpuHasAVX2())
+        return { ClipLinesAVX2, "AVX2" };
+    return { ClipLinesSSE2, "SSE2" };
+#else
+    return { ClipLinesScalar, "Scalar" };
+#endif
+}
+
+const LineClipKernels g_lineClipKernels = SelectLineClipKernels();
+
+} // namespace GraphicsEngine
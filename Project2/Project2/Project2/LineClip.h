@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+namespace GraphicsEngine {
+
+// Liang-Barsky 参数化线段裁剪，裁剪框 [xmin, xmax] x [ymin, ymax] 为闭区间
+// 可见时把端点改为裁剪后的位置并返回 true
+bool LiangBarskyClip(double& x1, double& y1, double& x2, double& y2,
+    double xmin, double xmax, double ymin, double ymax);
+
+// 批量裁剪内核：线段按结构数组排列，第 i 条为 (x1[i], y1[i]) - (x2[i], y2[i])，就地裁剪，
+// visible[i] 置 1 / 0；程序启动时按 CPU 能力在 AVX2（每次 4 条）/ SSE2（每次 2 条）/ 标量实现中选择一次
+// 各实现无分支、运算顺序相同，结果与 LiangBarskyClip 逐位一致
+typedef void (*LineClipKernelFn)(double* x1, double* y1, double* x2, double* y2, unsigned char* visible,
+    size_t n, double xmin, double xmax, double ymin, double ymax);
+
+struct LineClipKernels {
+    LineClipKernelFn clip;
+    const char* name;
+};
+
+extern const LineClipKernels g_lineClipKernels;
+
+} // namespace GraphicsEngine
@@ -58,7 +58,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     case WM_COMMAND: {
         int id = LOWORD(wParam);
         GraphicsEngine::HandleCommand(id);
-        if (id == ID_MODE_SWITCH) {
+        if (id == ID_MODE_SWITCH || id == GraphicsEngine::ID_VIEW_TILED_RENDER ||
+            id == GraphicsEngine::ID_VIEW_PIXEL_PICKING) {
             UpdateMenu(hwnd);
         }
     } return 0;
@@ -85,6 +86,10 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         GraphicsEngine::HandleMouseMove(GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
         return 0;
 
+    case WM_TIMER:
+        GraphicsEngine::HandleTimer(static_cast<UINT_PTR>(wParam));
+        return 0;
+
     case WM_MOUSEWHEEL:
         GraphicsEngine::HandleMouseWheel(static_cast<short>(GET_WHEEL_DELTA_WPARAM(wParam)));
         return 0;
@@ -145,6 +150,7 @@ static void UpdateMenu(HWND hwnd) {
 
         AppendMenuW(hDrawMenu, MF_STRING, GraphicsEngine::ID_DRAW_LINE_MIDPOINT, L"直线 (中点法)");
         AppendMenuW(hDrawMenu, MF_STRING, GraphicsEngine::ID_DRAW_LINE_BRESENHAM, L"直线 (Bresenham)");
+        AppendMenuW(hDrawMenu, MF_STRING, GraphicsEngine::ID_DRAW_LINE_RUNSLICE, L"直线 (Run-Slice)");
         AppendMenuW(hDrawMenu, MF_STRING, GraphicsEngine::ID_DRAW_CIRCLE_MIDPOINT, L"圆 (中点法)");
         AppendMenuW(hDrawMenu, MF_STRING, GraphicsEngine::ID_DRAW_CIRCLE_BRESENHAM, L"圆 (Bresenham)");
         AppendMenuW(hDrawMenu, MF_STRING, GraphicsEngine::ID_DRAW_RECTANGLE, L"矩形");
@@ -163,14 +169,26 @@ static void UpdateMenu(HWND hwnd) {
 
         AppendMenuW(hClipLineMenu, MF_STRING, GraphicsEngine::ID_CLIP_LINE_CS, L"Cohen-Sutherland");
         AppendMenuW(hClipLineMenu, MF_STRING, GraphicsEngine::ID_CLIP_LINE_MID, L"中点分割");
+        AppendMenuW(hClipLineMenu, MF_STRING, GraphicsEngine::ID_CLIP_LINE_LB, L"Liang-Barsky");
         AppendMenuW(hMenu, MF_POPUP, reinterpret_cast<UINT_PTR>(hClipLineMenu), L"线段裁剪");
 
         AppendMenuW(hClipPolyMenu, MF_STRING, GraphicsEngine::ID_CLIP_POLY_SH, L"Sutherland-Hodgman");
         AppendMenuW(hClipPolyMenu, MF_STRING, GraphicsEngine::ID_CLIP_POLY_WA, L"Weiler-Atherton");
+        AppendMenuW(hClipPolyMenu, MF_STRING, GraphicsEngine::ID_CLIP_POLY_WINDOW, L"任意多边形窗口");
+        AppendMenuW(hClipPolyMenu, MF_SEPARATOR, 0, NULL);
+        AppendMenuW(hClipPolyMenu, MF_STRING, GraphicsEngine::ID_BOOL_UNION, L"选中图形求并");
+        AppendMenuW(hClipPolyMenu, MF_STRING, GraphicsEngine::ID_BOOL_INTERSECT, L"选中图形求交");
+        AppendMenuW(hClipPolyMenu, MF_STRING, GraphicsEngine::ID_BOOL_DIFFERENCE, L"选中图形求差");
+        AppendMenuW(hClipPolyMenu, MF_STRING, GraphicsEngine::ID_BOOL_XOR, L"选中图形异或");
         AppendMenuW(hMenu, MF_POPUP, reinterpret_cast<UINT_PTR>(hClipPolyMenu), L"多边形裁剪");
 
         AppendMenuW(hEditMenu, MF_STRING, GraphicsEngine::ID_EDIT_FINISH, L"完成当前图形");
         AppendMenuW(hEditMenu, MF_STRING, GraphicsEngine::ID_EDIT_CLEAR, L"清空画布");
+        AppendMenuW(hEditMenu, MF_STRING | (GraphicsEngine::g_tiledRender ? MF_CHECKED : MF_UNCHECKED),
+            GraphicsEngine::ID_VIEW_TILED_RENDER, L"分块并行绘制");
+        AppendMenuW(hEditMenu, MF_STRING | (GraphicsEngine::g_pixelPicking ? MF_CHECKED : MF_UNCHECKED),
+            GraphicsEngine::ID_VIEW_PIXEL_PICKING, L"像素精确拾取");
+        AppendMenuW(hEditMenu, MF_STRING, GraphicsEngine::ID_VIEW_FRAME_STATS, L"帧统计");
         AppendMenuW(hMenu, MF_POPUP, reinterpret_cast<UINT_PTR>(hEditMenu), L"编辑");
 
         HMENU h3DMenu = CreateMenu();
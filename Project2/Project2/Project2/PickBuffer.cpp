@@ -0,0 +1,174 @@
+#include "PickBuffer.h"
+#include "Fill.h"
+#include <algorithm>
+#include <cmath>
+
+namespace GraphicsEngine {
+
+// 加粗的线段：两端为半径 t 的圆，中间为宽 2t 的四边形
+static void PickSegment(PixelSurface& surf, const Point& p, const Point& q, int t, COLORREF c) {
+    FillCircleRadius(surf, p.x, p.y, t, c);
+    FillCircleRadius(surf, q.x, q.y, t, c);
+    double dx = q.x - p.x, dy = q.y - p.y;
+    double len = std::sqrt(dx * dx + dy * dy);
+    if (len < 1.0) return;
+    int nx = (int)std::lround(-dy / len * t);
+    int ny = (int)std::lround(dx / len * t);
+    std::vector<Point> quad = {
+        { p.x + nx, p.y + ny }, { q.x + nx, q.y + ny },
+        { q.x - nx, q.y - ny }, { p.x - nx, p.y - ny }
+    };
+    FillPolygonScanline(surf, quad, c, false);
+}
+
+// 加粗的圆周：半径 [r - t, r + t] 的圆环
+static void PickCircleRing(PixelSurface& surf, int xc, int yc, int r, int t, COLORREF c) {
+    int outer = r + t, inner = r - t;
+    uint32_t px = ColorToPixel(c);
+    int yBegin = (std::max)(yc - outer, surf.clipTop);
+    int yEnd = (std::min)(yc + outer, surf.clipBottom - 1);
+    for (int y = yBegin; y <= yEnd; ++y) {
+        int dy = y - yc;
+        int ox = int(std::sqrt(double(outer * outer - dy * dy)));
+        int it = inner * inner - dy * dy;
+        if (inner <= 0 || it <= 0) {
+            FillSpan(surf, y, xc - ox, xc + ox, px);
+            continue;
+        }
+        int ix = int(std::ceil(std::sqrt(double(it))));
+        if (ix > ox) continue;
+        FillSpan(surf, y, xc - ox, xc - ix, px);
+        FillSpan(surf, y, xc + ix, xc + ox, px);
+    }
+}
+
+// 加粗的圆弧：圆环中方向落在弧内的像素
+static void PickArcRing(PixelSurface& surf, int xc, int yc, int r, const Point* ends, size_t n, int t, COLORREF c) {
+    int outer = r + t, inner = (std::max)(r - t, 0);
+    uint32_t px = ColorToPixel(c);
+    int yBegin = (std::max)(yc - outer, surf.clipTop);
+    int yEnd = (std::min)(yc + outer, surf.clipBottom - 1);
+    for (int y = yBegin; y <= yEnd; ++y) {
+        int dy = y - yc;
+        int xBegin = (std::max)(xc - outer, surf.clipLeft);
+        int xEnd = (std::min)(xc + outer, surf.clipRight - 1);
+        for (int x = xBegin; x <= xEnd; ++x) {
+            int dx = x - xc;
+            int d2 = dx * dx + dy * dy;
+            if (d2 > outer * outer || d2 < inner * inner) continue;
+            if (ArcCoversDirection(xc, yc, ends, n, dx, dy))
+                PutPixel(surf, x, y, px);
+        }
+    }
+}
+
+static void PickPolyline(PixelSurface& surf, const Point* v, size_t n, bool closed, int t, COLORREF c) {
+    for (size_t i = 0; i + 1 < n; ++i)
+        PickSegment(surf, v[i], v[i + 1], t, c);
+    if (closed && n > 2)
+        PickSegment(surf, v[n - 1], v[0], t, c);
+}
+
+// 以 id 为颜色画出图形的拾取范围
+static void RenderPickShape(PixelSurface& surf, const Shape& s, COLORREF id) {
+    const auto& v = s.vertices;
+    if (v.size() < 2) return;
+    const int t = PICK_STROKE_TOLERANCE;
+    // 栅栏填充的覆盖范围与扫描线填充相同，这里都按不透明写入
+    if (s.fillMode == 1 || s.fillMode == 2)
+        FillShapeScanline(surf, s, id);
+
+    switch (s.type) {
+    case DrawMode::DrawLineMidpoint:
+    case DrawMode::DrawLineBresenham:
+    case DrawMode::DrawLineRunSlice: {
+        Point a, b;
+        LineVisibleEnds(s, a, b);
+        PickSegment(surf, a, b, t, id);
+    } break;
+    case DrawMode::DrawCircleMidpoint:
+    case DrawMode::DrawCircleBresenham: {
+        int r = int(std::sqrt(double((v[1].x - v[0].x) * (v[1].x - v[0].x) +
+            (v[1].y - v[0].y) * (v[1].y - v[0].y))));
+        PickCircleRing(surf, v[0].x, v[0].y, r, t, id);
+    } break;
+    case DrawMode::DrawRectangle: {
+        int x1 = (std::min)(v[0].x, v[1].x), x2 = (std::max)(v[0].x, v[1].x);
+        int y1 = (std::min)(v[0].y, v[1].y), y2 = (std::max)(v[0].y, v[1].y);
+        Point corners[4] = { { x1, y1 }, { x2, y1 }, { x2, y2 }, { x1, y2 } };
+        PickPolyline(surf, corners, 4, true, t, id);
+    } break;
+    case DrawMode::DrawPolygon:
+        PickPolyline(surf, v.data(), v.size(), true, t, id);
+        break;
+    case DrawMode::DrawArc:
+        PickArcRing(surf, v[0].x, v[0].y, CircleRadius(v), v.data() + 2, v.size() - 2, t, id);
+        break;
+    case DrawMode::DrawBSpline: {
+        Point pts[BSPLINE_SEGMENT_MAX_POINTS];
+        ForEachBSplinePiece(s, [&](const Point* ctrl, size_t count) {
+            for (size_t i = 0; i + 3 < count; ++i) {
+                int n = BSplineSegmentPoints(&ctrl[i], pts);
+                PickPolyline(surf, pts, (size_t)n, false, t, id);
+            }
+        });
+    } break;
+    case DrawMode::DrawCompound: {
+        size_t start = 0;
+        for (int n : ShapeContourSizes(s)) {
+            if (n <= 0 || start + n > v.size()) break;
+            PickPolyline(surf, v.data() + start, (size_t)n, true, t, id);
+            start += n;
+        }
+    } break;
+    default:
+        break;
+    }
+}
+
+void ResizePickBuffer(PickBuffer& pb, int width, int height) {
+    if (pb.ids.surface.width == width && pb.ids.surface.height == height && !pb.ids.pixels.empty())
+        return;
+    CreateHeapSurface(pb.ids, width, height);
+    InvalidatePickBuffer(pb);
+}
+
+void InvalidatePickBuffer(PickBuffer& pb, const DamageRegion& d) {
+    AddDamage(pb.dirty, d);
+}
+
+void InvalidatePickBuffer(PickBuffer& pb) {
+    ClearDamage(pb.dirty);
+    AddDamage(pb.dirty, RECT{ 0, 0, pb.ids.surface.width, pb.ids.surface.height });
+}
+
+void UpdatePickBuffer(PickBuffer& pb, const std::vector<Shape>& shapes, const ShapeIndex& index) {
+    PixelSurface& surf = pb.ids.surface;
+    ClipDamage(pb.dirty, surf.width, surf.height);
+    std::vector<int> candidates;
+    for (const RECT& rc : pb.dirty.rects) {
+        SetSurfaceClip(surf, rc);
+        ClearSurface(surf, RGB(0, 0, 0));
+        // 加粗的描边会伸出包围盒
+        RECT query = { rc.left - PICK_STROKE_TOLERANCE, rc.top - PICK_STROKE_TOLERANCE,
+            rc.right + PICK_STROKE_TOLERANCE, rc.bottom + PICK_STROKE_TOLERANCE };
+        QueryShapeIndex(index, query, candidates);
+        for (int i : candidates) {
+            if (i < (int)shapes.size())
+                RenderPickShape(surf, shapes[i], PixelToColor((uint32_t)i + 1));
+        }
+    }
+    ResetSurfaceClip(surf);
+    ClearDamage(pb.dirty);
+}
+
+int PickShapeAt(PickBuffer& pb, const std::vector<Shape>& shapes, const ShapeIndex& index, int x, int y) {
+    const PixelSurface& surf = pb.ids.surface;
+    if (x < 0 || y < 0 || x >= surf.width || y >= surf.height) return -1;
+    if (!pb.dirty.rects.empty())
+        UpdatePickBuffer(pb, shapes, index);
+    int id = (int)GetSurfacePixel(surf, x, y) - 1;
+    return id < (int)shapes.size() ? id : -1;
+}
+
+} // namespace GraphicsEngine
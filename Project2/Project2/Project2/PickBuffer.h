@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include "DamageRegion.h"
+#include "ShapeIndex.h"
+
+namespace GraphicsEngine {
+
+// 描边的拾取容差（像素），与 PointInShape 对直线的容差一致
+constexpr int PICK_STROKE_TOLERANCE = 3;
+
+// 拾取缓冲（ID 缓冲）：与客户区同尺寸，每个像素存放画在它上面的最上层图形下标 + 1，0 为空白
+// 图形按列表顺序画入：填充只算实际填充了的图形，描边按容差加粗
+// 图形改动时只标记脏区域，拾取前才重画脏区域
+struct PickBuffer {
+    HeapSurface ids;
+    DamageRegion dirty;
+};
+
+// 尺寸变化时重新分配并整体标脏
+void ResizePickBuffer(PickBuffer& pb, int width, int height);
+void InvalidatePickBuffer(PickBuffer& pb, const DamageRegion& d);
+void InvalidatePickBuffer(PickBuffer& pb);
+// 重画脏区域，使缓冲与图形表一致
+void UpdatePickBuffer(PickBuffer& pb, const std::vector<Shape>& shapes, const ShapeIndex& index);
+// 点 (x, y) 处可见的最上层图形下标，没有则返回 -1
+int PickShapeAt(PickBuffer& pb, const std::vector<Shape>& shapes, const ShapeIndex& index, int x, int y);
+
+} // namespace GraphicsEngine
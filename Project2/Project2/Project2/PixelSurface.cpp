@@ -0,0 +1,116 @@
+#include "PixelSurface.h"
+#include "SpanFill.h"
+#include <algorithm>
+#include <cstring>
+
+namespace GraphicsEngine {
+
+void CreateHeapSurface(HeapSurface& hs, int width, int height) {
+    width = (std::max)(width, 1);
+    height = (std::max)(height, 1);
+    hs.pixels.assign((size_t)width * (size_t)height, 0x00FFFFFFu);
+    hs.surface.bits = hs.pixels.data();
+    hs.surface.width = width;
+    hs.surface.height = height;
+    hs.surface.stride = width;
+    ResetSurfaceClip(hs.surface);
+}
+
+#ifdef _WIN32
+HBITMAP CreateDIBSurface(HDC hdc, int width, int height, PixelSurface& out) {
+    width = (std::max)(width, 1);
+    height = (std::max)(height, 1);
+
+    BITMAPINFO bmi{};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;   // 负高度：自顶向下，行 0 在内存开头
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    HBITMAP hbm = CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (!hbm || !bits) {
+        out = PixelSurface{};
+        return hbm;
+    }
+    out.bits = static_cast<uint32_t*>(bits);
+    out.width = width;
+    out.height = height;
+    out.stride = width;     // 32 位 DIB 每行天然 4 字节对齐
+    ResetSurfaceClip(out);
+    return hbm;
+}
+#endif
+
+void ResetSurfaceClip(PixelSurface& s) {
+    s.clipLeft = 0;
+    s.clipTop = 0;
+    s.clipRight = s.width;
+    s.clipBottom = s.height;
+}
+
+void SetSurfaceClip(PixelSurface& s, const RECT& rc) {
+    s.clipLeft = (std::max)(0, (int)rc.left);
+    s.clipTop = (std::max)(0, (int)rc.top);
+    s.clipRight = (std::min)(s.width, (int)rc.right);
+    s.clipBottom = (std::min)(s.height, (int)rc.bottom);
+    if (s.clipRight < s.clipLeft) s.clipRight = s.clipLeft;
+    if (s.clipBottom < s.clipTop) s.clipBottom = s.clipTop;
+}
+
+void ClearSurface(PixelSurface& s, COLORREF c) {
+    if (!s.bits) return;
+    if (s.clipLeft >= s.clipRight || s.clipTop >= s.clipBottom) return;
+    uint32_t px = ColorToPixel(c);
+    if (s.clipLeft == 0 && s.clipRight == s.width && s.stride == s.width) {
+        // 整行连续：一次填满所有行
+        g_spanKernels.fill(SurfaceRow(s, s.clipTop),
+            (size_t)(s.clipBottom - s.clipTop) * (size_t)s.width, px);
+        return;
+    }
+    size_t count = (size_t)(s.clipRight - s.clipLeft);
+    for (int y = s.clipTop; y < s.clipBottom; ++y)
+        g_spanKernels.fill(SurfaceRow(s, y) + s.clipLeft, count, px);
+}
+
+void FillSpan(PixelSurface& s, int y, int x1, int x2, uint32_t px) {
+    if (y < s.clipTop || y >= s.clipBottom) return;
+    x1 = (std::max)(x1, s.clipLeft);
+    x2 = (std::min)(x2, s.clipRight - 1);
+    if (x1 > x2) return;
+    g_spanKernels.fill(SurfaceRow(s, y) + x1, (size_t)(x2 - x1 + 1), px);
+}
+
+void XorSpan(PixelSurface& s, int y, int x1, int x2, uint32_t px) {
+    if (y < s.clipTop || y >= s.clipBottom) return;
+    x1 = (std::max)(x1, s.clipLeft);
+    x2 = (std::min)(x2, s.clipRight - 1);
+    if (x1 > x2) return;
+    g_spanKernels.xorFill(SurfaceRow(s, y) + x1, (size_t)(x2 - x1 + 1), px);
+}
+
+void CopySurfaceRect(PixelSurface& dst, const PixelSurface& src, const RECT& rc) {
+    if (!dst.bits || !src.bits) return;
+    int x1 = (std::max)({ (int)rc.left, dst.clipLeft, 0 });
+    int y1 = (std::max)({ (int)rc.top, dst.clipTop, 0 });
+    int x2 = (std::min)({ (int)rc.right, dst.clipRight, src.width });
+    int y2 = (std::min)({ (int)rc.bottom, dst.clipBottom, src.height });
+    if (x1 >= x2 || y1 >= y2) return;
+    size_t bytes = (size_t)(x2 - x1) * sizeof(uint32_t);
+    for (int y = y1; y < y2; ++y)
+        std::memcpy(SurfaceRow(dst, y) + x1, SurfaceRow(src, y) + x1, bytes);
+}
+
+void FillColumn(PixelSurface& s, int x, int y1, int y2, uint32_t px) {
+    if (x < s.clipLeft || x >= s.clipRight) return;
+    y1 = (std::max)(y1, s.clipTop);
+    y2 = (std::min)(y2, s.clipBottom - 1);
+    if (y1 > y2) return;
+    uint32_t* p = s.bits + (size_t)y1 * s.stride + x;
+    for (int y = y1; y <= y2; ++y, p += s.stride)
+        *p = px;
+}
+
+} // namespace GraphicsEngine
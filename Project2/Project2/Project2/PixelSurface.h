@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+// 非 Windows 平台：提供光栅核心用到的最小 GDI 类型，便于无窗口编译与测速
+typedef uint32_t COLORREF;
+typedef uint8_t BYTE;
+typedef int32_t LONG;
+struct RECT { LONG left, top, right, bottom; };
+#define RGB(r, g, b) ((COLORREF)(((BYTE)(r)) | ((uint32_t)((BYTE)(g)) << 8) | ((uint32_t)((BYTE)(b)) << 16)))
+#define GetRValue(c) ((BYTE)(c))
+#define GetGValue(c) ((BYTE)((c) >> 8))
+#define GetBValue(c) ((BYTE)((c) >> 16))
+#endif
+
+namespace GraphicsEngine {
+
+// 32 位像素表面：只描述一块内存，不拥有它
+// 像素格式为 0x00RRGGBB（与 32 位 DIB 的 BGRX 字节序一致）
+// 裁剪区为半开区间 [clipLeft, clipRight) x [clipTop, clipBottom)
+struct PixelSurface {
+    uint32_t* bits = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;       // 每行像素数
+    int clipLeft = 0;
+    int clipTop = 0;
+    int clipRight = 0;
+    int clipBottom = 0;
+};
+
+// 堆内存后备的像素表面（无窗口环境、离屏图层使用）
+struct HeapSurface {
+    std::vector<uint32_t> pixels;
+    PixelSurface surface;
+};
+
+void CreateHeapSurface(HeapSurface& hs, int width, int height);
+#ifdef _WIN32
+// 创建自顶向下的 32 位 DIB 段，并把其像素内存映射到 out
+HBITMAP CreateDIBSurface(HDC hdc, int width, int height, PixelSurface& out);
+#endif
+
+void ResetSurfaceClip(PixelSurface& s);
+void SetSurfaceClip(PixelSurface& s, const RECT& rc);
+void ClearSurface(PixelSurface& s, COLORREF c);
+
+// 连续像素段写入（闭区间，要求 x1 <= x2 / y1 <= y2），自动按裁剪区截断
+void FillSpan(PixelSurface& s, int y, int x1, int x2, uint32_t px);
+void FillColumn(PixelSurface& s, int x, int y1, int y2, uint32_t px);
+void XorSpan(PixelSurface& s, int y, int x1, int x2, uint32_t px);
+// 把 src 中 rc 范围的像素拷到 dst 的相同位置（按 dst 裁剪区与两者尺寸截断）
+void CopySurfaceRect(PixelSurface& dst, const PixelSurface& src, const RECT& rc);
+
+// COLORREF (0x00BBGGRR) <-> 像素 (0x00RRGGBB)，两者互为逆变换
+inline uint32_t ColorToPixel(COLORREF c) {
+    return ((uint32_t)(c & 0xFF) << 16) | (uint32_t)(c & 0xFF00) | ((uint32_t)(c >> 16) & 0xFF);
+}
+
+inline COLORREF PixelToColor(uint32_t p) {
+    return (COLORREF)(((p & 0xFF) << 16) | (p & 0xFF00) | ((p >> 16) & 0xFF));
+}
+
+inline bool InSurfaceClip(const PixelSurface& s, int x, int y) {
+    return x >= s.clipLeft && x < s.clipRight && y >= s.clipTop && y < s.clipBottom;
+}
+
+inline uint32_t* SurfaceRow(const PixelSurface& s, int y) {
+    return s.bits + (size_t)y * (size_t)s.stride;
+}
+
+inline void PutPixel(PixelSurface& s, int x, int y, uint32_t px) {
+    if (InSurfaceClip(s, x, y)) SurfaceRow(s, y)[x] = px;
+}
+
+inline void XorPixel(PixelSurface& s, int x, int y, uint32_t px) {
+    if (InSurfaceClip(s, x, y)) SurfaceRow(s, y)[x] ^= px;
+}
+
+inline uint32_t GetSurfacePixel(const PixelSurface& s, int x, int y) {
+    return SurfaceRow(s, y)[x];
+}
+
+} // namespace GraphicsEngine
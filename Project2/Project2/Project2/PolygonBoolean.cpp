@@ -0,0 +1,498 @@
+#include "PolygonBoolean.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <set>
+
+namespace GraphicsEngine {
+
+namespace {
+
+const int SUBJECT = 0;
+const int CLIP = 1;
+// 点到直线的距离不超过此值（像素）时算作在线上，吸收交点坐标的舍入误差
+const double ON_LINE_DIST = 1e-6;
+// 输入包围盒的宽高都不超过此值时交点可以精确求出（见 Intersect）
+const double EXACT_LIMIT = 32768.0;
+// 坐标更大时交点取到这一网格上（远小于 ON_LINE_DIST）
+const double SNAP_SCALE = 16777216.0;
+
+// 线段的一个端点。两端各一个事件，扫描线按 x、再按 y 的顺序依次处理
+struct SweepEvent {
+    double x, y;
+    int other;          // 同一条线段另一端的事件
+    int poly;           // SUBJECT / CLIP
+    bool left;          // 是否为线段先被扫到的一端
+    int own;            // 自下而上穿过线段时所属多边形环绕数的变化（±1）
+    double dx, dy;      // 指向另一端的方向，取自切开前的原线段，切开后不变
+    double ox, oy;      // 原线段的左端点（整数坐标）
+    // 以下只对已插入扫描线的左端点有意义
+    bool inserted;
+    bool merged;        // 与正下方的线段重合，贡献已并入它
+    int below[2];       // 线段正下方区域对两个多边形的环绕数
+    int contrib[2];     // 自下而上穿过线段时两个环绕数的变化
+};
+
+double SignedArea(double x0, double y0, double x1, double y1, double x2, double y2) {
+    return (x0 - x2) * (y1 - y2) - (x1 - x2) * (y0 - y2);
+}
+
+// 从同一点出发的两个事件的方向叉积，交换 a、b 恰好变号
+// 只用原线段的方向：线段被切开后结果不变，事件队列与扫描线的次序才能保持一致
+double DirCross(const SweepEvent& a, const SweepEvent& b) {
+    return a.dx * b.dy - a.dy * b.dx;
+}
+
+// 方向叉积为 c 的两个事件是否共线（任一端点离另一条所在直线足够近）
+bool NearParallel(double c, const SweepEvent& a, const SweepEvent& b) {
+    double la = a.dx * a.dx + a.dy * a.dy;
+    double lb = b.dx * b.dx + b.dy * b.dy;
+    return c * c <= ON_LINE_DIST * ON_LINE_DIST * (std::max)(la, lb);
+}
+
+double Snap(double v) {
+    return std::round(v * SNAP_SCALE) / SNAP_SCALE;
+}
+
+// 扫描顺序：先 x 后 y
+bool PointBefore(double ax, double ay, double bx, double by) {
+    return ax < bx || (ax == bx && ay < by);
+}
+
+struct BooleanSweep;
+
+// 扫描线上线段的上下次序
+struct StatusLess {
+    const BooleanSweep* sweep;
+    bool operator()(int a, int b) const;
+};
+
+// 事件队列的次序（priority_queue 取“最大”，故为 a 是否晚于 b）
+struct QueueAfter {
+    const BooleanSweep* sweep;
+    bool operator()(int a, int b) const;
+};
+
+typedef std::set<int, StatusLess> SweepStatus;
+
+struct BooleanSweep {
+    std::vector<SweepEvent> ev;
+    std::vector<SweepStatus::iterator> pos;     // 左端点在扫描线中的位置
+    SweepStatus status;
+    std::priority_queue<int, std::vector<int>, QueueAfter> queue;
+    bool exact = true;      // 输入包围盒在 EXACT_LIMIT 以内
+
+    BooleanSweep() : status(StatusLess{ this }), queue(QueueAfter{ this }) {}
+    BooleanSweep(const BooleanSweep&) = delete;
+    BooleanSweep& operator=(const BooleanSweep&) = delete;
+
+    const SweepEvent& LeftOf(int e) const { return ev[e].left ? ev[e] : ev[ev[e].other]; }
+    const SweepEvent& RightOf(int e) const { return ev[e].left ? ev[ev[e].other] : ev[e]; }
+
+    // 点相对事件 e 所在线段（从左端点指向右端点）的位置：> 0 在上方，< 0 在下方
+    double SideOf(int e, double px, double py) const {
+        const SweepEvent& l = LeftOf(e);
+        const SweepEvent& r = RightOf(e);
+        return SignedArea(l.x, l.y, r.x, r.y, px, py);
+    }
+
+    // 同上，离直线足够近时返回 0
+    int SideOfTol(int e, double px, double py) const {
+        const SweepEvent& l = LeftOf(e);
+        const SweepEvent& r = RightOf(e);
+        double dx = r.x - l.x, dy = r.y - l.y;
+        double s = SignedArea(l.x, l.y, r.x, r.y, px, py);
+        if (s * s <= ON_LINE_DIST * ON_LINE_DIST * (dx * dx + dy * dy)) return 0;
+        return s > 0 ? 1 : -1;
+    }
+
+    // 两条线段是否共线（任一条的两个端点都足够靠近另一条所在直线）；对 a、b 对称
+    bool Collinear(int a, int b) const {
+        const SweepEvent& la = LeftOf(a);
+        const SweepEvent& lb = LeftOf(b);
+        const SweepEvent& ra = RightOf(a);
+        const SweepEvent& rb = RightOf(b);
+        return (SideOfTol(a, lb.x, lb.y) == 0 && SideOfTol(a, rb.x, rb.y) == 0) ||
+            (SideOfTol(b, la.x, la.y) == 0 && SideOfTol(b, ra.x, ra.y) == 0);
+    }
+
+    bool EventAfter(int a, int b) const {
+        const SweepEvent& ea = ev[a];
+        const SweepEvent& eb = ev[b];
+        if (ea.x != eb.x) return ea.x > eb.x;
+        if (ea.y != eb.y) return ea.y > eb.y;
+        if (ea.left != eb.left) return ea.left;     // 同一点先处理右端点
+        // 同一点、同为左或右端点：下方的线段先处理
+        double c = DirCross(ea, eb);
+        if (!NearParallel(c, ea, eb)) return ea.left ? c < 0 : c > 0;
+        if (ea.poly != eb.poly) return ea.poly > eb.poly;
+        return a > b;
+    }
+
+    // 左端点为 a 的线段是否在 b 之下（两者都在扫描线中）
+    bool SegmentBelow(int a, int b) const {
+        if (a == b) return false;
+        const SweepEvent& la = ev[a];
+        const SweepEvent& lb = ev[b];
+        if (!Collinear(a, b)) {
+            // 左端点相同时看方向
+            if (la.x == lb.x && la.y == lb.y) return DirCross(la, lb) > 0;
+            if (la.x == lb.x) return la.y < lb.y;
+            // 后插入的一条拿它的左端点与先插入的一条比较
+            if (EventAfter(a, b)) return SideOf(b, la.x, la.y) <= 0;
+            return SideOf(a, lb.x, lb.y) > 0;
+        }
+        // 共线：只需一个前后一致的次序；左端点相同的重合线段中，后处理的在上面
+        if (la.poly != lb.poly) return la.poly < lb.poly;
+        if (la.x == lb.x && la.y == lb.y) return a < b;
+        return EventAfter(a, b);
+    }
+
+    void AddSegment(const Point& p, const Point& q, int poly) {
+        if (p.x == q.x && p.y == q.y) return;
+        bool pFirst = PointBefore(p.x, p.y, q.x, q.y);
+        int l = (int)ev.size();
+        SweepEvent a{};
+        a.poly = poly;
+        a.own = pFirst ? 1 : -1;
+        a.left = true;
+        a.other = l + 1;
+        a.x = pFirst ? p.x : q.x;
+        a.y = pFirst ? p.y : q.y;
+        SweepEvent b = a;
+        b.left = false;
+        b.other = l;
+        b.x = pFirst ? q.x : p.x;
+        b.y = pFirst ? q.y : p.y;
+        a.dx = b.x - a.x;
+        a.dy = b.y - a.y;
+        b.dx = -a.dx;
+        b.dy = -a.dy;
+        a.ox = b.ox = a.x;
+        a.oy = b.oy = a.y;
+        ev.push_back(a);
+        ev.push_back(b);
+    }
+
+    // 在 (x, y) 处把左端点为 l 的线段切成两段：前一段保留 l，后一段的两端都是新事件
+    void Divide(int l, double x, double y) {
+        int r = ev[l].other;
+        int nr = (int)ev.size();
+        int nl = nr + 1;
+        SweepEvent er{};
+        er.x = x;
+        er.y = y;
+        er.poly = ev[l].poly;
+        er.own = ev[l].own;
+        er.left = false;
+        er.other = l;
+        er.dx = ev[r].dx;
+        er.dy = ev[r].dy;
+        er.ox = ev[l].ox;
+        er.oy = ev[l].oy;
+        SweepEvent el = er;
+        el.left = true;
+        el.other = r;
+        el.dx = ev[l].dx;
+        el.dy = ev[l].dy;
+        ev.push_back(er);
+        ev.push_back(el);
+        pos.resize(ev.size());
+        ev[l].other = nr;
+        ev[r].other = nl;
+        queue.push(nr);
+        queue.push(nl);
+    }
+
+    // 点是否落在左端点为 l 的线段内部（不含端点）
+    bool OnInterior(int l, double x, double y) const {
+        const SweepEvent& a = ev[l];
+        const SweepEvent& b = ev[a.other];
+        return PointBefore(a.x, a.y, x, y) && PointBefore(x, y, b.x, b.y) && SideOfTol(l, x, y) == 0;
+    }
+
+    void SplitAt(int l, double x, double y) {
+        const SweepEvent& a = ev[l];
+        const SweepEvent& b = ev[a.other];
+        if ((x == a.x && y == a.y) || (x == b.x && y == b.y)) return;
+        Divide(l, x, y);
+    }
+
+    // 共线的两条线段：在对方的端点处切开，使重叠部分成为端点完全相同的线段
+    // 重叠部分从同一点开始时返回 true（a、b 此时已完全重合）
+    bool Overlap(int a, int b) {
+        double alx = ev[a].x, aly = ev[a].y, arx = ev[ev[a].other].x, ary = ev[ev[a].other].y;
+        double blx = ev[b].x, bly = ev[b].y, brx = ev[ev[b].other].x, bry = ev[ev[b].other].y;
+        if (!PointBefore(blx, bly, arx, ary) || !PointBefore(alx, aly, brx, bry)) return false;
+        // 先切右边的点，左半段仍由原事件表示
+        if (PointBefore(brx, bry, arx, ary)) Divide(a, brx, bry);
+        else if (PointBefore(arx, ary, brx, bry)) Divide(b, arx, ary);
+        if (PointBefore(alx, aly, blx, bly)) Divide(a, blx, bly);
+        else if (PointBefore(blx, bly, alx, aly)) Divide(b, alx, aly);
+        return alx == blx && aly == bly;
+    }
+
+    // 扫描线上相邻的两条线段 a（下）、b（上）求交，在交点处切开；两者重合时返回 true
+    bool Intersect(int a, int b) {
+        if (Collinear(a, b)) return Overlap(a, b);
+        int sb0 = SideOfTol(a, ev[b].x, ev[b].y);
+        int sb1 = SideOfTol(a, ev[ev[b].other].x, ev[ev[b].other].y);
+        int sa0 = SideOfTol(b, ev[a].x, ev[a].y);
+        int sa1 = SideOfTol(b, ev[ev[a].other].x, ev[ev[a].other].y);
+        if (sb0 * sb1 > 0 || sa0 * sa1 > 0) return false;
+
+        const SweepEvent& al = ev[a];
+        const SweepEvent& ar = ev[al.other];
+        const SweepEvent& bl = ev[b];
+        const SweepEvent& br = ev[bl.other];
+        // 交点只能落在两条线段共同的 x 范围内
+        double lox = al.x, loy = al.y, hix = ar.x, hiy = ar.y;
+        if (PointBefore(lox, loy, bl.x, bl.y)) { lox = bl.x; loy = bl.y; }
+        if (PointBefore(br.x, br.y, hix, hiy)) { hix = br.x; hiy = br.y; }
+        double x, y;
+        if (sb0 == 0)      { x = bl.x; y = bl.y; }
+        else if (sb1 == 0) { x = br.x; y = br.y; }
+        else if (sa0 == 0) { x = al.x; y = al.y; }
+        else if (sa1 == 0) { x = ar.x; y = ar.y; }
+        else if (exact) {
+            // 用两条原线段求交：分子分母都是不超过 2^47 的整数，double 精确表示，
+            // 一次除法即为正确舍入的偏移。同一对原线段无论切成几段，交点都相同，
+            // 恰好落在整数上的交点也不会因误差偏到竖线另一侧
+            double den = al.dx * bl.dy - al.dy * bl.dx;
+            if (den == 0) return false;
+            double num = (bl.ox - al.ox) * bl.dy - (bl.oy - al.oy) * bl.dx;
+            x = al.ox + al.dx * num / den;
+            y = al.oy + al.dy * num / den;
+            if (PointBefore(x, y, lox, loy)) { x = lox; y = loy; }
+            if (PointBefore(hix, hiy, x, y)) { x = hix; y = hiy; }
+        }
+        else {
+            double dax = ar.x - al.x, day = ar.y - al.y;
+            double dbx = br.x - bl.x, dby = br.y - bl.y;
+            double den = dax * dby - day * dbx;
+            if (den == 0) return false;
+            double t = ((bl.x - al.x) * dby - (bl.y - al.y) * dbx) / den;
+            // 与竖直、水平线段的交点直接取其坐标，其余取到网格上
+            x = dax == 0 ? al.x : dbx == 0 ? bl.x : Snap(al.x + t * dax);
+            y = day == 0 ? al.y : dby == 0 ? bl.y : Snap(al.y + t * day);
+            if (PointBefore(x, y, lox, loy)) { x = lox; y = loy; }
+            if (PointBefore(hix, hiy, x, y)) { x = hix; y = hiy; }
+        }
+        if (PointBefore(x, y, lox, loy) || PointBefore(hix, hiy, x, y)) return false;
+        SplitAt(a, x, y);
+        SplitAt(b, x, y);
+        return false;
+    }
+
+    void ComputeFields(int e, int prev) {
+        SweepEvent& s = ev[e];
+        s.inserted = true;
+        s.merged = false;
+        s.contrib[SUBJECT] = s.contrib[CLIP] = 0;
+        s.contrib[s.poly] = s.own;
+        for (int k = 0; k < 2; ++k)
+            s.below[k] = prev < 0 ? 0 : ev[prev].below[k] + ev[prev].contrib[k];
+    }
+
+    // hi 与其正下方的 lo 完全重合：贡献并入这一串重合线段中最下面的一条
+    void MergeTwin(int lo, int hi) {
+        SweepStatus::iterator it = pos[lo];
+        while (ev[*it].merged && it != status.begin()) --it;
+        int keep = *it;
+        for (int k = 0; k < 2; ++k) {
+            ev[keep].contrib[k] += ev[hi].contrib[k];
+            ev[hi].contrib[k] = 0;
+        }
+        ev[hi].merged = true;
+        // 其上各条重合线段下方的环绕数随之更新（再往上的区域不变）
+        for (SweepStatus::iterator j = std::next(it); ; ++j) {
+            const SweepEvent& p = ev[*std::prev(j)];
+            for (int k = 0; k < 2; ++k)
+                ev[*j].below[k] = p.below[k] + p.contrib[k];
+            if (*j == hi) break;
+        }
+    }
+
+    // 处理 x 不超过 stopX 的事件
+    void Run(double stopX) {
+        pos.resize(ev.size());
+        for (int i = 0; i < (int)ev.size(); ++i)
+            queue.push(i);
+        while (!queue.empty()) {
+            int e = queue.top();
+            queue.pop();
+            if (ev[e].x > stopX) break;
+            if (ev[e].left) {
+                SweepStatus::iterator it = status.insert(e).first;
+                pos[e] = it;
+                int prev = it == status.begin() ? -1 : *std::prev(it);
+                int next = std::next(it) == status.end() ? -1 : *std::next(it);
+                // 左端点落在相邻线段内部：先在该点切开那条线段，本事件放回队列，
+                // 等切开产生的端点处理完再插入，否则线段下方的区域会算错
+                double x = ev[e].x, y = ev[e].y;
+                int host = prev >= 0 && OnInterior(prev, x, y) ? prev :
+                    next >= 0 && OnInterior(next, x, y) ? next : -1;
+                if (host >= 0) {
+                    status.erase(it);
+                    Divide(host, x, y);
+                    queue.push(e);
+                    continue;
+                }
+                ComputeFields(e, prev);
+                if (next >= 0 && Intersect(e, next)) MergeTwin(e, next);
+                if (prev >= 0 && Intersect(prev, e)) MergeTwin(prev, e);
+            }
+            else {
+                int l = ev[e].other;
+                SweepStatus::iterator it = pos[l];
+                int prev = it == status.begin() ? -1 : *std::prev(it);
+                int next = std::next(it) == status.end() ? -1 : *std::next(it);
+                status.erase(it);
+                if (prev >= 0 && next >= 0 && Intersect(prev, next)) MergeTwin(prev, next);
+            }
+        }
+    }
+};
+
+bool StatusLess::operator()(int a, int b) const {
+    return sweep->SegmentBelow(a, b);
+}
+
+bool QueueAfter::operator()(int a, int b) const {
+    return sweep->EventAfter(a, b);
+}
+
+bool InsideByRule(int winding, FillRule rule) {
+    return rule == FillRule::NonZero ? winding != 0 : (winding & 1) != 0;
+}
+
+bool InResult(BooleanOp op, bool inSubject, bool inClip) {
+    switch (op) {
+    case BooleanOp::Intersection: return inSubject && inClip;
+    case BooleanOp::Union:        return inSubject || inClip;
+    case BooleanOp::Difference:   return inSubject && !inClip;
+    case BooleanOp::Xor:          return inSubject != inClip;
+    }
+    return false;
+}
+
+long long PointKey(const Point& p) {
+    return ((long long)p.x << 32) | (unsigned int)p.y;
+}
+
+long long Cross(const Point& a, const Point& b, const Point& c) {
+    return (long long)(b.x - a.x) * (c.y - b.y) - (long long)(b.y - a.y) * (c.x - b.x);
+}
+
+// 去掉轮廓上重复的点与共线的中间点（切开各边留下的顶点）
+void SimplifyRing(std::vector<Point>& ring) {
+    size_t n = 0;
+    for (size_t i = 0; i < ring.size(); ++i) {
+        Point p = ring[i];
+        if (n >= 1 && p.x == ring[n - 1].x && p.y == ring[n - 1].y) continue;
+        while (n >= 2 && Cross(ring[n - 2], ring[n - 1], p) == 0) n--;
+        ring[n++] = p;
+    }
+    // 首尾相接处
+    size_t b = 0;
+    while (n - b >= 3) {
+        if (Cross(ring[n - 2], ring[n - 1], ring[b]) == 0) n--;
+        else if (Cross(ring[n - 1], ring[b], ring[b + 1]) == 0) b++;
+        else break;
+    }
+    ring.erase(ring.begin() + n, ring.end());
+    ring.erase(ring.begin(), ring.begin() + b);
+}
+
+// 把结果边首尾相连成闭合轮廓；每个顶点上的结果边都是偶数条，任取未用过的一条走下去即可
+void ConnectEdges(const std::vector<Point>& from, const std::vector<Point>& to,
+    std::vector<std::vector<Point>>& out) {
+    int count = (int)from.size();
+    std::vector<std::pair<long long, int>> ends;
+    ends.reserve(count * 2);
+    for (int i = 0; i < count; ++i) {
+        ends.push_back({ PointKey(from[i]), i });
+        ends.push_back({ PointKey(to[i]), i });
+    }
+    std::sort(ends.begin(), ends.end());
+    std::vector<char> used(count, 0);
+    std::vector<Point> ring;
+    for (int e0 = 0; e0 < count; ++e0) {
+        if (used[e0]) continue;
+        used[e0] = 1;
+        ring.clear();
+        Point start = from[e0];
+        Point cur = to[e0];
+        ring.push_back(start);
+        while (cur.x != start.x || cur.y != start.y) {
+            ring.push_back(cur);
+            long long key = PointKey(cur);
+            auto it = std::lower_bound(ends.begin(), ends.end(), std::make_pair(key, -1));
+            int next = -1;
+            for (; it != ends.end() && it->first == key; ++it) {
+                if (!used[it->second]) { next = it->second; break; }
+            }
+            if (next < 0) break;
+            used[next] = 1;
+            bool fromHere = from[next].x == cur.x && from[next].y == cur.y;
+            cur = fromHere ? to[next] : from[next];
+        }
+        SimplifyRing(ring);
+        if (ring.size() >= 3)
+            out.push_back(ring);
+    }
+}
+
+} // namespace
+
+void PolygonBoolean(const std::vector<std::vector<Point>>& subject, FillRule subjectRule,
+    const std::vector<std::vector<Point>>& clip, FillRule clipRule,
+    BooleanOp op, std::vector<std::vector<Point>>& out) {
+    out.clear();
+    BooleanSweep sweep;
+    double maxX[2] = { -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+    int minX = INT_MAX, minY = INT_MAX, maxAllX = INT_MIN, maxAllY = INT_MIN;
+    const std::vector<std::vector<Point>>* input[2] = { &subject, &clip };
+    for (int poly = 0; poly < 2; ++poly) {
+        for (const auto& c : *input[poly]) {
+            if (c.size() < 3) continue;
+            for (size_t i = 0; i < c.size(); ++i) {
+                sweep.AddSegment(c[i], c[(i + 1) % c.size()], poly);
+                maxX[poly] = (std::max)(maxX[poly], (double)c[i].x);
+                minX = (std::min)(minX, c[i].x);
+                minY = (std::min)(minY, c[i].y);
+                maxAllX = (std::max)(maxAllX, c[i].x);
+                maxAllY = (std::max)(maxAllY, c[i].y);
+            }
+        }
+    }
+    sweep.exact = (double)maxAllX - minX <= EXACT_LIMIT && (double)maxAllY - minY <= EXACT_LIMIT;
+
+    // 越过这条竖线后不会再有结果边：求交时任一方结束即可停，求差时被减方结束即可停
+    double stopX = std::numeric_limits<double>::infinity();
+    if (op == BooleanOp::Intersection) stopX = (std::min)(maxX[SUBJECT], maxX[CLIP]);
+    else if (op == BooleanOp::Difference) stopX = maxX[SUBJECT];
+    sweep.Run(stopX);
+
+    // 两侧一在结果内、一在结果外的线段即为结果的边
+    std::vector<Point> from, to;
+    for (const SweepEvent& s : sweep.ev) {
+        if (!s.left || !s.inserted || s.merged) continue;
+        bool inBelow = InResult(op, InsideByRule(s.below[SUBJECT], subjectRule),
+            InsideByRule(s.below[CLIP], clipRule));
+        bool inAbove = InResult(op, InsideByRule(s.below[SUBJECT] + s.contrib[SUBJECT], subjectRule),
+            InsideByRule(s.below[CLIP] + s.contrib[CLIP], clipRule));
+        if (inBelow == inAbove) continue;
+        const SweepEvent& r = sweep.ev[s.other];
+        Point p{ (int)std::round(s.x), (int)std::round(s.y) };
+        Point q{ (int)std::round(r.x), (int)std::round(r.y) };
+        if (p.x == q.x && p.y == q.y) continue;
+        from.push_back(p);
+        to.push_back(q);
+    }
+    ConnectEdges(from, to, out);
+}
+
+} // namespace GraphicsEngine
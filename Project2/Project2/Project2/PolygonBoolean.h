@@ -0,0 +1,23 @@
+#pragma once
+
+#include <vector>
+#include "ShapeTypes.h"
+
+namespace GraphicsEngine {
+
+enum class BooleanOp {
+    Intersection,   // 交集
+    Union,          // 并集
+    Difference,     // 差集：subject 减去 clip
+    Xor             // 异或
+};
+
+// 多边形布尔运算：subject、clip 各为一组闭合轮廓，按各自的填充规则确定内部
+// 用平移扫描线（Bentley-Ottmann / Martinez 式）求出所有交点并在交点处切开各边，
+// 同一次扫描中记下每条边两侧的环绕数，O((n + k) log n)，n 为边数，k 为交点数
+// 结果是互不交叉的闭合轮廓（洞也是一条单独的轮廓），按奇偶规则填充即为运算结果
+void PolygonBoolean(const std::vector<std::vector<Point>>& subject, FillRule subjectRule,
+    const std::vector<std::vector<Point>>& clip, FillRule clipRule,
+    BooleanOp op, std::vector<std::vector<Point>>& out);
+
+} // namespace GraphicsEngine
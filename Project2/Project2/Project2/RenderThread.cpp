@@ -0,0 +1,94 @@
+#include "RenderThread.h"
+#include <atomic>
+#include <thread>
+
+namespace GraphicsEngine {
+
+namespace {
+
+// middle 的低两位是槽下标，SLOT_FRESH 表示该槽是渲染线程尚未取走的新快照
+const int SLOT_INDEX = 3;
+const int SLOT_FRESH = 4;
+
+struct RenderMailbox {
+    FrameSnapshot slots[3];
+    int back = 0;                   // UI 线程私有：正在填写的槽
+    std::atomic<int> middle{ 1 };   // 交接槽
+    int front = 2;                  // 渲染线程私有：正在渲染的槽
+    bool carryDamage = false;       // back 槽是被覆盖的快照，其脏区域要保留
+    unsigned long long superseded = 0;
+
+    RenderThreadHooks hooks{};
+    std::thread thread;
+    HANDLE wake = nullptr;          // 自动复位事件：有新快照或需要退出
+    std::atomic<bool> quit{ false };
+};
+
+RenderMailbox g_mailbox;
+
+void RenderMain() {
+    RenderMailbox& mb = g_mailbox;
+    if (mb.hooks.start) mb.hooks.start();
+    for (;;) {
+        WaitForSingleObject(mb.wake, INFINITE);
+        if (mb.quit.load(std::memory_order_acquire)) break;
+        // 只有本线程会清除 SLOT_FRESH，检查后再交换不会取到旧快照
+        if (!(mb.middle.load(std::memory_order_acquire) & SLOT_FRESH)) continue;
+        int prev = mb.middle.exchange(mb.front, std::memory_order_acq_rel);
+        mb.front = prev & SLOT_INDEX;
+        if (mb.hooks.frame) mb.hooks.frame(mb.slots[mb.front]);
+    }
+    if (mb.hooks.stop) mb.hooks.stop();
+}
+
+} // namespace
+
+void StartRenderThread(const RenderThreadHooks& hooks) {
+    RenderMailbox& mb = g_mailbox;
+    if (mb.thread.joinable()) return;
+    mb.hooks = hooks;
+    mb.quit.store(false);
+    mb.wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    mb.thread = std::thread(RenderMain);
+}
+
+void StopRenderThread() {
+    RenderMailbox& mb = g_mailbox;
+    if (!mb.thread.joinable()) return;
+    mb.quit.store(true, std::memory_order_release);
+    SetEvent(mb.wake);
+    mb.thread.join();
+    CloseHandle(mb.wake);
+    mb.wake = nullptr;
+    // 释放快照持有的图形表与物体
+    for (auto& slot : mb.slots)
+        slot = FrameSnapshot{};
+    mb.carryDamage = false;
+}
+
+FrameSnapshot& BeginFrameSnapshot() {
+    RenderMailbox& mb = g_mailbox;
+    FrameSnapshot& f = mb.slots[mb.back];
+    if (!mb.carryDamage)
+        ClearDamage(f.region);
+    mb.carryDamage = false;
+    return f;
+}
+
+void PublishFrameSnapshot() {
+    RenderMailbox& mb = g_mailbox;
+    int prev = mb.middle.exchange(mb.back | SLOT_FRESH, std::memory_order_acq_rel);
+    mb.back = prev & SLOT_INDEX;
+    // 换回来的槽仍是新快照：渲染线程还没取走它就被覆盖了
+    if (prev & SLOT_FRESH) {
+        mb.carryDamage = true;
+        mb.superseded++;
+    }
+    if (mb.wake) SetEvent(mb.wake);
+}
+
+unsigned long long SupersededFrameCount() {
+    return g_mailbox.superseded;
+}
+
+} // namespace GraphicsEngine
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <windows.h>
+#include <memory>
+#include <vector>
+#include "GraphicsEngine.h"
+#include "DamageRegion.h"
+#include "ShapeStore.h"
+
+namespace GraphicsEngine {
+
+// 渲染线程：UI 线程把场景拷成不可变快照发布出去，渲染线程只读快照进行光栅化与呈现
+// 快照经三缓冲交接（单生产者/单消费者、无锁），只保留最新的一帧：
+// 渲染线程来不及取走的快照被下一帧覆盖，其脏区域并入下一帧，不会丢失
+
+// 二维帧：图形表整体共享（只在图形改动后重新拷贝成结构数组），叠加层状态按值拷贝
+struct Scene2DSnapshot {
+    std::shared_ptr<const ShapeStore> shapes;
+    bool tiled = false;
+    // 选中的图形（下标升序）只共享下标，拖动预览由渲染线程按 previewTransform 变换选中图形得到
+    std::shared_ptr<const std::vector<int>> selection;
+    bool showSelection = false;     // 画选中高亮
+    RECT selectionBounds{};         // 选中图形（拖动中为变换后）的总包围盒
+    bool hasPreview = false;        // 变换拖动中
+    Affine2D previewTransform;
+    bool useDragLayer = false;      // 拖动中：其余图形使用缓存的静态背景层
+    bool rubberBand = false;        // 框选中
+    DrawMode mode = DrawMode::None;
+    bool isDrawing = false;
+    Point firstClick{ 0, 0 };
+    Point mousePos{ 0, 0 };
+    std::vector<Point> currentPoints;
+    COLORREF drawColor = 0;
+};
+
+struct Scene3DSnapshot {
+    std::vector<Object3D> objects;
+    Camera camera{};
+    Light light{};
+    bool settingLightPos = false;
+    Point mousePos{ 0, 0 };
+};
+
+struct FrameSnapshot {
+    bool is3D = false;
+    int width = 0;
+    int height = 0;
+    DamageRegion region;            // 二维帧需要重绘的范围
+    Scene2DSnapshot scene2D;
+    Scene3DSnapshot scene3D;
+};
+
+// 以下回调都在渲染线程上调用
+struct RenderThreadHooks {
+    void (*start)();                // 创建渲染线程独占的资源（后台缓冲、GL 上下文）
+    void (*frame)(const FrameSnapshot& frame);
+    void (*stop)();                 // 释放上述资源
+};
+
+void StartRenderThread(const RenderThreadHooks& hooks);
+// 等待渲染线程处理完当前帧后退出
+void StopRenderThread();
+
+// UI 线程：取得下一帧的快照槽并填写，再调用 PublishFrameSnapshot
+// 槽中的 region 可能带有上一帧未渲染的脏区域，只应往里追加
+FrameSnapshot& BeginFrameSnapshot();
+void PublishFrameSnapshot();
+// 被后续快照覆盖、没有渲染出来的快照数
+unsigned long long SupersededFrameCount();
+
+} // namespace GraphicsEngine
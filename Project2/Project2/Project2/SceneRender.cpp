@@ -0,0 +1,113 @@
+#include "SceneRender.h"
+#include "Fill.h"
+#include "WorkerPool.h"
+#include "DamageRegion.h"
+#include <algorithm>
+#include <functional>
+
+namespace GraphicsEngine {
+
+void RenderShape(PixelSurface& surf, const Shape& s) {
+    if (s.fillMode == 1)
+        FillShapeScanline(surf, s, s.fillColor);
+    else if (s.fillMode == 2)
+        FillShapeFence(surf, s, s.fillColor);
+    DrawShapeBorder(surf, s);
+}
+
+void RenderShapes(PixelSurface& surf, const std::vector<Shape>& shapes) {
+    for (const auto& s : shapes)
+        RenderShape(surf, s);
+}
+
+// 分块绘制的公共部分：boundsOf 给出第 i 个图形的范围（不可见返回 false），
+// draw 在块的裁剪区内绘制第 i 个图形
+static void RenderTiled(PixelSurface& surf, int count, const std::vector<int>* skip, int tileSize,
+    const std::function<bool(int, RECT&)>& boundsOf, const std::function<void(PixelSurface&, int)>& draw) {
+    if (!surf.bits || count <= 0) return;
+    std::vector<char> skipped;
+    if (skip && !skip->empty()) {
+        skipped.assign(count, 0);
+        for (int i : *skip)
+            if (i >= 0 && i < count) skipped[i] = 1;
+    }
+    auto isSkipped = [&](int i) { return !skipped.empty() && skipped[i]; };
+    // 单核时分块只会带来跨块图元的重复计算
+    if (WorkerThreadCount() <= 1) {
+        RECT clip = { surf.clipLeft, surf.clipTop, surf.clipRight, surf.clipBottom };
+        for (int i = 0; i < count; ++i) {
+            RECT rc;
+            if (!isSkipped(i) && boundsOf(i, rc) && RectsOverlap(rc, clip)) draw(surf, i);
+        }
+        return;
+    }
+    int areaW = surf.clipRight - surf.clipLeft;
+    int areaH = surf.clipBottom - surf.clipTop;
+    if (areaW <= 0 || areaH <= 0) return;
+    tileSize = (std::max)(tileSize, 8);
+    int tilesX = (areaW + tileSize - 1) / tileSize;
+    int tilesY = (areaH + tileSize - 1) / tileSize;
+    int tileCount = tilesX * tilesY;
+
+    // 每个图形覆盖的块范围 [tx0, tx1] x [ty0, ty1]；tx0 > tx1 表示不可见
+    struct TileRange { int tx0, ty0, tx1, ty1; };
+    std::vector<TileRange> ranges(count);
+    std::vector<int> offsets(tileCount + 1, 0);
+    for (int i = 0; i < count; ++i) {
+        TileRange& tr = ranges[i];
+        tr = { 1, 1, 0, 0 };
+        RECT rc;
+        if (isSkipped(i) || !boundsOf(i, rc)) continue;
+        int l = (std::max)((int)rc.left, surf.clipLeft) - surf.clipLeft;
+        int t = (std::max)((int)rc.top, surf.clipTop) - surf.clipTop;
+        int r = (std::min)((int)rc.right, surf.clipRight) - surf.clipLeft;
+        int b = (std::min)((int)rc.bottom, surf.clipBottom) - surf.clipTop;
+        if (l >= r || t >= b) continue;
+        tr = { l / tileSize, t / tileSize, (r - 1) / tileSize, (b - 1) / tileSize };
+        for (int ty = tr.ty0; ty <= tr.ty1; ++ty)
+            for (int tx = tr.tx0; tx <= tr.tx1; ++tx)
+                offsets[ty * tilesX + tx + 1]++;
+    }
+
+    // 分箱：按图形下标顺序写入，每块内自然保持绘制顺序
+    for (int i = 0; i < tileCount; ++i)
+        offsets[i + 1] += offsets[i];
+    std::vector<int> binned(offsets[tileCount]);
+    std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (int i = 0; i < count; ++i) {
+        const TileRange& tr = ranges[i];
+        for (int ty = tr.ty0; ty <= tr.ty1; ++ty)
+            for (int tx = tr.tx0; tx <= tr.tx1; ++tx)
+                binned[cursor[ty * tilesX + tx]++] = i;
+    }
+
+    // 各块互不重叠，只写自己的裁剪区，可以并行
+    ParallelFor(tileCount, [&](int tile) {
+        int begin = offsets[tile], end = offsets[tile + 1];
+        if (begin == end) return;
+        int tx = tile % tilesX, ty = tile / tilesX;
+        PixelSurface ts = surf;
+        ts.clipLeft = surf.clipLeft + tx * tileSize;
+        ts.clipTop = surf.clipTop + ty * tileSize;
+        ts.clipRight = (std::min)(ts.clipLeft + tileSize, surf.clipRight);
+        ts.clipBottom = (std::min)(ts.clipTop + tileSize, surf.clipBottom);
+        for (int k = begin; k < end; ++k)
+            draw(ts, binned[k]);
+    });
+}
+
+void RenderShapesTiled(PixelSurface& surf, const std::vector<Shape>& shapes, const std::vector<int>* skip,
+    int tileSize) {
+    RenderTiled(surf, (int)shapes.size(), skip, tileSize,
+        [&](int i, RECT& rc) { return ShapeBounds(shapes[i], rc); },
+        [&](PixelSurface& ts, int i) { RenderShape(ts, shapes[i]); });
+}
+
+void RenderCommandsTiled(PixelSurface& surf, const CommandBuffer& cb, const std::vector<int>* skip,
+    int tileSize) {
+    RenderTiled(surf, (int)cb.shapes.size(), skip, tileSize,
+        [&](int i, RECT& rc) { rc = cb.shapes[i].bounds; return cb.shapes[i].visible; },
+        [&](PixelSurface& ts, int i) { ReplayShapeCommands(ts, cb, i); });
+}
+
+} // namespace GraphicsEngine
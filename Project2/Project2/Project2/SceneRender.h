@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Shapes.h"
+#include "CommandBuffer.h"
+
+namespace GraphicsEngine {
+
+constexpr int RENDER_TILE_SIZE = 64;
+
+// 绘制单个图形：按 fillMode 填充后描边
+void RenderShape(PixelSurface& surf, const Shape& s);
+// 在调用线程上按列表顺序绘制
+void RenderShapes(PixelSurface& surf, const std::vector<Shape>& shapes);
+// 分块并行绘制：表面按 tileSize 切块，图形按包围盒分到各块，
+// 各块在线程池上绘制，块内仍按列表顺序，结果与 RenderShapes 逐像素一致
+// skip 中的图形不画（拖动中的选中图形，下标升序）
+void RenderShapesTiled(PixelSurface& surf, const std::vector<Shape>& shapes, const std::vector<int>* skip = nullptr,
+    int tileSize = RENDER_TILE_SIZE);
+// 同上，重放命令缓冲
+void RenderCommandsTiled(PixelSurface& surf, const CommandBuffer& cb, const std::vector<int>* skip = nullptr,
+    int tileSize = RENDER_TILE_SIZE);
+
+} // namespace GraphicsEngine
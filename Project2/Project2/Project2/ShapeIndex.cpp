@@ -0,0 +1,169 @@
+#include "ShapeIndex.h"
+#include "DamageRegion.h"
+#include <algorithm>
+
+namespace GraphicsEngine {
+
+static const int CELL_SIZES[2] = { SHAPE_INDEX_CELL, SHAPE_INDEX_COARSE_CELL };
+
+static int CellOf(int v, int size) {
+    // 向下取整，负坐标也落在正确的格子里
+    return v >= 0 ? v / size : -((-v + size - 1) / size);
+}
+
+static long long CellKey(int cx, int cy) {
+    return ((long long)cx << 32) ^ (long long)(unsigned int)cy;
+}
+
+// 半开矩形在某层覆盖的格子范围（闭区间）
+struct CellRange {
+    int cx0, cy0, cx1, cy1;
+};
+
+static CellRange CellsOf(const RECT& rc, int level) {
+    int size = CELL_SIZES[level];
+    return { CellOf(rc.left, size), CellOf(rc.top, size), CellOf(rc.right - 1, size), CellOf(rc.bottom - 1, size) };
+}
+
+static long long CellCount(const CellRange& r) {
+    return (long long)(r.cx1 - r.cx0 + 1) * (r.cy1 - r.cy0 + 1);
+}
+
+static RECT HitRect(const RECT& rc) {
+    return { rc.left - SHAPE_INDEX_HIT_MARGIN, rc.top - SHAPE_INDEX_HIT_MARGIN,
+        rc.right + SHAPE_INDEX_HIT_MARGIN, rc.bottom + SHAPE_INDEX_HIT_MARGIN };
+}
+
+static void EraseId(std::vector<int>& ids, int i) {
+    auto it = std::find(ids.begin(), ids.end(), i);
+    if (it == ids.end()) return;
+    *it = ids.back();
+    ids.pop_back();
+}
+
+static void Unregister(ShapeIndex& index, int i) {
+    if (!index.indexed[i]) return;
+    int level = index.level[i];
+    if (level == 2) {
+        EraseId(index.large, i);
+    }
+    else {
+        CellRange r = CellsOf(HitRect(index.bounds[i]), level);
+        auto& cells = index.cells[level];
+        for (int cy = r.cy0; cy <= r.cy1; ++cy)
+            for (int cx = r.cx0; cx <= r.cx1; ++cx) {
+                auto it = cells.find(CellKey(cx, cy));
+                if (it == cells.end()) continue;
+                EraseId(it->second, i);
+                if (it->second.empty()) cells.erase(it);
+            }
+    }
+    index.indexed[i] = 0;
+}
+
+// 登记用外扩后的范围，点查询只需看点所在的格子
+static void Register(ShapeIndex& index, int i) {
+    RECT hit = HitRect(index.bounds[i]);
+    int level = 0;
+    CellRange r = CellsOf(hit, 0);
+    if (CellCount(r) > SHAPE_INDEX_MAX_CELLS) {
+        level = 1;
+        r = CellsOf(hit, 1);
+        if (CellCount(r) > SHAPE_INDEX_MAX_CELLS) level = 2;
+    }
+    if (level == 2) {
+        index.large.push_back(i);
+    }
+    else {
+        auto& cells = index.cells[level];
+        for (int cy = r.cy0; cy <= r.cy1; ++cy)
+            for (int cx = r.cx0; cx <= r.cx1; ++cx)
+                cells[CellKey(cx, cy)].push_back(i);
+    }
+    index.level[i] = (char)level;
+    index.indexed[i] = 1;
+}
+
+void ResetShapeIndex(ShapeIndex& index) {
+    index.bounds.clear();
+    index.indexed.clear();
+    index.level.clear();
+    index.cells[0].clear();
+    index.cells[1].clear();
+    index.large.clear();
+}
+
+void RebuildShapeIndex(ShapeIndex& index, const std::vector<Shape>& shapes) {
+    ResetShapeIndex(index);
+    for (size_t i = 0; i < shapes.size(); ++i)
+        IndexShape(index, (int)i, shapes[i]);
+}
+
+void IndexShape(ShapeIndex& index, int i, const Shape& s) {
+    if (i < 0 || i > (int)index.bounds.size()) return;
+    if (i == (int)index.bounds.size()) {
+        index.bounds.push_back({ 0, 0, 0, 0 });
+        index.indexed.push_back(0);
+        index.level.push_back(0);
+    }
+    else {
+        Unregister(index, i);
+    }
+    if (ShapeBounds(s, index.bounds[i]))
+        Register(index, i);
+    else
+        index.bounds[i] = { 0, 0, 0, 0 };
+}
+
+void QueryShapeIndex(const ShapeIndex& index, const RECT& rc, std::vector<int>& out) {
+    out.clear();
+    if (rc.left >= rc.right || rc.top >= rc.bottom) return;
+    CellRange r[2] = { CellsOf(rc, 0), CellsOf(rc, 1) };
+    // 查询范围的格子数比图形还多时直接逐个比较包围盒
+    if (CellCount(r[0]) > (long long)index.bounds.size()) {
+        for (size_t i = 0; i < index.bounds.size(); ++i)
+            if (index.indexed[i] && RectsOverlap(index.bounds[i], rc)) out.push_back((int)i);
+        return;
+    }
+    for (int level = 0; level < 2; ++level) {
+        const auto& cells = index.cells[level];
+        if (cells.empty()) continue;
+        for (int cy = r[level].cy0; cy <= r[level].cy1; ++cy)
+            for (int cx = r[level].cx0; cx <= r[level].cx1; ++cx) {
+                auto it = cells.find(CellKey(cx, cy));
+                if (it != cells.end())
+                    out.insert(out.end(), it->second.begin(), it->second.end());
+            }
+    }
+    out.insert(out.end(), index.large.begin(), index.large.end());
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    out.erase(std::remove_if(out.begin(), out.end(),
+        [&](int i) { return !RectsOverlap(index.bounds[i], rc); }), out.end());
+}
+
+void QueryShapeIndexPoint(const ShapeIndex& index, int x, int y, std::vector<int>& out) {
+    out.clear();
+    for (int level = 0; level < 2; ++level) {
+        auto it = index.cells[level].find(CellKey(CellOf(x, CELL_SIZES[level]), CellOf(y, CELL_SIZES[level])));
+        if (it != index.cells[level].end())
+            out.insert(out.end(), it->second.begin(), it->second.end());
+    }
+    out.insert(out.end(), index.large.begin(), index.large.end());
+    RECT pt = { x, y, x + 1, y + 1 };
+    out.erase(std::remove_if(out.begin(), out.end(),
+        [&](int i) { return !RectsOverlap(HitRect(index.bounds[i]), pt); }), out.end());
+    std::sort(out.begin(), out.end());
+}
+
+int HitTestShape(const std::vector<Shape>& shapes, const ShapeIndex& index, int x, int y) {
+    thread_local std::vector<int> candidates;
+    QueryShapeIndexPoint(index, x, y, candidates);
+    for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+        if (*it < (int)shapes.size() && PointInShape(shapes[*it], x, y))
+            return *it;
+    }
+    return -1;
+}
+
+} // namespace GraphicsEngine
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "Shapes.h"
+
+namespace GraphicsEngine {
+
+// 两层均匀网格的边长（像素）：一般图形登记在细网格，跨越细网格过多格子的大图形登记在粗网格
+constexpr int SHAPE_INDEX_CELL = 128;
+constexpr int SHAPE_INDEX_COARSE_CELL = 2048;
+// 每个图形最多登记的格子数；粗网格也放不下的图形单独列出，每次查询都作为候选
+constexpr int SHAPE_INDEX_MAX_CELLS = 64;
+// 点查询的外扩量：覆盖 PointInShape 对直线的 3 像素容差
+constexpr int SHAPE_INDEX_HIT_MARGIN = 4;
+
+// 图形表的空间索引：按图形下标登记其包围盒（同 ShapeBounds）所在的网格
+// 图形表追加、改动、重排后须相应调用 IndexShape / RebuildShapeIndex
+struct ShapeIndex {
+    std::vector<RECT> bounds;       // 与图形表一一对应
+    std::vector<char> indexed;      // 无效图形（无包围盒）为 0
+    std::vector<char> level;        // 登记所在的网格层（2 为 large）
+    std::unordered_map<long long, std::vector<int>> cells[2];
+    std::vector<int> large;
+};
+
+void ResetShapeIndex(ShapeIndex& index);
+void RebuildShapeIndex(ShapeIndex& index, const std::vector<Shape>& shapes);
+// 登记第 i 个图形的当前范围；i 等于已登记数时为追加，否则替换原有登记
+void IndexShape(ShapeIndex& index, int i, const Shape& s);
+// 包围盒与 rc 相交的图形下标，升序
+void QueryShapeIndex(const ShapeIndex& index, const RECT& rc, std::vector<int>& out);
+// 可能命中点 (x, y) 的图形下标，升序
+void QueryShapeIndexPoint(const ShapeIndex& index, int x, int y, std::vector<int>& out);
+// 同 HitTestShape，只对候选图形调用 PointInShape
+int HitTestShape(const std::vector<Shape>& shapes, const ShapeIndex& index, int x, int y);
+
+} // namespace GraphicsEngine
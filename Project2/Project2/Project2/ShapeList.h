@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include "ShapeTypes.h"
+#include "ShapeIndex.h"
+
+namespace GraphicsEngine {
+
+// 图形表，定义在 GraphicsEngine.cpp；无窗口程序（测速、测试）自行定义
+extern std::vector<Shape> g_shapes;
+// g_shapes 的空间索引，图形表改动后须同步更新
+extern ShapeIndex g_shapeIndex;
+
+} // namespace GraphicsEngine
@@ -0,0 +1,112 @@
+#include "ShapeStore.h"
+#include <algorithm>
+
+namespace GraphicsEngine {
+
+void ClearShapeStore(ShapeStore& store) {
+    store.types.clear();
+    store.colors.clear();
+    store.fillColors.clear();
+    store.fillModes.clear();
+    store.fillRules.clear();
+    store.revisions.clear();
+    store.vertexSpans.clear();
+    store.extraSlots.clear();
+    store.extras.clear();
+    store.vertices.clear();
+    store.contours.clear();
+}
+
+// 图形的 ShapeExtra 追加到 extras，轮廓长度追加到 contours arena；返回槽号
+static unsigned int AppendExtra(ShapeStore& store, const Shape& s) {
+    if (!s.extra) return 0;
+    const ShapeExtra& e = *s.extra;
+    ArenaSpan cs = { (unsigned int)store.contours.size(), (unsigned int)e.contours.size() };
+    store.contours.insert(store.contours.end(), e.contours.begin(), e.contours.end());
+    store.extras.push_back({ e.lineSteps, e.rasterKey, e.rasterOffset, cs });
+    return (unsigned int)store.extras.size();
+}
+
+void AppendShape(ShapeStore& store, const Shape& s) {
+    store.types.push_back(s.type);
+    store.colors.push_back(s.color);
+    store.fillColors.push_back(s.fillColor);
+    store.fillModes.push_back(s.fillMode);
+    store.fillRules.push_back(s.fillRule);
+    store.revisions.push_back(s.revision);
+    store.vertexSpans.push_back({ (unsigned int)store.vertices.size(), (unsigned int)s.vertices.size() });
+    store.vertices.insert(store.vertices.end(), s.vertices.begin(), s.vertices.end());
+    store.extraSlots.push_back(AppendExtra(store, s));
+}
+
+void BuildShapeStore(ShapeStore& store, const std::vector<Shape>& shapes) {
+    // 先数出顶点、extras 与轮廓总数，每列只分配一次，再按下标逐列写入
+    size_t n = shapes.size(), nv = 0, ne = 0, nc = 0;
+    for (const auto& s : shapes) {
+        nv += s.vertices.size();
+        if (s.extra) {
+            ++ne;
+            nc += s.extra->contours.size();
+        }
+    }
+    store.types.resize(n);
+    store.colors.resize(n);
+    store.fillColors.resize(n);
+    store.fillModes.resize(n);
+    store.fillRules.resize(n);
+    store.revisions.resize(n);
+    store.vertexSpans.resize(n);
+    store.extraSlots.resize(n);
+    store.vertices.resize(nv);
+    store.extras.clear();
+    store.extras.reserve(ne);
+    store.contours.clear();
+    store.contours.reserve(nc);
+
+    unsigned int vo = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Shape& s = shapes[i];
+        store.types[i] = s.type;
+        store.colors[i] = s.color;
+        store.fillColors[i] = s.fillColor;
+        store.fillModes[i] = s.fillMode;
+        store.fillRules[i] = s.fillRule;
+        store.revisions[i] = s.revision;
+        unsigned int vn = (unsigned int)s.vertices.size();
+        std::copy(s.vertices.begin(), s.vertices.end(), store.vertices.begin() + vo);
+        store.vertexSpans[i] = { vo, vn };
+        vo += vn;
+        store.extraSlots[i] = AppendExtra(store, s);
+    }
+}
+
+void LoadShape(const ShapeStore& store, size_t i, Shape& out) {
+    out.type = store.types[i];
+    out.color = store.colors[i];
+    out.fillColor = store.fillColors[i];
+    out.fillMode = store.fillModes[i];
+    out.fillRule = store.fillRules[i];
+    out.revision = store.revisions[i];
+    const ArenaSpan& vs = store.vertexSpans[i];
+    out.vertices.assign(store.vertices.data() + vs.offset, vs.count);
+    // out 反复使用：已有的 ShapeExtra 不释放，没有对应项时各项重置为默认值
+    unsigned int slot = store.extraSlots[i];
+    if (!slot && !out.extra) return;
+    ShapeExtra& e = EditShapeExtra(out);
+    e.transform.reset();
+    if (!slot) {
+        e.contours.clear();
+        e.lineSteps = LineSteps{};
+        e.rasterKey = out.revision;
+        e.rasterOffset = { 0, 0 };
+        return;
+    }
+    const StoreExtra& se = store.extras[slot - 1];
+    e.contours.assign(store.contours.begin() + se.contourSpan.offset,
+        store.contours.begin() + se.contourSpan.offset + se.contourSpan.count);
+    e.lineSteps = se.lineSteps;
+    e.rasterKey = se.rasterKey;
+    e.rasterOffset = se.rasterOffset;
+}
+
+} // namespace GraphicsEngine
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include "ShapeTypes.h"
+
+namespace GraphicsEngine {
+
+// 区间：arena 中 [offset, offset + count)
+struct ArenaSpan {
+    unsigned int offset;
+    unsigned int count;
+};
+
+// 带 ShapeExtra 的图形在 extras 中的一项；轮廓长度在 contours arena 中
+struct StoreExtra {
+    LineSteps lineSteps;
+    unsigned long long rasterKey;
+    Point rasterOffset;
+    ArenaSpan contourSpan;
+};
+
+// 图形表的结构数组形式：各属性分列存放，所有图形的顶点、轮廓长度各放在一块连续内存中
+// 用作交给渲染线程的场景快照：拷贝整张表只需几次整块分配，按版本号比对时只扫描一列
+// 与 Shape 一样，不常用的状态只为用到的图形存放（extras），每个图形只多一个下标
+struct ShapeStore {
+    std::vector<DrawMode> types;
+    std::vector<COLORREF> colors;
+    std::vector<COLORREF> fillColors;
+    std::vector<int> fillModes;
+    std::vector<FillRule> fillRules;
+    std::vector<unsigned long long> revisions;
+    std::vector<ArenaSpan> vertexSpans;
+    std::vector<unsigned int> extraSlots;   // 0 表示没有，否则为 extras 下标 + 1
+    std::vector<StoreExtra> extras;
+    std::vector<Point> vertices;        // 顶点 arena
+    std::vector<int> contours;          // 复合路径轮廓长度 arena
+};
+
+inline size_t ShapeCount(const ShapeStore& store) {
+    return store.types.size();
+}
+
+// 第 i 个图形的光栅缓存键（同 ShapeRasterKey）
+inline unsigned long long StoreRasterKey(const ShapeStore& store, size_t i) {
+    unsigned int slot = store.extraSlots[i];
+    return slot ? store.extras[slot - 1].rasterKey : store.revisions[i];
+}
+
+void ClearShapeStore(ShapeStore& store);
+void AppendShape(ShapeStore& store, const Shape& s);
+// 按图形表整体重建
+void BuildShapeStore(ShapeStore& store, const std::vector<Shape>& shapes);
+// 取出第 i 个图形（out 可反复使用，顶点不超过内联容量时不分配内存）
+void LoadShape(const ShapeStore& store, size_t i, Shape& out);
+
+} // namespace GraphicsEngine
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "PixelSurface.h"
+
+namespace GraphicsEngine {
+
+// DrawMode 与 FillRule 只占一个字节，图形表与 ShapeStore 中存放得更紧凑
+enum class DrawMode : unsigned char {
+    None,
+    DrawLineMidpoint,
+    DrawLineBresenham,
+    DrawLineRunSlice,
+    DrawCircleMidpoint,
+    DrawCircleBresenham,
+    DrawRectangle,
+    DrawPolygon,
+    DrawBSpline,
+    DrawCompound,
+    DrawArc,
+    FillScanline,
+    FillFence,
+    TransformTranslate,
+    TransformScale,
+    TransformRotate,
+    ClipLineCS,
+    ClipLineMid,
+    ClipLineLB,
+    ClipPolySH,
+    ClipPolyWA,
+    ClipPolyWindow
+};
+
+// 多边形填充规则：奇偶规则 / 非零环绕数规则
+enum class FillRule : unsigned char {
+    EvenOdd,
+    NonZero
+};
+
+struct Point {
+    int x;
+    int y;
+};
+
+// 二维仿射变换 x' = a x + b y + tx，y' = c x + d y + ty，默认为恒等变换
+struct Affine2D {
+    double a = 1, b = 0, tx = 0;
+    double c = 0, d = 1, ty = 0;
+};
+
+// 图形的顶点表：直线、矩形、圆只有两个顶点，不超过 POINT_LIST_INLINE 个时存放在对象内部，
+// 不分配堆内存；更多时整体搬到堆上。内联数组与堆指针共用同一块空间，整个顶点表只占 40 字节
+// 搬到堆上以后即使清空也保留这块内存，反复装入顶点（如 LoadShape）不再分配
+constexpr size_t POINT_LIST_INLINE = 4;
+
+struct PointList {
+    union {
+        Point inl[POINT_LIST_INLINE];
+        Point* heap;
+    };
+    uint32_t count = 0;
+    uint32_t heapCapacity = 0;      // 0 表示顶点在 inl 中，否则在 heap 中
+
+    PointList() {}
+    PointList(const PointList& o) { append(o.data(), o.count); }
+    PointList(PointList&& o) noexcept { take(o); }
+    PointList& operator=(const PointList& o) {
+        if (this != &o) assign(o.data(), o.count);
+        return *this;
+    }
+    PointList& operator=(PointList&& o) noexcept {
+        if (this != &o) {
+            release();
+            take(o);
+        }
+        return *this;
+    }
+    ~PointList() { release(); }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return heapCapacity ? heapCapacity : POINT_LIST_INLINE; }
+    bool empty() const { return count == 0; }
+    Point* data() { return heapCapacity ? heap : inl; }
+    const Point* data() const { return heapCapacity ? heap : inl; }
+    Point* begin() { return data(); }
+    Point* end() { return data() + count; }
+    const Point* begin() const { return data(); }
+    const Point* end() const { return data() + count; }
+    Point& operator[](size_t i) { return data()[i]; }
+    const Point& operator[](size_t i) const { return data()[i]; }
+    Point& front() { return data()[0]; }
+    const Point& front() const { return data()[0]; }
+    Point& back() { return data()[count - 1]; }
+    const Point& back() const { return data()[count - 1]; }
+
+    void clear() { count = 0; }
+    void reserve(size_t n) {
+        if (n <= capacity()) return;
+        size_t grown = (std::max)(n, 2 * capacity());
+        Point* p = new Point[grown];
+        const Point* src = data();
+        for (size_t i = 0; i < count; ++i) p[i] = src[i];
+        release();
+        heap = p;
+        heapCapacity = (uint32_t)grown;
+    }
+    void push_back(const Point& p) {
+        if (count == capacity()) reserve(count + 1);
+        data()[count++] = p;
+    }
+    void append(const Point* p, size_t n) {
+        reserve(count + n);
+        Point* dst = data() + count;
+        for (size_t i = 0; i < n; ++i) dst[i] = p[i];
+        count += (uint32_t)n;
+    }
+    void assign(const Point* p, size_t n) {
+        clear();
+        append(p, n);
+    }
+    void assign(const std::vector<Point>& v) {
+        assign(v.data(), v.size());
+    }
+
+private:
+    void release() {
+        if (heapCapacity) delete[] heap;
+        heapCapacity = 0;
+    }
+    void take(PointList& o) {
+        count = o.count;
+        heapCapacity = o.heapCapacity;
+        if (heapCapacity) heap = o.heap;
+        else for (uint32_t i = 0; i < count; ++i) inl[i] = o.inl[i];
+        o.count = 0;
+        o.heapCapacity = 0;
+    }
+};
+
+// 直线沿主方向的步号区间 [first, last]：共 max(|dx|, |dy|) + 1 步，第 0 步为起点
+// last < 0 表示整条线段
+struct LineSteps {
+    int first = 0;
+    int last = -1;
+};
+
+// 累计的仿射变换：vertices = round(xform · baseVertices)。缩放、旋转只复合 xform，
+// 再从 baseVertices 重新计算顶点，多次变换不累积取整误差
+// xformRevision 为上次计算顶点后图形的版本号，与图形当前版本号不同说明顶点被直接改动过（裁剪等），
+// 下次变换时以当前顶点作为新的 baseVertices
+struct ShapeTransform {
+    PointList baseVertices;
+    Affine2D xform;
+    unsigned long long xformRevision = 0;
+};
+
+// 按需分配的对象：未分配时只占一个指针，拷贝时深拷贝一份
+template <class T>
+struct ClonePtr {
+    std::unique_ptr<T> p;
+
+    ClonePtr() = default;
+    ClonePtr(ClonePtr&&) = default;
+    ClonePtr& operator=(ClonePtr&&) = default;
+    ClonePtr(const ClonePtr& o) : p(o.p ? new T(*o.p) : nullptr) {}
+    ClonePtr& operator=(const ClonePtr& o) {
+        if (this != &o) p.reset(o.p ? new T(*o.p) : nullptr);
+        return *this;
+    }
+
+    explicit operator bool() const { return p != nullptr; }
+    T* get() const { return p.get(); }
+    T* operator->() const { return p.get(); }
+    T& operator*() const { return *p; }
+    void reset() { p.reset(); }
+    T& emplace() {
+        p.reset(new T());
+        return *p;
+    }
+};
+
+// 缩放、旋转的累计状态，只有缩放或旋转过的图形才分配
+typedef ClonePtr<ShapeTransform> ShapeTransformPtr;
+
+// 只有少数图形用到的状态，集中放在一块按需分配的内存里；没有分配时各项取默认值
+// 读取用下面的 Shape* 函数，写入前用 EditShapeExtra 取得（必要时分配）
+struct ShapeExtra {
+    // 复合路径 (DrawCompound)：vertices 依次存放各条闭合轮廓，contours 为每条轮廓的顶点数
+    // B 样条：contours 非空时 vertices 依次存放几条互不相连的曲线的控制点（裁剪结果）
+    std::vector<int> contours;
+    // 直线：中点分割裁剪后端点不动，只画原线段的这一段步号，画出的像素与裁剪前逐个相同
+    // （与圆弧保留方向点同理）；整数平移后仍然有效，其他变换前由 ResolveLineSteps 落实到端点
+    LineSteps lineSteps;
+    // 光栅覆盖缓存的键：默认即版本号；整数平移换版本号时保留原来的键，只累加 rasterOffset，
+    // 平移不改变光栅化结果，缓存的像素段加上偏移即可复用
+    unsigned long long rasterKey = 0;
+    Point rasterOffset{ 0, 0 };
+    ShapeTransformPtr transform;
+};
+
+// 图形表里的每一项：常用的几项直接存放，其余见 ShapeExtra；两个顶点的图形不分配堆内存
+struct Shape {
+    COLORREF color;
+    COLORREF fillColor;
+    int fillMode;
+    DrawMode type;
+    FillRule fillRule = FillRule::EvenOdd;
+    // 圆弧 (DrawArc)：vertices 为圆心、圆上一点，其后每两个点为一段弧起止方向上的点（见 DrawArcMidpoint）
+    PointList vertices;
+    // 版本号：几何或样式每次改动后由 TouchShape 换成全局唯一的新值，
+    // 绘制缓存据此判断图形是否变化；0 表示未登记，不做缓存
+    unsigned long long revision = 0;
+    ClonePtr<ShapeExtra> extra;
+};
+
+inline const std::vector<int>& ShapeContourSizes(const Shape& s) {
+    static const std::vector<int> none;
+    return s.extra ? s.extra->contours : none;
+}
+
+inline LineSteps ShapeLineSteps(const Shape& s) {
+    return s.extra ? s.extra->lineSteps : LineSteps{};
+}
+
+inline unsigned long long ShapeRasterKey(const Shape& s) {
+    return s.extra ? s.extra->rasterKey : s.revision;
+}
+
+inline Point ShapeRasterOffset(const Shape& s) {
+    return s.extra ? s.extra->rasterOffset : Point{ 0, 0 };
+}
+
+inline ShapeTransform* ShapeTransformOf(const Shape& s) {
+    return s.extra ? s.extra->transform.get() : nullptr;
+}
+
+// 第一次分配时各项为默认值（光栅缓存键即当前版本号）
+inline ShapeExtra& EditShapeExtra(Shape& s) {
+    if (!s.extra) s.extra.emplace().rasterKey = s.revision;
+    return *s.extra;
+}
+
+inline void SetShapeLineSteps(Shape& s, const LineSteps& steps) {
+    if (s.extra || steps.last >= 0) EditShapeExtra(s).lineSteps = steps;
+}
+
+inline void ClearShapeContours(Shape& s) {
+    if (s.extra) s.extra->contours.clear();
+}
+
+} // namespace GraphicsEngine
@@ -1,6 +1,7 @@
 #include "Shapes.h"
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 
 namespace GraphicsEngine {
 
@@ -17,16 +18,36 @@ double Dist2PointSeg(double x, double y, double x1, double y1, double x2, double
     return (x - px) * (x - px) + (y - py) * (y - py);
 }
 
+// 点在复合路径内：沿 +x 方向射线统计各轮廓的环绕数
+static bool PointInContours(const Shape& s, int x, int y) {
+    const auto& v = s.vertices;
+    int winding = 0;
+    size_t start = 0;
+    for (int n : ShapeContourSizes(s)) {
+        if (n <= 0 || start + n > v.size()) break;
+        for (int i = 0; i < n; ++i) {
+            const Point& a = v[start + i];
+            const Point& b = v[start + (i + 1) % n];
+            if ((a.y <= y) == (b.y <= y)) continue;
+            double ix = a.x + (double)(y - a.y) * (b.x - a.x) / (double)(b.y - a.y);
+            if (ix > x) winding += a.y < b.y ? 1 : -1;
+        }
+        start += n;
+    }
+    if (s.fillRule == FillRule::NonZero) return winding != 0;
+    return (winding & 1) != 0;
+}
+
 bool PointInShape(const Shape& s, int x, int y) {
     const auto& v = s.vertices;
     if (v.size() < 2) return false;
 
     switch (s.type) {
     case DrawMode::DrawRectangle: {
-        int x1 = min(v[0].x, v[1].x);
-        int x2 = max(v[0].x, v[1].x);
-        int y1 = min(v[0].y, v[1].y);
-        int y2 = max(v[0].y, v[1].y);
+        int x1 = (std::min)(v[0].x, v[1].x);
+        int x2 = (std::max)(v[0].x, v[1].x);
+        int y1 = (std::min)(v[0].y, v[1].y);
+        int y2 = (std::max)(v[0].y, v[1].y);
         return x >= x1 && x <= x2 && y >= y1 && y <= y2;
     }
     case DrawMode::DrawCircleMidpoint:
@@ -40,16 +61,27 @@ bool PointInShape(const Shape& s, int x, int y) {
     case DrawMode::DrawPolygon: {
         int minX = v[0].x, maxX = v[0].x, minY = v[0].y, maxY = v[0].y;
         for (auto& p : v) {
-            minX = min(minX, p.x); maxX = max(maxX, p.x);
-            minY = min(minY, p.y); maxY = max(maxY, p.y);
+            minX = (std::min)(minX, p.x); maxX = (std::max)(maxX, p.x);
+            minY = (std::min)(minY, p.y); maxY = (std::max)(maxY, p.y);
         }
         return x >= minX && x <= maxX && y >= minY && y <= maxY;
     }
+    case DrawMode::DrawCompound:
+        return PointInContours(s, x, y);
+    case DrawMode::DrawArc: {
+        // 与直线相同，离弧 3 像素以内算选中
+        int dx = x - v[0].x, dy = y - v[0].y;
+        double d = std::sqrt(double(dx * dx + dy * dy)) - CircleRadius(v);
+        return d * d <= 9.0 && ArcCoversDirection(v[0].x, v[0].y, v.data() + 2, v.size() - 2, dx, dy);
+    }
     case DrawMode::DrawLineMidpoint:
-    case DrawMode::DrawLineBresenham: {
+    case DrawMode::DrawLineBresenham:
+    case DrawMode::DrawLineRunSlice: {
+        Point a, b;
+        LineVisibleEnds(s, a, b);
         double d2 = Dist2PointSeg((double)x, (double)y,
-            (double)v[0].x, (double)v[0].y,
-            (double)v[1].x, (double)v[1].y);
+            (double)a.x, (double)a.y,
+            (double)b.x, (double)b.y);
         return d2 <= 9.0;
     }
     default:
@@ -57,50 +89,224 @@ bool PointInShape(const Shape& s, int x, int y) {
     }
 }
 
-int HitTestShape(int x, int y) {
-    for (int i = (int)g_shapes.size() - 1; i >= 0; --i) {
-        if (PointInShape(g_shapes[i], x, y))
+int HitTestShape(const std::vector<Shape>& shapes, int x, int y) {
+    for (int i = (int)shapes.size() - 1; i >= 0; --i) {
+        if (PointInShape(shapes[i], x, y))
             return i;
     }
     return -1;
 }
 
-void DrawShapeBorder(HDC hdc, const Shape& s) {
+void DrawShapeBorder(PixelSurface& surf, const Shape& s) {
     const auto& v = s.vertices;
     if (v.size() < 2) return;
+    LineSteps steps = ShapeLineSteps(s);
+    int first = steps.first, last = steps.last;
+    bool clipped = last >= 0;
     switch (s.type) {
     case DrawMode::DrawLineMidpoint:
-        DrawLineMidpoint(hdc, v[0].x, v[0].y, v[1].x, v[1].y, s.color); break;
+        if (clipped) DrawLineMidpointSteps(surf, v[0].x, v[0].y, v[1].x, v[1].y, first, last, s.color);
+        else DrawLineMidpoint(surf, v[0].x, v[0].y, v[1].x, v[1].y, s.color);
+        break;
     case DrawMode::DrawLineBresenham:
-        DrawLineBresenham(hdc, v[0].x, v[0].y, v[1].x, v[1].y, s.color); break;
+        if (clipped) DrawLineBresenhamSteps(surf, v[0].x, v[0].y, v[1].x, v[1].y, first, last, s.color);
+        else DrawLineBresenham(surf, v[0].x, v[0].y, v[1].x, v[1].y, s.color);
+        break;
+    case DrawMode::DrawLineRunSlice:
+        if (clipped) DrawLineRunSliceSteps(surf, v[0].x, v[0].y, v[1].x, v[1].y, first, last, s.color);
+        else DrawLineRunSlice(surf, v[0].x, v[0].y, v[1].x, v[1].y, s.color);
+        break;
     case DrawMode::DrawCircleMidpoint: {
         int r = int(std::sqrt(double((v[1].x - v[0].x) * (v[1].x - v[0].x) +
             (v[1].y - v[0].y) * (v[1].y - v[0].y))));
-        DrawCircleMidpoint(hdc, v[0].x, v[0].y, r, s.color);
+        DrawCircleMidpoint(surf, v[0].x, v[0].y, r, s.color);
     } break;
     case DrawMode::DrawCircleBresenham: {
         int r = int(std::sqrt(double((v[1].x - v[0].x) * (v[1].x - v[0].x) +
             (v[1].y - v[0].y) * (v[1].y - v[0].y))));
-        DrawCircleBresenham(hdc, v[0].x, v[0].y, r, s.color);
+        DrawCircleBresenham(surf, v[0].x, v[0].y, r, s.color);
     } break;
     case DrawMode::DrawRectangle: {
-        int x1 = min(v[0].x, v[1].x);
-        int x2 = max(v[0].x, v[1].x);
-        int y1 = min(v[0].y, v[1].y);
-        int y2 = max(v[0].y, v[1].y);
-        DrawLineMidpoint(hdc, x1, y1, x2, y1, s.color);
-        DrawLineMidpoint(hdc, x2, y1, x2, y2, s.color);
-        DrawLineMidpoint(hdc, x2, y2, x1, y2, s.color);
-        DrawLineMidpoint(hdc, x1, y2, x1, y1, s.color);
+        int x1 = (std::min)(v[0].x, v[1].x);
+        int x2 = (std::max)(v[0].x, v[1].x);
+        int y1 = (std::min)(v[0].y, v[1].y);
+        int y2 = (std::max)(v[0].y, v[1].y);
+        DrawLineMidpoint(surf, x1, y1, x2, y1, s.color);
+        DrawLineMidpoint(surf, x2, y1, x2, y2, s.color);
+        DrawLineMidpoint(surf, x2, y2, x1, y2, s.color);
+        DrawLineMidpoint(surf, x1, y2, x1, y1, s.color);
     } break;
     case DrawMode::DrawPolygon:
-        DrawPolyline(hdc, v, s.color, true);
+        DrawPolyline(surf, v.data(), v.size(), s.color, true);
         break;
     case DrawMode::DrawBSpline:
-        DrawBSpline(hdc, v, s.color);
+        ForEachBSplinePiece(s, [&](const Point* ctrl, size_t n) {
+            DrawBSpline(surf, ctrl, n, s.color);
+        });
         break;
+    case DrawMode::DrawArc:
+        DrawArcMidpoint(surf, v[0].x, v[0].y, CircleRadius(v), v.data() + 2, v.size() - 2, s.color);
+        break;
+    case DrawMode::DrawCompound: {
+        size_t start = 0;
+        for (int n : ShapeContourSizes(s)) {
+            if (n <= 0 || start + n > v.size()) break;
+            for (int i = 0; i < n; ++i) {
+                const Point& a = v[start + i];
+                const Point& b = v[start + (i + 1) % n];
+                DrawLineMidpoint(surf, a.x, a.y, b.x, b.y, s.color);
+            }
+            start += n;
+        }
+    } break;
     default: break;
     }
 }
 
+void LineVisibleEnds(const Shape& s, Point& a, Point& b) {
+    const auto& v = s.vertices;
+    a = v[0];
+    b = v[1];
+    LineSteps steps = ShapeLineSteps(s);
+    if (steps.last < 0) return;
+    a = LineStepPoint(v[0].x, v[0].y, v[1].x, v[1].y, steps.first);
+    b = LineStepPoint(v[0].x, v[0].y, v[1].x, v[1].y, steps.last);
+}
+
+void ResolveLineSteps(Shape& s) {
+    if (ShapeLineSteps(s).last < 0) return;
+    Point a, b;
+    LineVisibleEnds(s, a, b);
+    s.vertices[0] = a;
+    s.vertices[1] = b;
+    s.extra->lineSteps = LineSteps{};
+}
+
+int CircleRadius(const PointList& v) {
+    return int(std::sqrt(double((v[1].x - v[0].x) * (v[1].x - v[0].x) +
+        (v[1].y - v[0].y) * (v[1].y - v[0].y))));
+}
+
+// 圆弧的包围盒：各段弧的端点，加上弧经过的上下左右四个极点
+static void ArcBounds(const PointList& v, int& minX, int& minY, int& maxX, int& maxY) {
+    int xc = v[0].x, yc = v[0].y;
+    int r = CircleRadius(v);
+    minX = maxX = xc;
+    minY = maxY = yc;
+    auto add = [&](int x, int y) {
+        minX = (std::min)(minX, x); maxX = (std::max)(maxX, x);
+        minY = (std::min)(minY, y); maxY = (std::max)(maxY, y);
+    };
+    bool first = true;
+    for (size_t i = 2; i < v.size(); ++i) {
+        double dx = v[i].x - xc, dy = v[i].y - yc;
+        double len = std::sqrt(dx * dx + dy * dy);
+        if (len <= 0) continue;
+        double px = xc + dx * r / len, py = yc + dy * r / len;
+        if (first) {
+            minX = maxX = (int)std::floor(px);
+            minY = maxY = (int)std::floor(py);
+            first = false;
+        }
+        add((int)std::floor(px), (int)std::floor(py));
+        add((int)std::ceil(px), (int)std::ceil(py));
+    }
+    const int axis[4][2] = { { r, 0 }, { 0, r }, { -r, 0 }, { 0, -r } };
+    for (auto& a : axis)
+        if (ArcCoversDirection(xc, yc, v.data() + 2, v.size() - 2, a[0], a[1]))
+            add(xc + a[0], yc + a[1]);
+}
+
+bool ShapeBounds(const Shape& s, RECT& rc) {
+    const auto& v = s.vertices;
+    if (v.size() < 2) return false;
+
+    int minX, minY, maxX, maxY;
+    if (s.type == DrawMode::DrawCircleMidpoint || s.type == DrawMode::DrawCircleBresenham) {
+        int r = int(std::sqrt(double((v[1].x - v[0].x) * (v[1].x - v[0].x) +
+            (v[1].y - v[0].y) * (v[1].y - v[0].y))));
+        minX = v[0].x - r; maxX = v[0].x + r;
+        minY = v[0].y - r; maxY = v[0].y + r;
+    }
+    else if (s.type == DrawMode::DrawArc) {
+        ArcBounds(v, minX, minY, maxX, maxY);
+    }
+    else if (ShapeLineSteps(s).last >= 0) {
+        Point a, b;
+        LineVisibleEnds(s, a, b);
+        minX = (std::min)(a.x, b.x); maxX = (std::max)(a.x, b.x);
+        minY = (std::min)(a.y, b.y); maxY = (std::max)(a.y, b.y);
+    }
+    else {
+        // 直线、矩形、多边形取顶点包围盒；B 样条曲线落在控制点凸包内
+        minX = maxX = v[0].x;
+        minY = maxY = v[0].y;
+        for (auto& p : v) {
+            minX = (std::min)(minX, p.x); maxX = (std::max)(maxX, p.x);
+            minY = (std::min)(minY, p.y); maxY = (std::max)(maxY, p.y);
+        }
+    }
+    // 多留 1 像素余量，覆盖取整误差
+    rc.left = minX - 1;
+    rc.top = minY - 1;
+    rc.right = maxX + 2;
+    rc.bottom = maxY + 2;
+    return true;
+}
+
+static unsigned long long NextRevision() {
+    static std::atomic<unsigned long long> nextRevision{ 1 };
+    return nextRevision.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TouchShape(Shape& s) {
+    s.revision = NextRevision();
+    if (!s.extra) return;
+    ShapeExtra& e = *s.extra;
+    e.rasterKey = s.revision;
+    e.rasterOffset = { 0, 0 };
+    // 各项都回到默认值时不再占用内存
+    if (e.contours.empty() && e.lineSteps.last < 0 && !e.transform) s.extra.reset();
+}
+
+void TouchShapeTranslated(Shape& s, int dx, int dy) {
+    unsigned long long key = ShapeRasterKey(s);
+    if (key == 0) {
+        TouchShape(s);
+        return;
+    }
+    s.revision = NextRevision();
+    ShapeExtra& e = EditShapeExtra(s);
+    e.rasterKey = key;
+    e.rasterOffset.x += dx;
+    e.rasterOffset.y += dy;
+}
+
+void TouchShapeStyle(Shape& s) {
+    ShapeTransform* t = ShapeTransformOf(s);
+    bool tracked = t && t->xformRevision == s.revision;
+    TouchShape(s);
+    if (tracked) t->xformRevision = s.revision;
+}
+
+Shape MakeContourShape(const Shape& style, std::vector<std::vector<Point>>& contours) {
+    Shape ns = style;
+    ns.vertices.clear();
+    ns.extra.reset();
+    if (contours.size() == 1) {
+        ns.type = DrawMode::DrawPolygon;
+        ns.vertices.assign(contours[0]);
+        TouchShape(ns);
+        return ns;
+    }
+    ns.type = DrawMode::DrawCompound;
+    std::vector<int>& sizes = EditShapeExtra(ns).contours;
+    for (auto& c : contours) {
+        ns.vertices.append(c.data(), c.size());
+        sizes.push_back((int)c.size());
+    }
+    TouchShape(ns);
+    return ns;
+}
+
 } // namespace GraphicsEngine
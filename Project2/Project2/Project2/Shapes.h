@@ -1,13 +1,46 @@
 #pragma once
 
-#include "GraphicsState.h"
 #include "DrawingPrimitives.h"
 
 namespace GraphicsEngine {
 
 double Dist2PointSeg(double x, double y, double x1, double y1, double x2, double y2);
 bool PointInShape(const Shape& s, int x, int y);
-int HitTestShape(int x, int y);
-void DrawShapeBorder(HDC hdc, const Shape& s);
+int HitTestShape(const std::vector<Shape>& shapes, int x, int y);
+void DrawShapeBorder(PixelSurface& surf, const Shape& s);
+// 图形（含描边与填充）可能写到的像素范围，半开区间；无效图形返回 false
+bool ShapeBounds(const Shape& s, RECT& rc);
+// 图形改动后调用：分配新的版本号，使基于旧版本的绘制缓存失效
+void TouchShape(Shape& s);
+// 图形整体平移 (dx, dy) 后调用：换新版本号，但保留光栅覆盖缓存
+void TouchShapeTranslated(Shape& s, int dx, int dy);
+// 只改颜色、填充方式等样式后调用：换新版本号，顶点未动，累计变换继续有效
+void TouchShapeStyle(Shape& s);
+// 由若干闭合轮廓构造一个图形（沿用 style 的颜色与填充设置）
+// 只有一条轮廓时退化为普通多边形，多条时为复合路径
+Shape MakeContourShape(const Shape& style, std::vector<std::vector<Point>>& contours);
+// 直线可见部分的首末像素：按步号区间截取，未裁剪时即两端点
+void LineVisibleEnds(const Shape& s, Point& a, Point& b);
+// 裁剪过的直线：端点换成可见部分的首末像素并清除步号区间（缩放、旋转等变换前调用，不换版本号）
+void ResolveLineSteps(Shape& s);
+// 圆与圆弧的半径（与绘制时相同的取整）
+int CircleRadius(const PointList& v);
+
+// 依次对 B 样条的每条曲线调用 fn(ctrl, n)：contours 为空时所有控制点是一条曲线
+template <class Fn>
+void ForEachBSplinePiece(const Shape& s, Fn fn) {
+    const auto& v = s.vertices;
+    const auto& contours = ShapeContourSizes(s);
+    if (contours.empty()) {
+        fn(v.data(), v.size());
+        return;
+    }
+    size_t start = 0;
+    for (int n : contours) {
+        if (n <= 0 || start + n > v.size()) break;
+        fn(v.data() + start, (size_t)n);
+        start += n;
+    }
+}
 
 } // namespace GraphicsEngine
@@ -0,0 +1,124 @@
+#include "SpanFill.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SPAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC 允许在未开 /arch:AVX2 时直接使用 AVX2 内建函数；GCC/Clang 需按函数开启
+#if defined(SPAN_X86) && !defined(_MSC_VER)
+#define SPAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SPAN_TARGET_AVX2
+#endif
+
+namespace GraphicsEngine {
+
+#ifndef SPAN_X86
+// ----- 标量实现（非 x86 平台） -----
+static void FillSpanScalar(uint32_t* dst, size_t count, uint32_t px) {
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = px;
+}
+
+static void XorSpanScalar(uint32_t* dst, size_t count, uint32_t px) {
+    for (size_t i = 0; i < count; ++i)
+        dst[i] ^= px;
+}
+
+bool CpuHasAVX2() {
+    return false;
+}
+#else
+// ----- SSE2：对齐到 16 字节后每次写 16 个像素 -----
+static void FillSpanSSE2(uint32_t* dst, size_t count, uint32_t px) {
+    while (count && ((uintptr_t)dst & 15)) { *dst++ = px; --count; }
+    __m128i v = _mm_set1_epi32((int)px);
+    for (; count >= 16; count -= 16, dst += 16) {
+        _mm_store_si128((__m128i*)(dst + 0), v);
+        _mm_store_si128((__m128i*)(dst + 4), v);
+        _mm_store_si128((__m128i*)(dst + 8), v);
+        _mm_store_si128((__m128i*)(dst + 12), v);
+    }
+    for (; count >= 4; count -= 4, dst += 4)
+        _mm_store_si128((__m128i*)dst, v);
+    while (count--) *dst++ = px;
+}
+
+static void XorSpanSSE2(uint32_t* dst, size_t count, uint32_t px) {
+    while (count && ((uintptr_t)dst & 15)) { *dst++ ^= px; --count; }
+    __m128i v = _mm_set1_epi32((int)px);
+    for (; count >= 8; count -= 8, dst += 8) {
+        __m128i a = _mm_load_si128((const __m128i*)(dst + 0));
+        __m128i b = _mm_load_si128((const __m128i*)(dst + 4));
+        _mm_store_si128((__m128i*)(dst + 0), _mm_xor_si128(a, v));
+        _mm_store_si128((__m128i*)(dst + 4), _mm_xor_si128(b, v));
+    }
+    while (count--) *dst++ ^= px;
+}
+
+// ----- AVX2：对齐到 32 字节后每次写 16 个像素 -----
+SPAN_TARGET_AVX2
+static void FillSpanAVX2(uint32_t* dst, size_t count, uint32_t px) {
+    while (count && ((uintptr_t)dst & 31)) { *dst++ = px; --count; }
+    __m256i v = _mm256_set1_epi32((int)px);
+    for (; count >= 16; count -= 16, dst += 16) {
+        _mm256_store_si256((__m256i*)(dst + 0), v);
+        _mm256_store_si256((__m256i*)(dst + 8), v);
+    }
+    if (count >= 8) {
+        _mm256_store_si256((__m256i*)dst, v);
+        dst += 8; count -= 8;
+    }
+    while (count--) *dst++ = px;
+}
+
+SPAN_TARGET_AVX2
+static void XorSpanAVX2(uint32_t* dst, size_t count, uint32_t px) {
+    while (count && ((uintptr_t)dst & 31)) { *dst++ ^= px; --count; }
+    __m256i v = _mm256_set1_epi32((int)px);
+    for (; count >= 16; count -= 16, dst += 16) {
+        __m256i a = _mm256_load_si256((const __m256i*)(dst + 0));
+        __m256i b = _mm256_load_si256((const __m256i*)(dst + 8));
+        _mm256_store_si256((__m256i*)(dst + 0), _mm256_xor_si256(a, v));
+        _mm256_store_si256((__m256i*)(dst + 8), _mm256_xor_si256(b, v));
+    }
+    while (count--) *dst++ ^= px;
+}
+
+bool CpuHasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    // 操作系统需保存 YMM 状态
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+static SpanKernels SelectSpanKernels() {
+#ifdef SPAN_X86
+    if (CpuHasAVX2())
+        return { FillSpanAVX2, XorSpanAVX2, "AVX2" };
+    return { FillSpanSSE2, XorSpanSSE2, "SSE2" };
+#else
+    return { FillSpanScalar, XorSpanScalar, "Scalar" };
+#endif
+}
+
+const SpanKernels g_spanKernels = SelectSpanKernels();
+
+} // namespace GraphicsEngine
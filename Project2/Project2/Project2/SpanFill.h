@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GraphicsEngine {
+
+// 32 位像素段内核：程序启动时按 CPU 能力在 AVX2 / SSE2 / 标量实现中选择一次
+typedef void (*SpanKernelFn)(uint32_t* dst, size_t count, uint32_t px);
+
+struct SpanKernels {
+    SpanKernelFn fill;      // dst[i] = px
+    SpanKernelFn xorFill;   // dst[i] ^= px（栅栏填充）
+    const char* name;
+};
+
+extern const SpanKernels g_spanKernels;
+
+// CPU 与操作系统是否支持 AVX2（其他 SIMD 内核选择实现时共用）
+bool CpuHasAVX2();
+
+} // namespace GraphicsEngine
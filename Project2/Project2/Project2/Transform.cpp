@@ -1,69 +1,164 @@
 #include "Transform.h"
+#include "Shapes.h"
+#include "WorkerPool.h"
+#include <algorithm>
 #include <cmath>
-#include <vector>
 
 namespace GraphicsEngine {
 
-void TranslateShape(Shape& s, int dx, int dy) {
-    for (auto& p : s.vertices) {
-        p.x += dx;
-        p.y += dy;
-    }
+// 顶点被直接改动过（或从未变换过）时，以当前顶点为基准重新开始累计
+// 第一次缩放、旋转时才分配累计状态
+static ShapeTransform& EnsureTransformBase(Shape& s) {
+    ShapeTransform* cur = ShapeTransformOf(s);
+    if (cur && cur->xformRevision == s.revision) return *cur;
+    ShapeTransform& t = cur ? *cur : EditShapeExtra(s).transform.emplace();
+    t.baseVertices = s.vertices;
+    t.xform = Affine2D{};
+    return t;
 }
 
-void ScaleShape(Shape& s, const Point& center, double sx, double sy) {
-    for (auto& p : s.vertices) {
-        double dx = p.x - center.x;
-        double dy = p.y - center.y;
-        p.x = (int)std::round(center.x + dx * sx);
-        p.y = (int)std::round(center.y + dy * sy);
-    }
+// 矩形：把两个角点 pts 展开成 4 顶点多边形，之后按多边形处理
+// 矩形的累计变换只含轴向缩放与平移，展开后顶点仍与原矩形一致
+static void RectangleToPolygon(Shape& s, PointList& pts) {
+    if (pts.size() < 2) return;
+    Point p0 = pts[0];
+    Point p1 = pts[1];
+
+    int x1 = (std::min)(p0.x, p1.x);
+    int x2 = (std::max)(p0.x, p1.x);
+    int y1 = (std::min)(p0.y, p1.y);
+    int y2 = (std::max)(p0.y, p1.y);
+
+    Point poly[4] = { { x1, y1 }, { x2, y1 }, { x2, y2 }, { x1, y2 } };
+    pts.assign(poly, 4);
+    s.type = DrawMode::DrawPolygon;
 }
 
-void RotateShape(Shape& s, const Point& center, double angleRad) {
-    // 矩形：先变成4顶点的多边形，再旋转
-    if (s.type == DrawMode::DrawRectangle && s.vertices.size() >= 2) {
-        Point p0 = s.vertices[0];
-        Point p1 = s.vertices[1];
-
-        int x1 = min(p0.x, p1.x);
-        int x2 = max(p0.x, p1.x);
-        int y1 = min(p0.y, p1.y);
-        int y2 = max(p0.y, p1.y);
-
-        std::vector<Point> poly(4);
-        poly[0] = { x1, y1 };
-        poly[1] = { x2, y1 };
-        poly[2] = { x2, y2 };
-        poly[3] = { x1, y2 };
-
-        double c = std::cos(angleRad);
-        double sn = std::sin(angleRad);
-        for (auto& p : poly) {
-            double dx = p.x - center.x;
-            double dy = p.y - center.y;
-            double nx = dx * c - dy * sn;
-            double ny = dx * sn + dy * c;
-            p.x = (int)std::round(center.x + nx);
-            p.y = (int)std::round(center.y + ny);
+void ComposeShapeTransform(Shape& s, const Affine2D& m) {
+    ResolveLineSteps(s);
+    ShapeTransform& t = EnsureTransformBase(s);
+    if (s.type == DrawMode::DrawRectangle && (m.b != 0 || m.c != 0))
+        RectangleToPolygon(s, t.baseVertices);
+    t.xform = AffineCompose(m, t.xform);
+}
+
+void BakeShapeTransform(Shape& s) {
+    ShapeTransform& t = *ShapeTransformOf(s);
+    // 基准顶点数只在 RectangleToPolygon 中变化
+    if (s.vertices.size() != t.baseVertices.size())
+        s.vertices.assign(t.baseVertices.data(), t.baseVertices.size());
+    AffineTransformPoints(t.xform, t.baseVertices.data(), s.vertices.data(), t.baseVertices.size());
+    TouchShape(s);
+    t.xformRevision = s.revision;
+}
+
+// 每个并行任务处理的图形数
+static const int TRANSFORM_BATCH = 256;
+
+void TransformShapes(std::vector<Shape>& shapes, const std::vector<int>& indices, const Affine2D& m) {
+    int dx = 0, dy = 0;
+    bool translate = IsIntegerTranslation(m, dx, dy);
+    int count = (int)indices.size();
+    int batches = (count + TRANSFORM_BATCH - 1) / TRANSFORM_BATCH;
+    // 各图形只改自己的顶点；版本号由原子计数器分配
+    // 在 UI 线程上调用，线程池被渲染线程占用时就地串行执行
+    ParallelForIfIdle(batches, [&](int b) {
+        int end = (std::min)(count, (b + 1) * TRANSFORM_BATCH);
+        for (int k = b * TRANSFORM_BATCH; k < end; ++k) {
+            Shape& s = shapes[indices[k]];
+            if (translate) {
+                TranslateShape(s, dx, dy);
+            }
+            else {
+                ComposeShapeTransform(s, m);
+                BakeShapeTransform(s);
+            }
         }
+    });
+}
 
-        s.type = DrawMode::DrawPolygon;   // 之后按多边形处理
-        s.vertices = poly;
+bool IsIntegerTranslation(const Affine2D& m, int& dx, int& dy) {
+    if (m.a != 1 || m.b != 0 || m.c != 0 || m.d != 1) return false;
+    if (m.tx != std::floor(m.tx) || m.ty != std::floor(m.ty)) return false;
+    dx = (int)m.tx;
+    dy = (int)m.ty;
+    return true;
+}
+
+void ApplyPreviewTransform(Shape& s, const Affine2D& m) {
+    int dx, dy;
+    if (IsIntegerTranslation(m, dx, dy)) {
+        for (auto& p : s.vertices) {
+            p.x += dx;
+            p.y += dy;
+        }
+        ShapeExtra& e = EditShapeExtra(s);
+        e.rasterOffset.x += dx;
+        e.rasterOffset.y += dy;
         return;
     }
+    // 步号区间只在整数平移下不变
+    ResolveLineSteps(s);
+    if (s.type == DrawMode::DrawRectangle && (m.b != 0 || m.c != 0))
+        RectangleToPolygon(s, s.vertices);
+    AffineTransformPoints(m, s.vertices.data(), s.vertices.data(), s.vertices.size());
+    EditShapeExtra(s).rasterKey = 0;
+}
 
-    // 其他图形：直接对顶点旋转
-    double c = std::cos(angleRad);
-    double sn = std::sin(angleRad);
+bool TransformedShapeBounds(const Shape& s, const Affine2D& m, RECT& rc) {
+    RECT b;
+    if (!ShapeBounds(s, b)) return false;
+    Point corners[4] = { { (int)b.left, (int)b.top }, { (int)b.right, (int)b.top },
+        { (int)b.right, (int)b.bottom }, { (int)b.left, (int)b.bottom } };
+    AffineTransformPoints(m, corners, corners, 4);
+    rc = { corners[0].x, corners[0].y, corners[0].x, corners[0].y };
+    for (const Point& p : corners) {
+        rc.left = (std::min)(rc.left, (LONG)p.x);
+        rc.top = (std::min)(rc.top, (LONG)p.y);
+        rc.right = (std::max)(rc.right, (LONG)p.x);
+        rc.bottom = (std::max)(rc.bottom, (LONG)p.y);
+    }
+    // 顶点各自取整，圆的半径也由取整后的顶点重新算出，留 2 像素余量
+    rc.left -= 2;
+    rc.top -= 2;
+    rc.right += 2;
+    rc.bottom += 2;
+    return true;
+}
+
+void TranslateShape(Shape& s, int dx, int dy) {
+    // 整数平移直接移动顶点，与重算结果只可能差在 0.5 的舍入上；
+    // 保持顶点逐位平移，像素段缓存才能按偏移复用
     for (auto& p : s.vertices) {
-        double dx = p.x - center.x;
-        double dy = p.y - center.y;
-        double nx = dx * c - dy * sn;
-        double ny = dx * sn + dy * c;
-        p.x = (int)std::round(center.x + nx);
-        p.y = (int)std::round(center.y + ny);
+        p.x += dx;
+        p.y += dy;
     }
+    ShapeTransform* t = ShapeTransformOf(s);
+    bool tracked = t && t->xformRevision == s.revision;
+    TouchShapeTranslated(s, dx, dy);
+    if (tracked) {
+        t->xform = AffineCompose(AffineTranslate(dx, dy), t->xform);
+        t->xformRevision = s.revision;
+    }
+    else if (t) {
+        // 已经失效的累计状态不再有用
+        s.extra->transform.reset();
+    }
+}
+
+void ScaleShape(Shape& s, const Point& center, double sx, double sy) {
+    ComposeShapeTransform(s, AffineScale(center, sx, sy));
+    BakeShapeTransform(s);
+}
+
+void RotateShape(Shape& s, const Point& center, double angleRad) {
+    // 矩形总是转成多边形，与旋转角无关
+    ResolveLineSteps(s);
+    ShapeTransform& t = EnsureTransformBase(s);
+    if (s.type == DrawMode::DrawRectangle)
+        RectangleToPolygon(s, t.baseVertices);
+    t.xform = AffineCompose(AffineRotate(center, angleRad), t.xform);
+    BakeShapeTransform(s);
 }
 
 } // namespace GraphicsEngine
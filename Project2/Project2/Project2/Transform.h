@@ -1,6 +1,8 @@
 #pragma once
 
-#include "GraphicsEngine.h"
+#include <vector>
+#include "ShapeTypes.h"
+#include "AffineTransform.h"
 
 namespace GraphicsEngine {
 
@@ -8,4 +10,21 @@ void TranslateShape(Shape& s, int dx, int dy);
 void ScaleShape(Shape& s, const Point& center, double sx, double sy);
 void RotateShape(Shape& s, const Point& center, double angleRad);
 
+// 只把 m 复合进图形的累计变换，不重算顶点；之后必须调用 BakeShapeTransform
+// 矩形遇到带旋转 / 错切的 m 时转成 4 顶点多边形
+void ComposeShapeTransform(Shape& s, const Affine2D& m);
+// 按累计变换从 ShapeTransform::baseVertices 重新计算顶点
+void BakeShapeTransform(Shape& s);
+// 对一组图形施加同一个变换，各图形分到工作线程上并行处理；indices 不得重复
+// m 为整数平移时按 TranslateShape 处理，保留像素段缓存
+void TransformShapes(std::vector<Shape>& shapes, const std::vector<int>& indices, const Affine2D& m);
+
+// m 是否为整数平移
+bool IsIntegerTranslation(const Affine2D& m, int& dx, int& dy);
+// 把 m 直接作用在图形当前顶点上，不改版本号也不累计到 xform，用于拖动预览
+// 整数平移只改 rasterOffset，仍可复用像素段缓存；其他变换后不再对应任何缓存
+void ApplyPreviewTransform(Shape& s, const Affine2D& m);
+// 图形变换后的包围盒（同 ShapeBounds 的约定）：取原包围盒四角变换后的外包矩形，不必变换顶点
+bool TransformedShapeBounds(const Shape& s, const Affine2D& m, RECT& rc);
+
 } // namespace GraphicsEngine
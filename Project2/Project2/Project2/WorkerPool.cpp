@@ -0,0 +1,156 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GraphicsEngine {
+
+namespace {
+
+struct WorkerPool {
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::mutex submitMtx;               // 同一时刻只允许一个批次
+
+    const std::function<void(int)>* job = nullptr;
+    int jobCount = 0;
+    std::atomic<int> nextIndex{ 0 };
+    int busyWorkers = 0;
+    std::atomic<int> limit{ 0 };        // 参与批次的线程数上限（含调用线程），0 表示不限
+    unsigned generation = 0;
+    bool quit = false;
+};
+
+WorkerPool g_pool;
+std::once_flag g_poolOnce;
+thread_local bool t_inParallelFor = false;
+
+// 领取下标直到批次取空
+void RunJob(const std::function<void(int)>& fn, int count) {
+    for (;;) {
+        int i = g_pool.nextIndex.fetch_add(1);
+        if (i >= count) break;
+        fn(i);
+    }
+}
+
+// index 为工作线程序号，调用线程记为 0，工作线程从 1 开始
+void WorkerMain(int index) {
+    t_inParallelFor = true;
+    unsigned seen = 0;
+    for (;;) {
+        const std::function<void(int)>* fn;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(g_pool.mtx);
+            g_pool.wake.wait(lock, [&] { return g_pool.quit || g_pool.generation != seen; });
+            if (g_pool.quit) return;
+            seen = g_pool.generation;
+            if (!g_pool.job) continue;      // 醒得太晚，该批次已经结束
+            if (g_pool.limit > 0 && index >= g_pool.limit) continue;
+            fn = g_pool.job;
+            count = g_pool.jobCount;
+            g_pool.busyWorkers++;
+        }
+        RunJob(*fn, count);
+        {
+            std::lock_guard<std::mutex> lock(g_pool.mtx);
+            if (--g_pool.busyWorkers == 0)
+                g_pool.done.notify_all();
+        }
+    }
+}
+
+void StartPool() {
+    unsigned n = std::thread::hardware_concurrency();
+    if (n == 0) n = 1;
+    // 调用线程自己也干活，因此只需额外 n - 1 个线程
+    for (unsigned i = 1; i < n; ++i)
+        g_pool.threads.emplace_back(WorkerMain, (int)i);
+}
+
+} // namespace
+
+int WorkerThreadCount() {
+    std::call_once(g_poolOnce, StartPool);
+    int n = (int)g_pool.threads.size() + 1;
+    int limit = g_pool.limit;
+    return limit > 0 ? (std::min)(limit, n) : n;
+}
+
+void SetWorkerThreadLimit(int n) {
+    // 等正在执行的批次结束再改，批次内参与的线程数不变
+    std::lock_guard<std::mutex> submit(g_pool.submitMtx);
+    g_pool.limit = (std::max)(n, 0);
+}
+
+// 不值得或不能分发到线程池时返回 true
+static bool RunSerially(int count) {
+    std::call_once(g_poolOnce, StartPool);
+    return count == 1 || g_pool.threads.empty() || t_inParallelFor || g_pool.limit == 1;
+}
+
+// 分发一个批次并等待完成；调用方须持有 submitMtx
+static void RunBatch(int count, const std::function<void(int)>& fn) {
+    {
+        std::lock_guard<std::mutex> lock(g_pool.mtx);
+        if (g_pool.quit) {
+            for (int i = 0; i < count; ++i) fn(i);
+            return;
+        }
+        g_pool.job = &fn;
+        g_pool.jobCount = count;
+        g_pool.nextIndex.store(0);
+        g_pool.generation++;
+    }
+    g_pool.wake.notify_all();
+
+    t_inParallelFor = true;
+    RunJob(fn, count);
+    t_inParallelFor = false;
+
+    // 等待仍在执行的工作线程；没赶上本批次的线程领不到下标，不会再访问 fn
+    std::unique_lock<std::mutex> lock(g_pool.mtx);
+    g_pool.done.wait(lock, [] { return g_pool.busyWorkers == 0; });
+    g_pool.job = nullptr;
+}
+
+void ParallelFor(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) return;
+    if (RunSerially(count)) {
+        for (int i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    std::lock_guard<std::mutex> submit(g_pool.submitMtx);
+    RunBatch(count, fn);
+}
+
+void ParallelForIfIdle(int count, const std::function<void(int)>& fn) {
+    if (count <= 0) return;
+    std::unique_lock<std::mutex> submit;
+    if (!RunSerially(count))
+        submit = std::unique_lock<std::mutex>(g_pool.submitMtx, std::try_to_lock);
+    if (!submit.owns_lock()) {
+        for (int i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    RunBatch(count, fn);
+}
+
+void ShutdownWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(g_pool.mtx);
+        g_pool.quit = true;
+    }
+    g_pool.wake.notify_all();
+    for (auto& t : g_pool.threads)
+        if (t.joinable()) t.join();
+    g_pool.threads.clear();
+}
+
+} // namespace GraphicsEngine
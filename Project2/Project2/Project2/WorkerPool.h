@@ -0,0 +1,20 @@
+#pragma once
+
+#include <functional>
+
+namespace GraphicsEngine {
+
+// 常驻工作线程池：线程数为 CPU 核心数，首次使用时创建
+// 对 [0, count) 的每个下标调用 fn，调用线程也参与执行，全部完成后返回
+// fn 之间不得写同一块数据；嵌套调用时直接在当前线程串行执行
+void ParallelFor(int count, const std::function<void(int)>& fn);
+// 同上，但线程池正被其他线程占用（如渲染线程在画一整帧）时不等待，直接在调用线程上串行执行
+// 供 UI 线程使用，避免消息处理被渲染帧阻塞
+void ParallelForIfIdle(int count, const std::function<void(int)>& fn);
+// 实际参与并行的线程数（含调用线程）
+int WorkerThreadCount();
+// 限制参与批次的线程数（含调用线程），0 表示使用全部核心；测速按核心数对比时使用
+void SetWorkerThreadLimit(int n);
+void ShutdownWorkerPool();
+
+} // namespace GraphicsEngine
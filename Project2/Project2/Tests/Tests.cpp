@@ -0,0 +1,503 @@
+// 无窗口回归测试：在 HeapSurface 上比对新旧算法的像素结果
+// 用法：Tests [用例名 ...]，不带参数时运行全部用例；有失败时返回非零
+// Windows 下用 Tests.vcxproj 编译；Linux 下在本目录执行：
+//   g++ -std=c++14 -O2 -pthread -I../Project2 *.cpp ../Project2/{PixelSurface,DrawingPrimitives,Fill,
+//       Shapes,SpanFill,EdgeTable,Clip,LineClip,ShapeIndex,PolygonBoolean,WorkerPool,Transform,
+//       AffineTransform,CommandBuffer,ShapeStore,DamageRegion}.cpp -o tests
+
+#include "PixelSurface.h"
+#include "Fill.h"
+#include "Clip.h"
+#include "PolygonBoolean.h"
+#include "Transform.h"
+#include "CommandBuffer.h"
+#include "ShapeStore.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace GraphicsEngine {
+std::vector<Shape> g_shapes;
+ShapeIndex g_shapeIndex;
+}
+
+using namespace GraphicsEngine;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond, ...) \
+    do { \
+        if (!(cond)) { \
+            ++g_failures; \
+            printf("  FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+// 两块表面逐像素比较，返回不同像素数
+size_t CountDiff(const HeapSurface& a, const HeapSurface& b) {
+    size_t diff = 0;
+    for (size_t i = 0; i < a.pixels.size(); ++i)
+        if (a.pixels[i] != b.pixels[i]) ++diff;
+    return diff;
+}
+
+// ----- 栅栏填充：旧的逐像素异或 vs 按区间异或的 FenceXorRow -----
+// 旧实现（GetPixel / SetPixel 逐像素异或）原样移植到 PixelSurface 上作为参照
+void LegacyFenceRow(PixelSurface& surf, int y, int fenceX, const int* xs, size_t n, uint32_t px) {
+    for (size_t k = 0; k < n; ++k) {
+        int xEnd = xs[k];
+        if (xEnd < fenceX) continue;
+        for (int x = fenceX; x <= xEnd; ++x)
+            XorPixel(surf, x, y, px);
+    }
+}
+
+void LegacyFenceRect(PixelSurface& surf, const Point& p1, const Point& p2, COLORREF xorColor) {
+    int x1 = (std::min)(p1.x, p2.x), x2 = (std::max)(p1.x, p2.x);
+    int y1 = (std::min)(p1.y, p2.y), y2 = (std::max)(p1.y, p2.y);
+    int xs[2] = { x1, x2 };
+    for (int y = y1; y <= y2; ++y)
+        LegacyFenceRow(surf, y, x1 - 1, xs, 2, ColorToPixel(xorColor));
+}
+
+void LegacyFenceCircle(PixelSurface& surf, const Point& center, const Point& onCircle, COLORREF xorColor) {
+    int xc = center.x, yc = center.y;
+    int r = int(std::sqrt(double((onCircle.x - xc) * (onCircle.x - xc) +
+        (onCircle.y - yc) * (onCircle.y - yc))));
+    if (r <= 0) return;
+    for (int y = yc - r; y <= yc + r; ++y) {
+        int dy = y - yc;
+        int t = r * r - dy * dy;
+        if (t < 0) continue;
+        int dx = int(std::sqrt(double(t)));
+        int xs[2] = { xc - dx, xc + dx };
+        LegacyFenceRow(surf, y, xc - r - 1, xs, 2, ColorToPixel(xorColor));
+    }
+}
+
+// 交点取自与新实现相同的边表，只比较异或内核本身
+void LegacyFencePolygon(PixelSurface& surf, const std::vector<Point>& v, COLORREF xorColor) {
+    if (v.size() < 3) return;
+    int minX = v[0].x;
+    for (auto& p : v) minX = (std::min)(minX, p.x);
+
+    EdgeTable et;
+    AddContour(et, v.data(), v.size());
+    SortEdges(et);
+    RewindScan(et);
+    std::vector<EdgeCrossing> xs;
+    std::vector<int> ends;
+    int y;
+    while (NextScanline(et, y)) {
+        CollectCrossings(et, FillRule::EvenOdd, xs);
+        ends.clear();
+        for (auto& x : xs) ends.push_back(x.xFloor);
+        LegacyFenceRow(surf, y, minX - 1, ends.data(), ends.size(), ColorToPixel(xorColor));
+    }
+}
+
+void TestFenceFill() {
+    const int size = 256;
+    const COLORREF fill = RGB(40, 120, 200);
+    const COLORREF xorColor = FenceXorColor(fill);
+    std::mt19937 rng(7);
+    auto coord = [&] { return (int)(rng() % (size + 64)) - 32; };   // 允许越出表面，覆盖裁剪路径
+
+    HeapSurface expect, actual;
+    CreateHeapSurface(expect, size, size);
+    CreateHeapSurface(actual, size, size);
+    ClearSurface(expect.surface, RGB(255, 255, 255));
+    ClearSurface(actual.surface, RGB(255, 255, 255));
+
+    // 图形互相重叠，同一像素会被多次异或
+    int shapes = 0;
+    for (int i = 0; i < 200; ++i, ++shapes) {
+        Point a = { coord(), coord() }, b = { coord(), coord() };
+        LegacyFenceRect(expect.surface, a, b, xorColor);
+        FenceFillRect(actual.surface, a, b, xorColor);
+    }
+    size_t rectDiff = CountDiff(expect, actual);
+    CHECK(rectDiff == 0, "rect fence: %zu pixels differ", rectDiff);
+
+    for (int i = 0; i < 200; ++i, ++shapes) {
+        Point c = { coord(), coord() }, p = { c.x + (int)(rng() % 80), c.y + (int)(rng() % 80) };
+        LegacyFenceCircle(expect.surface, c, p, xorColor);
+        FenceFillCircle(actual.surface, c, p, xorColor);
+    }
+    size_t circleDiff = CountDiff(expect, actual);
+    CHECK(circleDiff == 0, "circle fence: %zu pixels differ", circleDiff);
+
+    // 多边形含自交、水平边和共线顶点
+    for (int i = 0; i < 200; ++i, ++shapes) {
+        std::vector<Point> v(3 + rng() % 12);
+        for (auto& p : v) p = { coord(), coord() };
+        if (i % 5 == 0) v[1].y = v[0].y;
+        LegacyFencePolygon(expect.surface, v, xorColor);
+        FenceFillPolygon(actual.surface, v, xorColor);
+    }
+    size_t polyDiff = CountDiff(expect, actual);
+    CHECK(polyDiff == 0, "polygon fence: %zu pixels differ", polyDiff);
+
+    printf("  %d overlapping shapes on %dx%d\n", shapes, size, size);
+}
+
+// ----- 中点分割直线裁剪：裁剪后的图形与原线段在框内画出的像素逐个相同 -----
+// 原线段平移 (dx, dy) 后画在裁剪框 r（右、下边界是闭的）内
+void DrawClippedOriginals(HeapSurface& hs, const std::vector<Shape>& lines, const RECT& r, int dx, int dy) {
+    ClearSurface(hs.surface, RGB(255, 255, 255));
+    SetSurfaceClip(hs.surface, { r.left + dx, r.top + dy, r.right + dx + 1, r.bottom + dy + 1 });
+    for (Shape s : lines) {
+        for (auto& p : s.vertices) {
+            p.x += dx;
+            p.y += dy;
+        }
+        DrawShapeBorder(hs.surface, s);
+    }
+    ResetSurfaceClip(hs.surface);
+}
+
+void DrawShapes(HeapSurface& hs, const std::vector<Shape>& shapes) {
+    ClearSurface(hs.surface, RGB(255, 255, 255));
+    for (const Shape& s : shapes) DrawShapeBorder(hs.surface, s);
+}
+
+void TestLineClip() {
+    const int size = 256;
+    const DrawMode modes[3] = { DrawMode::DrawLineMidpoint, DrawMode::DrawLineBresenham, DrawMode::DrawLineRunSlice };
+    std::mt19937 rng(11);
+    auto coord = [&] { return (int)(rng() % (size + 320)) - 160; };
+
+    // 三种算法各占三分之一，含水平、竖直与 45° 线段；颜色各不相同，顺序错乱也能查出
+    std::vector<Shape> lines(3000);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        Shape& s = lines[i];
+        s.type = modes[i % 3];
+        s.color = RGB(i % 251, (i / 251) % 251, 60);
+        Point a = { coord(), coord() }, b = { coord(), coord() };
+        if (i % 7 == 0) b.y = a.y;
+        if (i % 7 == 1) b.x = a.x;
+        if (i % 7 == 2) b.y = a.y + (b.x - a.x) * (rng() % 2 ? 1 : -1);
+        s.vertices.push_back(a);
+        s.vertices.push_back(b);
+    }
+    const RECT r1 = { 40, 30, 200, 220 }, r2 = { 90, 10, 250, 150 };
+    const RECT both = { 90, 30, 200, 150 };
+
+    HeapSurface expect, actual;
+    CreateHeapSurface(expect, size, size);
+    CreateHeapSurface(actual, size, size);
+
+    g_shapes = lines;
+    RebuildShapeIndex(g_shapeIndex, g_shapes);
+    ClipAllLines_Midpoint(r1);
+    int ranged = 0;
+    for (const Shape& s : g_shapes) {
+        ranged += ShapeLineSteps(s).last >= 0;
+        CHECK(s.vertices.size() == 2, "clipped line has %zu vertices", s.vertices.size());
+    }
+    DrawClippedOriginals(expect, lines, r1, 0, 0);
+    DrawShapes(actual, g_shapes);
+    size_t diff = CountDiff(expect, actual);
+    CHECK(diff == 0, "clip: %zu pixels differ", diff);
+    printf("  %zu lines, %zu visible, %d drawn as a step range\n", lines.size(), g_shapes.size(), ranged);
+
+    // 同一框再裁一次：什么都不变，版本号也不换
+    std::vector<unsigned long long> revisions;
+    for (const Shape& s : g_shapes) revisions.push_back(s.revision);
+    size_t before = g_shapes.size();
+    ClipAllLines_Midpoint(r1);
+    CHECK(g_shapes.size() == before, "re-clip dropped %zu lines", before - g_shapes.size());
+    int touched = 0;
+    for (size_t i = 0; i < g_shapes.size() && i < revisions.size(); ++i)
+        touched += g_shapes[i].revision != revisions[i];
+    CHECK(touched == 0, "re-clip touched %d lines", touched);
+
+    // 再用另一个框裁剪：在已有区间内继续收窄
+    ClipAllLines_Midpoint(r2);
+    DrawClippedOriginals(expect, lines, both, 0, 0);
+    DrawShapes(actual, g_shapes);
+    diff = CountDiff(expect, actual);
+    CHECK(diff == 0, "second clip: %zu pixels differ", diff);
+
+    // 整数平移保留区间
+    const int dx = 7, dy = -5;
+    for (Shape& s : g_shapes) TranslateShape(s, dx, dy);
+    RebuildShapeIndex(g_shapeIndex, g_shapes);
+    DrawClippedOriginals(expect, lines, both, dx, dy);
+    DrawShapes(actual, g_shapes);
+    diff = CountDiff(expect, actual);
+    CHECK(diff == 0, "translated: %zu pixels differ", diff);
+
+    // 命令缓冲重放
+    ShapeStore store;
+    BuildShapeStore(store, g_shapes);
+    CommandBuffer cb;
+    UpdateCommandBuffer(cb, store);
+    ClearSurface(actual.surface, RGB(255, 255, 255));
+    ReplayCommands(actual.surface, cb);
+    diff = CountDiff(expect, actual);
+    CHECK(diff == 0, "command replay: %zu pixels differ", diff);
+
+    // 点选与包围盒只看可见部分
+    for (const Shape& s : g_shapes) {
+        Point a, b;
+        LineVisibleEnds(s, a, b);
+        RECT rc;
+        ShapeBounds(s, rc);
+        CHECK(rc.left >= both.left + dx - 1 && rc.right <= both.right + dx + 2 &&
+            rc.top >= both.top + dy - 1 && rc.bottom <= both.bottom + dy + 2,
+            "bounds (%ld,%ld)-(%ld,%ld) outside the clip box", (long)rc.left, (long)rc.top, (long)rc.right, (long)rc.bottom);
+        CHECK(PointInShape(s, a.x, a.y) && PointInShape(s, b.x, b.y), "visible end not hit");
+    }
+
+    g_shapes.clear();
+    ResetShapeIndex(g_shapeIndex);
+}
+
+// ----- 圆与圆弧裁剪：同一框再裁一次，圆弧不变，版本号也不换 -----
+void TestArcReclip() {
+    std::mt19937 rng(5);
+    g_shapes.clear();
+    for (int i = 0; i < 2000; ++i) {
+        Shape s;
+        s.type = i % 2 ? DrawMode::DrawCircleMidpoint : DrawMode::DrawCircleBresenham;
+        s.color = RGB(0, 0, 0);
+        s.fillMode = 0;
+        Point c = { (int)(rng() % 1024), (int)(rng() % 1024) };
+        s.vertices.push_back(c);
+        s.vertices.push_back({ c.x + 10 + (int)(rng() % 300), c.y + (int)(rng() % 100) });
+        TouchShape(s);
+        g_shapes.push_back(s);
+    }
+    RebuildShapeIndex(g_shapeIndex, g_shapes);
+    const RECT clip = { 200, 150, 800, 900 };
+    ClipAllCurves(clip);
+
+    std::vector<Shape> first = g_shapes;
+    int arcs = 0;
+    for (const Shape& s : first) arcs += s.type == DrawMode::DrawArc;
+    ClipAllCurves(clip);
+    CHECK(g_shapes.size() == first.size(), "re-clip kept %zu of %zu shapes", g_shapes.size(), first.size());
+    int touched = 0, moved = 0;
+    for (size_t i = 0; i < g_shapes.size() && i < first.size(); ++i) {
+        const Shape& a = first[i];
+        const Shape& b = g_shapes[i];
+        touched += a.revision != b.revision;
+        bool same = a.vertices.size() == b.vertices.size();
+        for (size_t k = 0; same && k < a.vertices.size(); ++k)
+            same = a.vertices[k].x == b.vertices[k].x && a.vertices[k].y == b.vertices[k].y;
+        moved += !same;
+    }
+    CHECK(touched == 0, "re-clip touched %d of %d arcs", touched, arcs);
+    CHECK(moved == 0, "re-clip moved the ends of %d arcs", moved);
+    printf("  %zu circles, %d arcs after clipping\n", (size_t)2000, arcs);
+
+    g_shapes.clear();
+    ResetShapeIndex(g_shapeIndex);
+}
+
+// ----- 填充的圆：线裁剪不动它，多边形裁剪把框内部分换成填充的多边形 -----
+Shape MakeFilledCircle(int xc, int yc, int r, int fillMode) {
+    Shape s;
+    s.type = DrawMode::DrawCircleMidpoint;
+    s.color = RGB(0, 0, 0);
+    s.fillColor = RGB(255, 0, 0);
+    s.fillMode = fillMode;
+    s.vertices.push_back({ xc, yc });
+    s.vertices.push_back({ xc + r, yc });
+    TouchShape(s);
+    return s;
+}
+
+// 框内的填充像素：原来的圆限制在框内填充，与裁剪结果直接填充相比
+size_t FillDiffInClip(const Shape& before, const Shape& after, const RECT& clip, size_t& area) {
+    HeapSurface expect, actual;
+    CreateHeapSurface(expect, 1024, 1024);
+    CreateHeapSurface(actual, 1024, 1024);
+    ClearSurface(expect.surface, RGB(255, 255, 255));
+    ClearSurface(actual.surface, RGB(255, 255, 255));
+    SetSurfaceClip(expect.surface, { clip.left, clip.top, clip.right + 1, clip.bottom + 1 });
+    FillShapeScanline(expect.surface, before, before.fillColor);
+    FillShapeScanline(actual.surface, after, after.fillColor);
+    area = 0;
+    for (uint32_t p : expect.pixels) area += p != ColorToPixel(RGB(255, 255, 255));
+    return CountDiff(expect, actual);
+}
+
+void TestFilledCircleClip() {
+    const RECT clip = { 200, 150, 800, 900 };
+    const Shape crossing = MakeFilledCircle(220, 500, 150, 1);
+    const Shape outside = MakeFilledCircle(80, 80, 40, 2);
+    const Shape inside = MakeFilledCircle(500, 500, 100, 1);
+    Shape stroke = MakeFilledCircle(780, 500, 100, 0);
+    auto reset = [&]() {
+        g_shapes = { crossing, outside, inside, stroke };
+        RebuildShapeIndex(g_shapeIndex, g_shapes);
+    };
+
+    // 线裁剪模式只裁描边：填充的圆原样保留，未填充的圆换成圆弧
+    reset();
+    ClipAllCurves(clip);
+    CHECK(g_shapes.size() == 4, "curve clip kept %zu of 4 shapes", g_shapes.size());
+    if (g_shapes.size() == 4) {
+        for (int i = 0; i < 3; ++i)
+            CHECK(g_shapes[i].revision == (i == 0 ? crossing : i == 1 ? outside : inside).revision &&
+                g_shapes[i].fillMode != 0, "curve clip touched filled circle %d", i);
+        CHECK(g_shapes[3].type == DrawMode::DrawArc, "unfilled circle not clipped to an arc");
+    }
+
+    // 多边形裁剪：框外的删去，框内的不动，跨边界的换成框内的填充多边形
+    void (*const rectClips[])(const RECT&) = { ClipAllPolygons_SH, ClipAllPolygons_WA };
+    for (int k = 0; k < 3; ++k) {
+        reset();
+        if (k < 2) rectClips[k](clip);
+        else ClipAllPolygons_Window({ { clip.left, clip.top }, { clip.right, clip.top },
+            { clip.right, clip.bottom }, { clip.left, clip.bottom } });
+        CHECK(g_shapes.size() == 3, "pass %d kept %zu of 4 shapes", k, g_shapes.size());
+        if (g_shapes.size() != 3) continue;
+        const Shape& a = g_shapes[0];
+        CHECK(a.type == DrawMode::DrawPolygon && a.fillMode == crossing.fillMode &&
+            a.fillColor == crossing.fillColor, "pass %d: crossing circle lost its fill", k);
+        size_t area;
+        size_t diff = FillDiffInClip(crossing, a, clip, area);
+        CHECK(area > 0 && diff * 50 < area, "pass %d: %zu of %zu fill pixels differ", k, diff, area);
+        if (k < 2)
+            CHECK(g_shapes[1].revision == inside.revision, "pass %d touched the inner circle", k);
+        CHECK(g_shapes[1].fillMode == inside.fillMode, "pass %d: inner circle lost its fill", k);
+        CHECK(g_shapes[2].revision == stroke.revision, "pass %d touched the unfilled circle", k);
+        if (k == 0) printf("  crossing circle: %zu of %zu fill pixels differ\n", diff, area);
+    }
+
+    g_shapes.clear();
+    ResetShapeIndex(g_shapeIndex);
+}
+
+// ----- 多边形布尔运算：随机轮廓，离边较远的采样点与逐点判定比对 -----
+typedef std::vector<std::vector<Point>> Contours;
+
+// 点 (x, y) 处的环绕数
+int WindingAt(const Contours& cs, double x, double y) {
+    int w = 0;
+    for (const auto& c : cs) {
+        for (size_t i = 0; i < c.size(); ++i) {
+            const Point& a = c[i];
+            const Point& b = c[(i + 1) % c.size()];
+            if ((a.y <= y) == (b.y <= y)) continue;
+            double cross = (b.x - a.x) * (y - a.y) - (x - a.x) * (b.y - a.y);
+            if (b.y > a.y ? cross > 0 : cross < 0) w += b.y > a.y ? 1 : -1;
+        }
+    }
+    return w;
+}
+
+bool InsideByRule(const Contours& cs, FillRule rule, double x, double y) {
+    int w = WindingAt(cs, x, y);
+    return rule == FillRule::NonZero ? w != 0 : (w & 1) != 0;
+}
+
+// 点到各条边的最短距离
+double DistanceToEdges(const Contours& cs, double x, double y) {
+    double best = 1e300;
+    for (const auto& c : cs) {
+        for (size_t i = 0; i < c.size(); ++i) {
+            double ax = c[i].x, ay = c[i].y;
+            double bx = c[(i + 1) % c.size()].x, by = c[(i + 1) % c.size()].y;
+            double ex = bx - ax, ey = by - ay, len2 = ex * ex + ey * ey;
+            double t = len2 > 0 ? (std::max)(0.0, (std::min)(1.0, ((x - ax) * ex + (y - ay) * ey) / len2)) : 0;
+            double dx = ax + ex * t - x, dy = ay + ey * t - y;
+            best = (std::min)(best, dx * dx + dy * dy);
+        }
+    }
+    return std::sqrt(best);
+}
+
+Contours RandomContours(std::mt19937& rng) {
+    Contours cs(1 + rng() % 2);
+    for (auto& c : cs) {
+        c.resize(3 + rng() % 6);
+        for (Point& p : c) p = { (int)(rng() % 200), (int)(rng() % 200) };
+    }
+    return cs;
+}
+
+void TestPolygonBoolean() {
+    // 交点取整后结果的边最多偏开不到 1 个像素，只比较离输入各边 2 个像素以外的点
+    const double MARGIN = 2.0;
+    const FillRule rules[] = { FillRule::EvenOdd, FillRule::NonZero };
+    const BooleanOp ops[] = { BooleanOp::Intersection, BooleanOp::Union, BooleanOp::Difference, BooleanOp::Xor };
+    std::mt19937 rng(22);
+    Contours out;
+    int cases = 0, samples = 0, mismatches = 0;
+    for (int iter = 0; iter < 300; ++iter) {
+        Contours a = RandomContours(rng), b = RandomContours(rng);
+        for (FillRule rule : rules) {
+            for (BooleanOp op : ops) {
+                PolygonBoolean(a, rule, b, rule, op, out);
+                ++cases;
+                int bad = 0;
+                for (int k = 0; k < 64; ++k) {
+                    double x = (rng() % 4000) / 20.0 + 0.025, y = (rng() % 4000) / 20.0 + 0.025;
+                    if (DistanceToEdges(a, x, y) < MARGIN || DistanceToEdges(b, x, y) < MARGIN) continue;
+                    bool ia = InsideByRule(a, rule, x, y), ib = InsideByRule(b, rule, x, y);
+                    bool expect = op == BooleanOp::Intersection ? ia && ib :
+                        op == BooleanOp::Union ? ia || ib :
+                        op == BooleanOp::Difference ? ia && !ib : ia != ib;
+                    ++samples;
+                    bad += InsideByRule(out, FillRule::EvenOdd, x, y) != expect;
+                }
+                if (bad && !mismatches)
+                    CHECK(false, "case %d (rule %d, op %d): %d samples disagree", cases, (int)rule, (int)op, bad);
+                mismatches += bad;
+            }
+        }
+    }
+    CHECK(mismatches == 0, "%d of %d samples disagree", mismatches, samples);
+    printf("  %d cases, %d samples away from edges\n", cases, samples);
+}
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+const TestCase CASES[] = {
+    { "fence", TestFenceFill },
+    { "lineclip", TestLineClip },
+    { "arcclip", TestArcReclip },
+    { "fillclip", TestFilledCircleClip },
+    { "polybool", TestPolygonBoolean },
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int ran = 0;
+    for (const TestCase& c : CASES) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            if (std::strcmp(argv[i], c.name) == 0) selected = true;
+        if (!selected) continue;
+        int before = g_failures;
+        printf("%s\n", c.name);
+        c.run();
+        printf("  %s\n", g_failures == before ? "ok" : "FAILED");
+        ++ran;
+    }
+    if (!ran) {
+        printf("usage: Tests [case ...]\ncases:");
+        for (const TestCase& c : CASES) printf(" %s", c.name);
+        printf("\n");
+        return 1;
+    }
+    ShutdownWorkerPool();
+    printf("%d case(s), %d failure(s)\n", ran, g_failures);
+    return g_failures ? 1 : 0;
+}